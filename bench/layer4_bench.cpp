@@ -0,0 +1,211 @@
+// ========================== Nguyen Hien ==========================
+// FILE: bench/layer4_bench.cpp (Layer4Hybrid microbenchmarks)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+// Run:      ./face_bench
+// Enforce:  FACE_BENCH_ENFORCE=1 ./face_bench          (fails when over budget)
+// Slow box: FACE_BENCH_BUDGET_SCALE=2.0 FACE_BENCH_ENFORCE=1 ./face_bench
+// Heap:     cmake -DALLOC_DEBUG=ON, BM_analyzeQualityArena reports heap_allocs (gate: ctest alloc_steady_state)
+// =================================================================
+#include <benchmark/benchmark.h>
+#include <opencv2/opencv.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "layer4_hybrid.h"
+#include "task_pool.h"
+#include "frame_arena.h"
+
+class Layer4Bench {
+public:
+    static float colorStats(Layer4Hybrid& l4, const cv::Mat& roi) {
+        computeColorStats(roi, l4.colorStats);
+        return l4.colorStats.meanY;
+    }
+    static float skin(Layer4Hybrid& l4, const cv::Mat& roi) {
+        float score = 0.0f;
+        computeColorStats(roi, l4.colorStats);
+        l4.checkSkinConsistency(l4.colorStats, score);
+        return score;
+    }
+    static float texture(Layer4Hybrid& l4, const cv::Mat& roi) { return l4.analyzeTextureGradient(roi); }
+    static float colorTemp(Layer4Hybrid& l4, const cv::Mat& roi) {
+        computeColorStats(roi, l4.colorStats);
+        return l4.analyzeColorTemperature(l4.colorStats);
+    }
+    static float screenEdges(Layer4Hybrid& l4, const cv::Mat& roi) { return l4.detectScreenEdges(roi); }
+    static float highFrequency(Layer4Hybrid& l4, const cv::Mat& roi) { return (float)l4.calculateHighFrequency(roi); }
+    static float moire(Layer4Hybrid& l4, const cv::Mat& roi) { return l4.detectMoirePattern(roi); }
+};
+
+namespace {
+// Regression budget in microseconds per call, one column per ROI side (64, 128, 256, 512)
+struct Budget {
+    const char* name;
+    double us[4];
+};
+
+const Budget budgets[] = {
+    {"colorStats",    {   15,   25,   40,    80}},
+    {"skin",          {   20,   30,   50,   100}},
+    {"texture",       {   40,  150,  600,  2500}},
+    {"colorTemp",     {   20,   30,   50,   100}},
+    {"screenEdges",   {  250,  250,  300,   500}},
+    {"highFrequency", {  300,  300,  350,   500}},
+    {"moire",         {  150,  150,  200,   300}},
+    {"analyzeQuality",{ 1500, 1800, 2500,  5000}},
+    {"analyzeQualityArena",{ 1500, 1800, 2500,  5000}},
+};
+
+int sizeColumn(int side) {
+    if (side <= 64) return 0;
+    if (side <= 128) return 1;
+    if (side <= 256) return 2;
+    return 3;
+}
+
+double budgetFor(const char* name, int side) {
+    double scale = 1.0;
+    if (const char* env = std::getenv("FACE_BENCH_BUDGET_SCALE")) scale = std::atof(env);
+    for (const Budget& b : budgets) {
+        if (std::strcmp(b.name, name) == 0) return b.us[sizeColumn(side)] * scale;
+    }
+    return 0.0;
+}
+
+bool enforceBudgets() {
+    const char* env = std::getenv("FACE_BENCH_ENFORCE");
+    return env && env[0] == '1';
+}
+
+// Deterministic face-like BGR patch: skin tone, soft shading, noise and a few features
+cv::Mat makeFace(int side) {
+    cv::Mat face(side, side, CV_8UC3, cv::Scalar(120, 150, 200));
+    for (int y = 0; y < side; ++y) {
+        cv::Vec3b* row = face.ptr<cv::Vec3b>(y);
+        for (int x = 0; x < side; ++x) {
+            int shade = (x + y) * 40 / (2 * side) - 20;
+            for (int c = 0; c < 3; ++c) row[x][c] = cv::saturate_cast<uchar>(row[x][c] + shade);
+        }
+    }
+    cv::ellipse(face, cv::Point(side * 3 / 10, side * 2 / 5), cv::Size(side / 12, side / 20), 0, 0, 360, cv::Scalar(60, 50, 50), -1);
+    cv::ellipse(face, cv::Point(side * 7 / 10, side * 2 / 5), cv::Size(side / 12, side / 20), 0, 0, 360, cv::Scalar(60, 50, 50), -1);
+    cv::ellipse(face, cv::Point(side / 2, side * 3 / 4), cv::Size(side / 6, side / 25), 0, 0, 360, cv::Scalar(90, 90, 170), -1);
+
+    cv::Mat noise(face.size(), CV_8UC3);
+    cv::RNG rng(12345);
+    rng.fill(noise, cv::RNG::NORMAL, cv::Scalar::all(0), cv::Scalar::all(6));
+    cv::add(face, noise, face, cv::noArray(), CV_8UC3);
+    return face;
+}
+
+// Center crop analyzeQuality hands to the moire / DFT probes
+cv::Mat centerCrop(const cv::Mat& face) {
+    int side = face.cols / 2;
+    return face(cv::Rect((face.cols - side) / 2, (face.rows - side) / 2, side, side));
+}
+
+template <typename Fn>
+void timeCalls(benchmark::State& state, const char* name, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fn());
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    double perCall = state.iterations() > 0 ? us / state.iterations() : 0.0;
+    double budget = budgetFor(name, (int)state.range(0));
+
+    state.counters["us_per_call"] = perCall;
+    state.counters["budget_us"] = budget;
+    if (enforceBudgets() && budget > 0.0 && perCall > budget) {
+        std::string msg = std::string(name) + " over budget: " + std::to_string(perCall) +
+                          " us > " + std::to_string(budget) + " us";
+        state.SkipWithError(msg.c_str());
+    }
+}
+
+#define FACE_EXTRACTOR_BENCH(NAME, CROP)                                         \
+    void BM_##NAME(benchmark::State& state) {                                    \
+        Layer4Hybrid l4;                                                         \
+        cv::Mat face = makeFace((int)state.range(0));                            \
+        cv::Mat roi = CROP;                                                      \
+        timeCalls(state, #NAME, [&] { return Layer4Bench::NAME(l4, roi); });     \
+    }                                                                            \
+    BENCHMARK(BM_##NAME)->RangeMultiplier(2)->Range(64, 512)->Unit(benchmark::kMicrosecond)
+
+FACE_EXTRACTOR_BENCH(colorStats, face);
+FACE_EXTRACTOR_BENCH(skin, face);
+FACE_EXTRACTOR_BENCH(texture, face);
+FACE_EXTRACTOR_BENCH(colorTemp, face);
+FACE_EXTRACTOR_BENCH(screenEdges, face);
+FACE_EXTRACTOR_BENCH(highFrequency, centerCrop(face));
+FACE_EXTRACTOR_BENCH(moire, centerCrop(face));
+
+// Whole call on a 1280x720 frame, face of the given side in the middle
+void BM_analyzeQuality(benchmark::State& state) {
+    Layer4Hybrid l4;
+    int side = (int)state.range(0);
+    cv::Mat frame(720, 1280, CV_8UC3, cv::Scalar(40, 40, 40));
+    cv::Rect box((frame.cols - side) / 2, (frame.rows - side) / 2, side, side);
+    makeFace(side).copyTo(frame(box));
+    timeCalls(state, "analyzeQuality", [&] { return l4.analyzeQuality(frame, box); });
+}
+BENCHMARK(BM_analyzeQuality)->RangeMultiplier(2)->Range(64, 512)->Unit(benchmark::kMicrosecond);
+
+// Same call with every scratch Mat in a frame arena, rewound after each call
+void BM_analyzeQualityArena(benchmark::State& state) {
+    Layer4Hybrid l4;
+    FrameArena arena;
+    l4.bindScratch(arena);
+    int side = (int)state.range(0);
+    cv::Mat frame(720, 1280, CV_8UC3, cv::Scalar(40, 40, 40));
+    cv::Rect box((frame.cols - side) / 2, (frame.rows - side) / 2, side, side);
+    makeFace(side).copyTo(frame(box));
+
+    if (AllocationCounter::enabled()) AllocationCounter::install();
+    // Warm-up: spectral tables and vector capacities are sized once, outside the arena
+    for (int i = 0; i < 3; ++i) {
+        l4.analyzeQuality(frame, box);
+        arena.reset();
+    }
+    uint64_t allocs = 0;
+    timeCalls(state, "analyzeQualityArena", [&] {
+        const uint64_t before = AllocationCounter::count();
+        float score = l4.analyzeQuality(frame, box);
+        arena.reset();
+        allocs += AllocationCounter::count() - before;
+        return score;
+    });
+
+    state.counters["heap_allocs"] = (double)allocs;
+    state.counters["arena_kib"] = (double)arena.getHighWater() / 1024.0;
+}
+BENCHMARK(BM_analyzeQualityArena)->RangeMultiplier(2)->Range(64, 512)->Unit(benchmark::kMicrosecond);
+
+// Same call with the five cues as parallel tasks (prepare -> cues -> fuse)
+void runCueTask(void* l4, int cue) { static_cast<Layer4Hybrid*>(l4)->runCue(cue); }
+
+void BM_analyzeQualityParallel(benchmark::State& state) {
+    static WorkStealingPool pool;
+    Layer4Hybrid l4;
+    TaskGraph graph;
+    int side = (int)state.range(0);
+    cv::Mat frame(720, 1280, CV_8UC3, cv::Scalar(40, 40, 40));
+    cv::Rect box((frame.cols - side) / 2, (frame.rows - side) / 2, side, side);
+    makeFace(side).copyTo(frame(box));
+    VideoFrame video;
+    video.setBGR(frame);
+    timeCalls(state, "analyzeQualityParallel", [&] {
+        if (!l4.prepareCues(video, box)) return -0.5f;
+        graph.clear();
+        for (int cue = 0; cue < Layer4Hybrid::CUE_COUNT; ++cue) graph.add(&runCueTask, &l4, cue);
+        graph.run(pool);
+        return l4.fuseCues();
+    });
+}
+BENCHMARK(BM_analyzeQualityParallel)->RangeMultiplier(2)->Range(64, 512)->Unit(benchmark::kMicrosecond)->UseRealTime();
+}
+
+BENCHMARK_MAIN();
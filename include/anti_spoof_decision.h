@@ -0,0 +1,59 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/anti_spoof_decision.h (REAL/FAKE state machine)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include "decision_params.h"
+
+enum class DecisionState {
+    ANALYZING,
+    REAL,
+    FAKE,
+    TOO_FAR
+};
+
+const char* decisionStateName(DecisionState state);
+
+struct DecisionOutput {
+    DecisionState state;
+    float finalScore;
+    int realStreak;     // consecutive real-looking frames (REAL needs DecisionParams::confirmFrames)
+    int spoofStreak;
+};
+
+class AntiSpoofDecision {
+public:
+    AntiSpoofDecision();
+
+    // Fuse Layer3 (smoothed + raw) and Layer4 adjustment into one decision;
+    // pass the snapshot the two layers scored under
+    DecisionOutput update(float livenessScore, float rawScore, float adjustment,
+                          const DecisionParams& p = DecisionParams::current());
+    // Frame without any Layer3 score (cascade exit on the cues alone): only a
+    // strong fake that holds for every liveness score counts as a spoof frame;
+    // the drop logic and the last real score are left alone. finalScore is the
+    // best fusion any liveness could reach.
+    DecisionOutput updateWithoutLiveness(float adjustment,
+                                         const DecisionParams& p = DecisionParams::current());
+
+    // Score fusion and the strong verdicts of update(), without history. Both verdicts
+    // are monotonic in livenessScore and adjustment, so the cascade can test bounds.
+    // Thresholds from p (default: the active DecisionParams).
+    static float fuseScore(float livenessScore, float adjustment,
+                           const DecisionParams& p = DecisionParams::current());
+    static bool isStrongReal(float livenessScore, float adjustment,
+                             const DecisionParams& p = DecisionParams::current());
+    static bool isStrongFake(float livenessScore, float adjustment,
+                             const DecisionParams& p = DecisionParams::current());
+
+    void reset();
+    void manualReset();
+
+private:
+    int realConsecutive;
+    int spoofConsecutive;
+    float lastRealScore;
+    int suddenDropCount;
+    float confidenceAccumulator;
+};
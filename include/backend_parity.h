@@ -0,0 +1,23 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/backend_parity.h (Backend / INT8 accuracy gate)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <string>
+#include <vector>
+#include "inference_backend.h"
+#include "layer3_liveness.h"
+
+struct ParityConfig {
+    std::string inputPath;          // video file, image directory or manifest (as --offline)
+    std::string detectorPath;
+    std::vector<LivenessModelSpec> models;
+    BackendOptions candidate;       // compared against OpenCV DNN, FP32
+    float tolerance = 0.05f;        // max allowed mean |score difference|
+    long maxFrames = 300;
+};
+
+// Runs the FP32 OpenCV reference and the candidate backend on the same faces, prints
+// score drift, decision flips and per-face latency. Returns 0 when within tolerance.
+int runBackendParity(const ParityConfig& config);
@@ -0,0 +1,96 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/cascade_scheduler.h (Early-exit stage cascade)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "layer4_hybrid.h"
+#include "anti_spoof_decision.h"
+
+enum class CascadeStage {
+    CHEAP_CUES,   // colour stats + screen edges (~50 us)
+    LIVENESS,     // MiniFASNet ensemble (ms)
+    DEEP_CUES     // texture + moire + DFT
+};
+
+struct CascadeConfig {
+    bool enabled = false;
+    // Cheapest / most decisive first: colour+edges can already prove a spoof,
+    // MiniFASNet proves most spoofs, the deep cues are needed to confirm REAL
+    std::vector<CascadeStage> order = {CascadeStage::CHEAP_CUES, CascadeStage::LIVENESS,
+                                       CascadeStage::DEEP_CUES};
+    // REAL tracks: full check every K frames, cheap cues + last Layer3 / deep cues in between
+    int reverifyInterval = 5;
+};
+
+// "cheap,liveness,deep" -> order, false on an unknown or repeated name
+bool parseCascadeOrder(const std::string& text, std::vector<CascadeStage>& order);
+
+// What the cascade remembers of one track (lives in TrackState)
+struct CascadeTrackState {
+    bool hasLiveness = false;
+    float livenessScore = -1.0f;   // last Layer3 result, -1 until hasLiveness
+    float rawScore = -1.0f;
+    bool hasDeep = false;
+    float texture = 0.0f;
+    float moire = 0.0f;
+    double highFrequency = 0.0;
+    int framesSinceFull = 0;
+    DecisionState lastState = DecisionState::ANALYZING;
+
+    void reset() { *this = CascadeTrackState(); }
+};
+
+// Bumped by the analysing thread, printed by the supervisor: relaxed atomics
+struct CascadeStats {
+    std::atomic<uint64_t> faces{0};
+    std::atomic<uint64_t> livenessRuns{0};
+    std::atomic<uint64_t> deepRuns{0};
+    std::atomic<uint64_t> earlyExits{0};      // decided before the last stage
+    std::atomic<uint64_t> lightFrames{0};     // REAL track kept on cheap cues
+    std::atomic<uint64_t> escalations{0};     // light check failed, full run instead
+
+    static void add(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+        counter.fetch_add(n, std::memory_order_relaxed);
+    }
+};
+
+enum class CascadeVerdict {
+    OPEN,
+    REAL,     // update() would see a strong real whatever the remaining stages say
+    FAKE      // same for a strong fake
+};
+
+// Certainty tests only; FrameAnalyzer runs the stages in config order
+class CascadeScheduler {
+public:
+    void setConfig(const CascadeConfig& cfg) { config = cfg; }
+    const CascadeConfig& getConfig() const { return config; }
+    bool isEnabled() const { return config.enabled; }
+
+    static unsigned stageCues(CascadeStage stage);
+    static unsigned allCues() { return (1u << Layer4Hybrid::CUE_COUNT) - 1; }
+
+    // Known cues + Layer3 (or its whole [0, 1] range) -> verdict; decisive
+    // adjustment for update() (bound that keeps the same verdict) in exitAdjustment
+    CascadeVerdict check(const QualityCues& cues, unsigned knownMask, bool hasLiveness,
+                         float livenessScore, float& exitAdjustment,
+                         const DecisionParams& p = DecisionParams::current()) const;
+    // REAL track between re-verifications with everything cached
+    bool mayRunLight(const CascadeTrackState& track) const;
+    // Fresh cheap cues + cached Layer3 / deep cues, true when still a strong real
+    bool checkLight(const CascadeTrackState& track, QualityCues& cues, float& adjustment,
+                    const DecisionParams& p = DecisionParams::current()) const;
+
+    CascadeStats& stats() { return counters; }
+    const CascadeStats& stats() const { return counters; }
+    void printStats(const char* tag) const;
+
+private:
+    CascadeConfig config;
+    CascadeStats counters;
+};
@@ -0,0 +1,25 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/color_stats.h (Fused colour statistics kernel)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <opencv2/opencv.hpp>
+
+// Everything Layer4 needs about the colour of a face, from one pass over the ROI
+struct ColorStats {
+    float meanY = 0, minY = 0, maxY = 0;   // luma, OpenCV YCrCb coefficients
+    float meanCr = 0, meanCb = 0;
+    float meanSat = 0;                     // HSV saturation, 0..255
+    float meanB = 0, meanG = 0, meanR = 0;
+    int samples = 0;
+};
+
+// Single SIMD pass over a BGR ROI (no resize, no YCrCb/HSV images).
+// The ROI is read on a grid x grid lattice with the taps of the INTER_LINEAR
+// resize the skin check used to run (64x64), so min/max Y and saturation see
+// the same filtered pixels the thresholds were tuned on.
+bool computeColorStats(const cv::Mat& bgr, ColorStats& out, int grid = 64);
+// Same statistics straight from a YUYV ROI (even width); only the source rows
+// of the grid are expanded to BGR, into rowScratch, so both paths share the thresholds
+bool computeColorStatsYUYV(const cv::Mat& yuyv, ColorStats& out, cv::Mat& rowScratch, int grid = 64);
@@ -0,0 +1,141 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/decision_events.h (Decision event stream + async sink)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "frame_analyzer.h"
+
+// One decision of one face on one frame. Fixed size, no heap: it is copied
+// through the ring as is and is the record format of the shared memory ring.
+struct DecisionEvent {
+    uint64_t seq;                 // frame sequence of the source
+    int64_t timestampUs;          // system_clock, unix epoch
+    int64_t latencyUs;            // capture -> decision, -1 = unknown
+    int32_t streamId;             // --stream index, -1 = single source
+    int32_t trackId;
+    int32_t x, y, w, h;
+    int32_t state;                // DecisionState
+    uint32_t cueMask;             // Layer4 cues measured on this frame
+    float rawScore;               // Layer3 fused model output
+    float livenessScore;          // Layer3 smoothed
+    float adjustment;             // Layer4, clamped
+    float finalScore;
+    float cueAdjustment[Layer4Hybrid::CUE_COUNT];   // color, texture, edges, moire, high_freq
+};
+static_assert(std::is_trivially_copyable<DecisionEvent>::value, "DecisionEvent goes through memcpy");
+
+// ===== Shared memory layout (/dev/shm/<name>) =====
+// Header at byte 0, slotCount slots of slotSize bytes from byte 64.
+// Event n lives in slot n % slotCount.
+// Writer: sequence = 2n+1, event, sequence = 2n+2, writeIndex = n+1.
+// Reader: s1 = sequence, copy event, s2 = sequence; valid when s1 == s2 == 2n+2,
+// otherwise the slot was overwritten while reading (reader fell behind).
+constexpr uint32_t DECISION_SHM_MAGIC = 0x56454446;   // "FDEV"
+constexpr uint32_t DECISION_SHM_VERSION = 1;
+
+struct DecisionShmHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t slotSize;
+    std::atomic<uint64_t> writeIndex;
+};
+
+struct DecisionShmSlot {
+    std::atomic<uint64_t> sequence;
+    DecisionEvent event;
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shm ring needs lock-free 64-bit atomics");
+
+struct DecisionSinkConfig {
+    std::string jsonlPath;       // one JSON object per line, "-" = stdout (see detachStdout())
+    int stdoutFd = -1;           // "-" writes here when set (detachStdout()), else to stdout
+    std::string socketPath;      // Unix stream socket, every connected client gets the JSONL lines
+    std::string shmName;         // POSIX shared memory ring of DecisionEvent records ("/face_events")
+    size_t capacity = 4096;      // events in flight, full = event dropped (counted)
+    size_t shmSlots = 1024;
+
+    bool enabled() const { return !jsonlPath.empty() || !socketPath.empty() || !shmName.empty(); }
+};
+
+// publish() is lock-free and never waits (any number of producer threads):
+// a bounded ring hands events to one writer thread that formats and writes
+// them. A socket client that cannot keep up is disconnected, not waited for.
+class DecisionEventSink {
+public:
+    DecisionEventSink();
+    ~DecisionEventSink();
+
+    bool init(const DecisionSinkConfig& config);
+    // Drains what is queued, then stops the writer and closes every output
+    void close();
+    bool isOpen() const { return running.load(std::memory_order_acquire); }
+
+    // False = ring full, event dropped
+    bool publish(const DecisionEvent& event);
+    // One event per face of an analysed frame (faces / analyses index-aligned)
+    void publishFrame(int streamId, uint64_t seq, std::chrono::steady_clock::time_point captureTime,
+                      const std::vector<FaceResult>& faces, const std::vector<FaceAnalysis>& analyses);
+
+    uint64_t getPublished() const { return publishedCount.load(std::memory_order_relaxed); }
+    uint64_t getDropped() const { return droppedCount.load(std::memory_order_relaxed); }
+    uint64_t getWritten() const { return writtenCount.load(std::memory_order_relaxed); }
+    void printStats(const char* tag) const;
+
+    // JSONL line of one event (no trailing newline), appended to out
+    static void formatJson(const DecisionEvent& event, std::string& out);
+    // Keeps the real stdout for the event stream and points fd 1 at stderr, so
+    // every std::cout / printf log goes to stderr. Returns the kept fd (-1 = failed).
+    // Call before anything is logged.
+    static int detachStdout();
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        DecisionEvent event;
+    };
+
+    bool tryPop(DecisionEvent& event);
+    void writerLoop();
+    bool openSocket(const std::string& path);
+    bool openShm(const std::string& name, size_t slots);
+    void acceptClients();
+    void writeLines(const std::string& lines);
+    void writeShm(const DecisionEvent& event);
+    void closeOutputs();
+
+    DecisionSinkConfig config;
+
+    // Bounded MPSC ring (Vyukov): producers claim a cell with one CAS on head
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) size_t tail;     // writer thread only
+
+    std::thread writer;
+    std::atomic<bool> running;
+
+    FILE* jsonlFile;
+    bool ownsJsonlFile;
+    int listenFd;
+    std::vector<int> clients;
+    DecisionShmHeader* shmHeader;
+    DecisionShmSlot* shmSlots;
+    size_t shmBytes;
+    uint64_t shmIndex;
+
+    alignas(64) std::atomic<uint64_t> publishedCount;
+    std::atomic<uint64_t> droppedCount;
+    std::atomic<uint64_t> writtenCount;
+    std::atomic<uint64_t> disconnectedCount;
+};
@@ -0,0 +1,167 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/decision_params.h (Hot-reloadable thresholds + fusion weights)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Every threshold / weight of the REAL-FAKE decision in one flat, trivially
+// copyable struct. Defaults are the values the code was tuned with; a config
+// file (cv::FileStorage YAML / JSON, one map per section, see README) only
+// overrides the keys it names. Cue scores (+0.15 etc.) stay in the code,
+// Layer4Hybrid::adjustmentBounds() relies on their ranges.
+struct DecisionParams {
+    // ===== layer3: status bands of the smoothed score =====
+    float livenessRealStrong = 0.85f;
+    float livenessSpoofStrong = 0.30f;
+    float livenessReal = 0.72f;
+    float livenessSpoof = 0.45f;
+    // ===== smoothing: Layer3 history resets =====
+    float smoothResetBelow = 0.25f;     // history dropped, score passed through
+    float smoothDropFrom = 0.70f;       // previous above / current below = sudden drop
+    float smoothDropTo = 0.45f;
+    float smoothLowScore = 0.40f;
+    int smoothLowFrames = 3;            // low frames in a row before the history is dropped
+    float smoothLagMargin = 0.20f;      // current this far under the average ...
+    float smoothLagBlend = 0.70f;       // ... pulls it: current * blend + smoothed * (1 - blend)
+
+    // ===== texture: gradient std / mean ratio and mean magnitude =====
+    float textureRatioGoodLo = 0.7f;
+    float textureRatioGoodHi = 1.8f;
+    float textureRatioFlat = 0.4f;
+    float textureRatioNoisy = 2.2f;
+    float textureGradLow = 3.5f;
+    float textureGradMid = 8.0f;
+    float textureGradHigh = 25.0f;
+    // ===== moire: Laplacian variance of the 128x128 centre patch =====
+    float moireVarianceHigh = 1200.0f;
+    float moireVarianceMid = 850.0f;
+    float moireVarianceLow = 100.0f;
+    float moireVarianceGoodLo = 150.0f;
+    float moireVarianceGoodHi = 500.0f;
+    // ===== skin: YCrCb means, luma contrast, saturation =====
+    float skinCrMin = 125.0f;
+    float skinCrMax = 180.0f;
+    float skinCbMin = 70.0f;
+    float skinCbMax = 135.0f;
+    float skinContrastLow = 25.0f;
+    float skinContrastHigh = 140.0f;
+    float skinContrastGoodLo = 40.0f;
+    float skinContrastGoodHi = 120.0f;
+    float skinSatGoodLo = 15.0f;
+    float skinSatGoodHi = 90.0f;
+    float skinSatLow = 8.0f;
+    float skinSatHigh = 110.0f;
+    // ===== temperature: R/G, G/B ratios and brightness =====
+    float tempRgGoodLo = 1.05f;
+    float tempRgGoodHi = 1.45f;
+    float tempGbGoodLo = 1.10f;
+    float tempGbGoodHi = 1.65f;
+    float tempRgLo = 0.98f;
+    float tempRgHi = 1.55f;
+    float tempGbLo = 1.00f;
+    float tempGbHi = 1.80f;
+    float tempBrightLow = 20.0f;
+    float tempBrightHigh = 235.0f;
+    float tempBrightGoodLo = 40.0f;
+    float tempBrightGoodHi = 200.0f;
+    // ===== edges: Canny pixels in the 5 px border =====
+    float edgeCannyLow = 50.0f;
+    float edgeCannyHigh = 150.0f;
+    float edgeRatioHigh = 0.20f;
+    float edgeRatioMid = 0.15f;
+    // ===== frequency: spectral high-band mean =====
+    float freqHigh = 17.0f;
+    float freqMid = 14.5f;
+    float freqLow = 5.0f;
+    float freqGoodLo = 7.0f;
+    float freqGoodHi = 13.0f;
+
+    // ===== fusion: Layer4 cue weights and clamp =====
+    float weightSkin = 1.0f;
+    float weightTexture = 0.8f;
+    float weightTemperature = 0.6f;
+    float weightEdges = 0.7f;
+    float weightMoire = 0.9f;           // moire + frequency
+    float adjustmentMin = -0.60f;
+    float adjustmentMax = 0.50f;
+
+    // ===== decision: Layer3 + Layer4 fusion and verdict rules =====
+    float livenessWeight = 0.75f;
+    float adjustmentWeight = 0.25f;
+    float penaltyStrongBelow = -0.45f;  // adjustment under -> score * penaltyStrong
+    float penaltyStrong = 0.80f;
+    float penaltyBelow = -0.35f;
+    float penalty = 0.90f;
+    float strongRealScore = 0.75f;      // final > and liveness > and adjustment >
+    float strongRealLiveness = 0.70f;
+    float strongRealAdjustment = -0.20f;
+    float weakRealScore = 0.65f;
+    float weakRealLiveness = 0.60f;
+    float weakRealAdjustment = -0.40f;
+    float strongFakeScore = 0.30f;      // final < or adjustment < or liveness <
+    float strongFakeAdjustment = -0.50f;
+    float strongFakeLiveness = 0.25f;
+    float weakFakeScore = 0.45f;        // final < and liveness < and adjustment <
+    float weakFakeLiveness = 0.55f;
+    float weakFakeAdjustment = -0.35f;
+    float dropFrom = 0.70f;             // last real score above, raw below dropTo ...
+    float dropTo = 0.35f;
+    int dropFrames = 3;                 // ... this many times: final capped at dropCap
+    float dropCap = 0.35f;
+    float dropRecover = 0.60f;          // raw above resets the drop count
+    float strongRealCredit = 2.0f;
+    float weakRealCredit = 1.5f;
+    float realConfidence = 6.0f;        // credit needed for REAL
+    int confirmFrames = 4;              // real / fake frames in a row
+    int missingFrames = 10;             // face absent longer -> track expires, history dropped
+
+    // Active set: one acquire load, valid for the whole process
+    static const DecisionParams& current() { return *active.load(std::memory_order_acquire); }
+    // Copies params and makes the copy current. Earlier sets stay allocated
+    // (readers may still hold them, there is no grace period to wait for)
+    static void publish(const DecisionParams& params);
+    static uint32_t generation();
+
+    // Defaults overridden by the keys of path; false (and out untouched) on a
+    // parse error, an unknown key or a set that breaks validate()
+    static bool load(const std::string& path, DecisionParams& out);
+    // Every key with its value (a template for a site config)
+    static bool save(const std::string& path, const DecisionParams& params);
+    // Orderings the cascade bounds and the state machine rely on; empty = ok
+    std::string validate() const;
+
+private:
+    static std::atomic<const DecisionParams*> active;
+};
+
+// Polls the config file's mtime and publishes every valid new version.
+// A file that fails to load is reported and the running set is kept.
+class DecisionConfigWatcher {
+public:
+    DecisionConfigWatcher();
+    ~DecisionConfigWatcher();
+
+    bool start(const std::string& path, int pollMs = 1000);
+    void stop();
+    uint64_t getReloads() const { return reloads.load(std::memory_order_relaxed); }
+    uint64_t getRejected() const { return rejected.load(std::memory_order_relaxed); }
+
+private:
+    void watchLoop();
+
+    std::string path;
+    int pollMs;
+    std::thread watcher;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool running;
+    std::atomic<uint64_t> reloads;
+    std::atomic<uint64_t> rejected;
+};
@@ -0,0 +1,53 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/display_renderer.h (Off-thread display, newest wins)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <string>
+#include <thread>
+#include "frame_mailbox.h"
+#include "layer5_visualization.h"
+#include "pipeline.h"
+
+// Owns every highgui call: resize, Layer5 overlay (on the display-size buffer),
+// imshow and the key pump all run on the render thread. The processing side
+// only publishes annotated frames into a triple buffer and never waits.
+// Built with HEADLESS=ON (FACE_HEADLESS) start() always fails.
+class DisplayRenderer {
+public:
+    DisplayRenderer();
+    ~DisplayRenderer();
+
+    bool start(const std::string& windowName, cv::Size displaySize);
+    void stop();
+
+    // Processing thread: slot is swapped with an older buffer, never blocks
+    void publish(FrameSlot& slot) { mailbox.publish(slot); }
+
+    bool isQuitRequested() const { return quitRequested.load(std::memory_order_relaxed); }
+    // 'r' pressed since the last call
+    bool takeResetRequest() { return resetRequested.exchange(false, std::memory_order_relaxed); }
+
+    uint64_t getShown() const { return shown.load(std::memory_order_relaxed); }
+    QueueCounters counters() const { return mailbox.counters(); }
+
+private:
+    void renderLoop();
+
+    FrameMailbox<FrameSlot> mailbox;
+    std::thread thread;
+    std::string windowName;
+    cv::Size displaySize;
+    cv::Mat displayBuffer;
+    Layer5Visualization overlay;
+    std::vector<VisualizationData> overlayFaces;   // reused, capacity kept
+    float fps;
+
+    std::atomic<bool> running;
+    std::atomic<bool> quitRequested;
+    std::atomic<bool> resetRequested;
+    std::atomic<uint64_t> shown;
+};
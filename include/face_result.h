@@ -0,0 +1,13 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/face_result.h
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <vector>
+struct FaceResult {
+    cv::Rect bbox;                      
+    float confidence;                
+    std::vector<cv::Point2f> landmarks; 
+};
@@ -0,0 +1,65 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/face_roi_cache.h (Shared per-face ROI pyramid)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <array>
+#include "video_frame.h"
+
+class FrameArena;
+
+// Lazily built resolution / colour variants of one face ROI.
+// Every variant is produced once per face; a resized grey level is taken from
+// the nearest larger level that already covers the requested region.
+// Mats are kept across reset() so a steady stream of faces does not allocate.
+class FaceRoiCache {
+public:
+    FaceRoiCache();
+
+    // Start a new face, faceBox is clipped to the frame (frame must outlive the cache use)
+    bool reset(const cv::Mat& frame, const cv::Rect& faceBox);
+    // Native frame: grey reads the Y samples, BGR is converted for this ROI only on demand
+    bool reset(const VideoFrame& frame, const cv::Rect& faceBox);
+
+    const cv::Rect& box() const { return roiBox; }
+    PixelLayout getLayout() const { return layout; }
+    // ROI in the frame's own layout (YUYV: CV_8UC2, even x / width)
+    const cv::Mat& native() const { return roi; }
+    const cv::Mat& bgr();
+
+    // Full-resolution grey ROI
+    const cv::Mat& gray();
+    // Grey of region (ROI coordinates) resized to size
+    const cv::Mat& gray(const cv::Rect& region, const cv::Size& size);
+    const cv::Mat& gray(const cv::Size& size) { return gray(cv::Rect(0, 0, roi.cols, roi.rows), size); }
+
+    // Build counters since construction (for the bench / stats)
+    int getResizeCount() const { return resizeCount; }
+    int getConvertCount() const { return convertCount; }
+    // BGR / grey / pyramid buffers from the frame arena (one face per frame per slot)
+    void bindScratch(FrameArena& arena);
+
+private:
+    // Fixed slots so references handed out stay valid for the whole face
+    static constexpr int maxLevels = 4;
+
+    struct Level {
+        cv::Rect region;
+        cv::Size size;
+        cv::Mat image;
+        bool valid = false;
+    };
+
+    cv::Mat roi;
+    cv::Rect roiBox;
+    PixelLayout layout;
+    cv::Mat roiBgr;
+    bool roiBgrValid;
+    cv::Mat fullGray;
+    bool fullGrayValid;
+    std::array<Level, maxLevels> levels;
+    int resizeCount;
+    int convertCount;
+};
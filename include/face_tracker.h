@@ -0,0 +1,70 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/face_tracker.h (IoU/centroid multi-face tracker)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <vector>
+#include "layer2_detection.h"
+#include "layer3_liveness.h"
+#include "anti_spoof_decision.h"
+#include "cascade_scheduler.h"
+
+class FaceTracker {
+public:
+    FaceTracker(float iouThreshold = 0.30f, int maxMissedFrames = 10);
+
+    // trackIds[i] is the stable ID assigned to detections[i]
+    void update(const std::vector<FaceResult>& detections, std::vector<int>& trackIds);
+    // Tracks that expired during the last update()
+    const std::vector<int>& getRemovedIds() const { return removedIds; }
+    // Unmatched for more than frames updates -> expired (DecisionParams::missingFrames)
+    void setMaxMissedFrames(int frames) { maxMissedFrames = std::max(1, frames); }
+    void reset();
+
+private:
+    struct Track {
+        int id;
+        cv::Rect bbox;
+        int missed;
+    };
+
+    float matchScore(const cv::Rect& a, const cv::Rect& b) const;
+
+    float iouThreshold;
+    int maxMissedFrames;
+    int nextId;
+    std::vector<Track> tracks;
+    std::vector<int> removedIds;
+
+    struct Candidate {
+        float score;
+        int track;
+        int detection;
+    };
+    std::vector<Candidate> candidates;
+    std::vector<char> trackUsed;
+};
+
+// Everything a face carries from frame to frame
+struct TrackState {
+    int trackId;
+    LivenessTrackState liveness;
+    AntiSpoofDecision decision;
+    CascadeTrackState cascade;
+};
+
+// Flat per-track table: a handful of faces per frame, linear scan beats hashing
+class TrackStateTable {
+public:
+    int acquire(int trackId);
+    TrackState& at(int index) { return states[index]; }
+    void remove(int trackId);
+    void clear() { states.clear(); }
+    size_t size() const { return states.size(); }
+
+private:
+    std::vector<TrackState> states;
+};
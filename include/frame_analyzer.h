@@ -0,0 +1,135 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/frame_analyzer.h (Layer3 + Layer4 + decision per frame)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <vector>
+#include "layer2_detection.h"
+#include "layer3_liveness.h"
+#include "layer4_hybrid.h"
+#include "anti_spoof_decision.h"
+#include "face_tracker.h"
+#include "task_pool.h"
+#include "frame_arena.h"
+
+// Per-face outcome of one frame, index-aligned with the detections
+struct FaceAnalysis {
+    int trackId = -1;
+    DecisionState state = DecisionState::ANALYZING;
+    float rawScore = -1.0f;        // Layer3 fused model output
+    float livenessScore = -1.0f;   // Layer3 smoothed
+    float adjustment = 0.0f;       // Layer4
+    float finalScore = 0.0f;
+    int realStreak = 0;            // progress towards REAL (DecisionParams::confirmFrames)
+    float cueAdjustment[Layer4Hybrid::CUE_COUNT] = {};   // weighted Layer4 cues, before the clamp
+    unsigned cueMask = 0;          // cues measured on this frame (cueBit)
+};
+
+class FrameAnalyzer {
+public:
+    FrameAnalyzer(Layer3Liveness& liveness, Layer4Hybrid& hybrid);
+    // Tracks + decisions only: the caller runs the models (prepare -> Layer3 -> finish),
+    // e.g. one stream of StreamServer scored by whichever worker picks its frame
+    FrameAnalyzer();
+
+    void setMinFaceWidth(int width) { minFaceWidth = width; }
+    // Run the Layer3 batch and every Layer4 cue of every face as one task graph
+    // (joined before the decisions). nullptr = sequential, the default.
+    void setExecutor(WorkStealingPool* pool) { executor = pool; }
+    // Early-exit cascade (takes precedence over the executor when enabled)
+    void setCascade(const CascadeConfig& config) { cascade.setConfig(config); }
+    const CascadeScheduler& getCascade() const { return cascade; }
+    // Layer3 / Layer4 scratch from one slab of bytes, rewound after every analyze()
+    void enableArena(size_t bytes);
+    const FrameArena* getArena() const { return arena.get(); }
+    // QoS knobs, same thread as analyze(): Layer4 cue subset, first N Layer3 models (0 = all)
+    void setCueMask(unsigned mask);
+    void setModelLimit(int count);
+    void analyze(const cv::Mat& frame, const std::vector<FaceResult>& faces,
+                 std::vector<FaceAnalysis>& results);
+    // Native frame: Layer3 converts only its crops, Layer4 reads Y / sampled rows
+    void analyze(const VideoFrame& frame, const std::vector<FaceResult>& faces,
+                 std::vector<FaceAnalysis>& results);
+    // Phase 1: track IDs, TOO_FAR faces; getPendingBoxes()/getPendingStates() need Layer3.
+    // params is the frame's snapshot: Layer3 (pass the same one), Layer4 and the
+    // decisions of finish() all score under it, a reload lands on the next frame
+    void prepare(const std::vector<FaceResult>& faces, std::vector<FaceAnalysis>& results,
+                 const DecisionParams& params = DecisionParams::current());
+    const std::vector<cv::Rect>& getPendingBoxes() const { return livenessBoxes; }
+    const std::vector<LivenessTrackState*>& getPendingStates() const { return livenessStates; }
+    // Phase 2: liveResults[k] belongs to getPendingBoxes()[k]
+    void finish(const VideoFrame& frame, const std::vector<FaceResult>& faces,
+                const LivenessResult* liveResults, Layer4Hybrid& quality,
+                std::vector<FaceAnalysis>& results);
+    void reset();
+    void manualReset();
+
+    // Stage timings of the last analyze() call
+    double getLastLivenessMs() const { return lastLivenessMs; }
+    // With an executor both overlap: quality = graph wall time after Layer3 finished
+    double getLastQualityMs() const { return lastQualityMs; }
+
+private:
+    void analyzeSequential(const VideoFrame& frame, const std::vector<FaceResult>& faces,
+                           std::vector<FaceAnalysis>& results);
+    void analyzeParallel(const VideoFrame& frame, const std::vector<FaceResult>& faces,
+                         std::vector<FaceAnalysis>& results);
+    void analyzeCascade(const VideoFrame& frame, const std::vector<FaceResult>& faces,
+                        std::vector<FaceAnalysis>& results);
+    void runCascadeLiveness(const VideoFrame& frame);
+    void decide(const LivenessResult* liveResults, std::vector<FaceAnalysis>& results);
+    static void livenessTask(void* self, int);
+    static void prepareCuesTask(void* self, int face);
+    static void cueTask(void* self, int faceCue);
+    Layer4Hybrid* addFaceQuality();
+
+    Layer3Liveness* liveness;
+    Layer4Hybrid* hybrid;
+    int minFaceWidth;
+
+    FaceTracker tracker;
+    TrackStateTable trackTable;
+    std::vector<int> trackIds;
+    std::vector<int> tableIndex;
+    std::vector<int> livenessFaces;
+    std::vector<cv::Rect> livenessBoxes;
+    std::vector<LivenessTrackState*> livenessStates;
+    std::vector<LivenessResult> livenessResults;
+    std::vector<float> adjustments;
+    std::vector<QualityCues> adjustmentCues;   // index-aligned with adjustments
+    std::vector<unsigned> adjustmentMasks;
+    std::vector<uchar> withoutLiveness;        // cascade exit before Layer3 ever ran for the track
+    VideoFrame matFrame;    // wraps cv::Mat callers
+    const DecisionParams* frameParams;   // taken by prepare(), never freed
+
+    double lastLivenessMs;
+    double lastQualityMs;
+    unsigned cueMask;
+
+    // Parallel path: one Layer4 per face, so cue tasks of different faces never share scratch
+    WorkStealingPool* executor;
+    TaskGraph graph;
+    std::vector<std::unique_ptr<Layer4Hybrid>> faceQuality;
+    const VideoFrame* graphFrame;
+    const std::vector<FaceResult>* graphFaces;
+
+    // Cascade path, index-aligned with livenessFaces
+    struct CascadeFace {
+        unsigned known = 0;       // Layer4 cues run this frame
+        bool hasLiveness = false; // Layer3 ran this frame
+        bool light = false;
+        bool done = false;
+        bool ranAllStages = false;
+        float exitAdjustment = 0.0f;
+    };
+    CascadeScheduler cascade;
+    std::vector<CascadeFace> cascadeFaces;
+    std::vector<LivenessResult> cascadeLive;
+    std::vector<int> cascadeBatch;
+
+    // Last member: destroyed first, while the bound layers still exist
+    std::unique_ptr<FrameArena> arena;
+};
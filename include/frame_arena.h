@@ -0,0 +1,91 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/frame_arena.h (Per-worker frame scratch arena)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// cv::MatAllocator over one pre-sized, 64-byte aligned slab.
+// Scratch buffers of a layer are bound once (bind()); from then on every
+// create() on them, by the layer or inside OpenCV, bumps a pointer in the slab
+// (lock-free, so the cue tasks of one frame may allocate concurrently).
+// reset() at the end of the frame rewinds the slab and drops the bound
+// headers, so the next frame reuses the same bytes. Nothing is freed one by one.
+// Slab or header pool exhausted -> standard allocator, counted in getFallbacks().
+// Destroy the arena before the objects whose Mats are bound to it.
+class FrameArena : public cv::MatAllocator {
+public:
+    explicit FrameArena(size_t bytes = 8 << 20, int maxBuffers = 512);
+    ~FrameArena();
+
+    // Scratch headers released on every reset(); vectors are walked at reset,
+    // so elements added later are bound from the next frame on
+    void bind(cv::Mat& mat);
+    void bind(std::vector<cv::Mat>& mats);
+
+    // Single thread, no allocation in flight: slab offset back to 0 (O(1)),
+    // bound headers released
+    void reset();
+
+    size_t capacity() const { return slabBytes; }
+    size_t getUsed() const { return std::min(offset.load(std::memory_order_relaxed), slabBytes); }
+    size_t getHighWater() const { return highWater.load(std::memory_order_relaxed); }
+    uint64_t getFallbacks() const { return fallbacks.load(std::memory_order_relaxed); }
+    void printStats(const char* tag) const;
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override;
+    bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags,
+                  cv::UMatUsageFlags usageFlags) const override;
+    void deallocate(cv::UMatData* data) const override;
+
+private:
+    bool owns(const cv::UMatData* u) const {
+        return u >= headers && u < headers + headerCount;
+    }
+
+    uchar* slab;
+    size_t slabBytes;
+    int headerCount;
+    cv::UMatData* headers;     // headerCount constructed in raw storage (no default ctor)
+    mutable std::atomic<size_t> offset;
+    mutable std::atomic<int> nextHeader;
+    std::atomic<size_t> highWater;     // written by reset(), read by the stats printer
+    bool warned;
+    mutable std::atomic<uint64_t> fallbacks;
+
+    std::vector<cv::Mat*> boundMats;
+    std::vector<std::vector<cv::Mat>*> boundVectors;
+};
+
+// Steady-state heap check. Built with ALLOC_DEBUG (FACE_ALLOC_DEBUG) every
+// global operator new and, after install(), every cv::Mat buffer from the
+// default allocator is counted; otherwise count() stays 0 and enabled() is false.
+class AllocationCounter {
+public:
+    static bool enabled();
+    static void install();
+    static uint64_t count();
+
+    // Not counted on this thread while alive: wraps the OpenCV calls that
+    // heap-allocate their own working memory on every call (filter rows of
+    // Sobel / Laplacian, Canny's map and stack, DFT and resize tables).
+    // Compiles to nothing without ALLOC_DEBUG
+    class Exclude {
+    public:
+#ifdef FACE_ALLOC_DEBUG
+        Exclude();
+        ~Exclude();
+#else
+        Exclude() {}
+        ~Exclude() {}
+#endif
+        Exclude(const Exclude&) = delete;
+        Exclude& operator=(const Exclude&) = delete;
+    };
+};
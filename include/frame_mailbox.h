@@ -0,0 +1,67 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/frame_mailbox.h (Lock-free latest-value mailbox)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include "spsc_ring.h"
+
+// Triple buffer, one producer / one consumer, newest wins.
+// publish() never waits: a frame the consumer has not taken yet is simply
+// replaced. take() always gets the freshest frame or nothing.
+template <typename T>
+class FrameMailbox {
+public:
+    FrameMailbox()
+        : back(0), middle(1), front(2),
+          publishedCount(0), takenCount(0), droppedCount(0) {}
+
+    // Producer side. Item is swapped into the back slot, so the caller gets
+    // an old buffer back (cv::Mat storage keeps circulating).
+    void publish(T& item) {
+        std::swap(slots[back], item);
+        const uint8_t prev = middle.exchange((uint8_t)(back | FRESH), std::memory_order_acq_rel);
+        back = prev & INDEX_MASK;
+        publishedCount.fetch_add(1, std::memory_order_relaxed);
+        if (prev & FRESH) droppedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Consumer side, non blocking. False = nothing new since the last take.
+    bool take(T& item) {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        const uint8_t prev = middle.exchange(front, std::memory_order_acq_rel);
+        front = prev & INDEX_MASK;
+        std::swap(item, slots[front]);
+        takenCount.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool hasNew() const { return (middle.load(std::memory_order_acquire) & FRESH) != 0; }
+
+    // Same shape as the ring counters, so stats print side by side
+    QueueCounters counters() const {
+        QueueCounters c;
+        c.pushed = publishedCount.load(std::memory_order_relaxed);
+        c.popped = takenCount.load(std::memory_order_relaxed);
+        c.dropped = droppedCount.load(std::memory_order_relaxed);
+        c.depth = hasNew() ? 1 : 0;
+        c.maxDepth = 1;
+        return c;
+    }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH = 0x4;
+
+    T slots[3];
+    uint8_t back;                   // producer only
+    alignas(64) std::atomic<uint8_t> middle;
+    alignas(64) uint8_t front;      // consumer only
+
+    alignas(64) std::atomic<uint64_t> publishedCount;
+    std::atomic<uint64_t> takenCount;
+    std::atomic<uint64_t> droppedCount;
+};
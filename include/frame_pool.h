@@ -0,0 +1,46 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/frame_pool.h (Refcounted frame-buffer pool)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <memory>
+
+// cv::MatAllocator over a fixed set of frame slots.
+// A frame acquired from the pool is an ordinary cv::Mat: copies and the ring
+// swaps share it through cv::Mat's own refcount, and the slot becomes free
+// again when the last reference is released. After warm-up no frame touches
+// the heap; when every slot is still held downstream the pool falls back to
+// the standard allocator and counts it.
+class FramePool : public cv::MatAllocator {
+public:
+    explicit FramePool(int maxSlots = 24);
+    ~FramePool();
+
+    // Point frame at a free slot of the given size/type (old contents released)
+    void acquire(cv::Mat& frame, const cv::Size& size, int type);
+
+    int getSlotCount() const { return slotCount; }
+    int getInUse() const;
+    uint64_t getFallbacks() const { return fallbacks.load(); }
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override;
+    bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags,
+                  cv::UMatUsageFlags usageFlags) const override;
+    void deallocate(cv::UMatData* data) const override;
+
+private:
+    struct Slot {
+        uchar* data = nullptr;
+        size_t bytes = 0;
+        std::unique_ptr<cv::UMatData> u;
+        std::atomic<bool> inUse{false};
+    };
+
+    int slotCount;
+    std::unique_ptr<Slot[]> slots;
+    mutable std::atomic<uint64_t> fallbacks;
+};
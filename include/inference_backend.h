@@ -0,0 +1,54 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/inference_backend.h (Pluggable ONNX inference)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <memory>
+#include <string>
+
+enum class BackendKind {
+    OPENCV,        // cv::dnn, always available
+    ONNXRUNTIME,   // needs -DWITH_ONNXRUNTIME=ON
+    OPENVINO       // needs -DWITH_OPENVINO=ON
+};
+
+const char* backendKindName(BackendKind kind);
+bool parseBackendKind(const std::string& text, BackendKind& kind);
+bool isBackendAvailable(BackendKind kind);
+
+struct BackendOptions {
+    BackendKind kind = BackendKind::OPENCV;
+    int threads = 0;          // 0 = library default
+    bool preferInt8 = false;  // load <model>_int8.onnx when it sits next to the FP32 file
+};
+
+// models/MiniFASNetV2.onnx -> models/MiniFASNetV2_int8.onnx if present (else the FP32 path)
+std::string resolveModelPath(const std::string& fp32Path, bool preferInt8);
+
+// Model bytes already in memory (e.g. a slice of an mmap'ed ModelBundle).
+// data stays valid while keepAlive is held, so a backend that reads the
+// weights in place (ORT format) keeps a copy of it.
+struct ModelBlob {
+    std::string name;
+    const uchar* data = nullptr;
+    size_t size = 0;
+    std::shared_ptr<const void> keepAlive;
+
+    bool isOrtFormat() const;   // ".ort": ONNX Runtime's pre-optimised layout
+};
+
+// One loaded ONNX model: NCHW float32 blob in, first output as (batch x N) float32 out.
+// forward() returns false instead of throwing (e.g. a model exported with batch = 1).
+class InferenceBackend {
+public:
+    virtual ~InferenceBackend() {}
+    virtual bool load(const std::string& modelPath) = 0;
+    virtual bool load(const ModelBlob& blob) = 0;
+    virtual bool forward(const cv::Mat& blob, cv::Mat& output) = 0;
+    virtual const char* name() const = 0;
+};
+
+// Falls back to OpenCV DNN (with a warning) when the requested backend was not compiled in
+std::unique_ptr<InferenceBackend> createInferenceBackend(const BackendOptions& options);
@@ -0,0 +1,53 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/landmark_tracker.h (Keyframe face propagation)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include "face_result.h"
+
+struct TrackingConfig {
+    int minInterval = 2;          // keyframe interval bounds (frames)
+    int maxInterval = 8;
+    float minQuality = 0.60f;     // fraction of points passing forward-backward check
+    float fastMotion = 0.08f;     // displacement per frame / face width
+    float slowMotion = 0.02f;
+    float workScale = 0.5f;       // optical flow runs on a downscaled gray frame
+};
+
+// Propagates boxes + 5 landmarks between YuNet keyframes with sparse LK flow
+class LandmarkTracker {
+public:
+    LandmarkTracker();
+
+    void setConfig(const TrackingConfig& cfg);
+    const TrackingConfig& getConfig() const { return config; }
+    // Start a new segment from fresh detections
+    void resetKeyframe(const cv::Mat& frame, const std::vector<FaceResult>& faces);
+    // Move the faces of the last frame onto this one. False = tracking lost, detect now
+    bool propagate(const cv::Mat& frame, std::vector<FaceResult>& faces);
+    bool needsKeyframe() const;
+    int getInterval() const { return interval; }
+
+private:
+    static constexpr int gridSide = 3;
+    static constexpr int pointsPerFace = 5 + gridSide * gridSide;
+
+    void toGray(const cv::Mat& frame, cv::Mat& dst);
+    void buildPoints(const std::vector<FaceResult>& faces);
+
+    TrackingConfig config;
+    int interval;
+    int framesSinceKeyframe;
+    bool forceKeyframe;
+    float peakMotion;
+
+    std::vector<FaceResult> tracked;
+    cv::Mat smallBuffer, prevGray, currGray;
+    std::vector<cv::Point2f> prevPts, nextPts, backPts;
+    std::vector<uchar> status, backStatus;
+    std::vector<float> err;
+    std::vector<float> dxs, dys, ratios;
+};
@@ -5,6 +5,13 @@
 // =================================================================
 #pragma once
 #include <opencv2/opencv.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+#include "frame_pool.h"
+#include "v4l2_capture.h"
+#include "video_frame.h"
+#include "metrics.h"
 // =========================================================
 // Full HD: 1920 | HD: 1280 | nHD: 960 | HD: 800 | nHD: 640
 // Full HD: 1080 | HD: 720  | nHD: 540 | HD: 600 | nHD: 480
@@ -17,11 +24,26 @@ public:
     bool init(int camID = 2, int captureWidth = 1280, int captureHeight = 720, 
               int displayWidth = 640, int displayHeight = 480);
 
+    // Native zero-copy backend (mmap buffers, pooled BGR frames, no warm-up reads)
+    bool initV4L2(const V4L2Config& config, int displayWidth = 640, int displayHeight = 480);
+    // Same backend over a raw YUYV file instead of /dev/videoN
+    bool initFakeDevice(const std::string& path, int width, int height, int fps = 30,
+                        int displayWidth = 640, int displayHeight = 480);
+
+    // Offline source: video file, image directory or manifest (.txt/.lst, one path per line)
+    bool openSource(const std::string& path);
+    bool isOffline() const { return offline; }
+    // Image path or "video#index" of the last grabbed frame
+    const std::string& getFrameName() const { return frameName; }
+
     void release();
     bool grabFrame(cv::Mat& frame);
-    void show(const cv::String& windowName, const cv::Mat& frame);
+    // Native layout: YUYV sources stay YUYV (copied into a pooled slot), others BGR
+    bool grabFrame(VideoFrame& frame);
     int getMinFaceWidth() const;
     cv::Size getCaptureSize() const;
+    cv::Size getDisplaySize() const { return displaySize; }
+    const FramePool& getFramePool() const { return framePool; }
 
 private:
     bool isInitialized;
@@ -29,5 +51,17 @@ private:
     int captureHeight;
     cv::VideoCapture cap;
     cv::Size displaySize;
-    cv::Mat displayBuffer; 
+
+    bool offline;
+    std::string sourcePath;
+    std::vector<std::string> imageList;
+    size_t imageIndex;
+    size_t frameIndex;
+    std::string frameName;
+
+    // V4L2 backend: raw view is released (buffer requeued) right after conversion
+    std::unique_ptr<V4L2Capture> v4l2;
+    FramePool framePool;
+    cv::Mat rawFrame;
+    cv::Mat yuyvFrame;
 };
\ No newline at end of file
@@ -5,11 +5,26 @@
 // =================================================================
 #pragma once
 #include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
 #include <vector>
-struct FaceResult {
-    cv::Rect bbox;                      
-    float confidence;                
-    std::vector<cv::Point2f> landmarks; 
+#include <cstdint>
+#include "face_result.h"
+#include "landmark_tracker.h"
+#include "video_frame.h"
+#include "inference_backend.h"
+
+class ModelBundle;
+
+struct DetectionScaleConfig {
+    bool downscale = false;
+    int minFaceWidth = 0;          // smallest face we care about, full-res px
+    int minDetectableFace = 24;    // smallest face YuNet finds reliably (stride-8 head)
+    int minInputWidth = 320;       // never shrink the detector input below this
+    bool roiMode = false;          // search only around the last faces
+    float roiMargin = 0.75f;       // ROI grows by this fraction of the face size per side
+    int fullScanInterval = 15;     // full-frame scan every N frames to catch newcomers
+    int maxInputWidth = 0;         // hard cap on the detector input width (QoS), 0 = none
 };
 
 class Layer2Detection {
@@ -20,11 +35,56 @@ public:
     bool init(const std::string& modelPath, 
               float scoreThreshold = 0.6f, 
               float nmsThreshold = 0.3f);
+    // YuNet runs inside cv::FaceDetectorYN: OpenVINO maps to OpenCV's Inference Engine
+    // backend, ONNX Runtime is not available here (falls back to OpenCV DNN)
+    void setBackend(const BackendOptions& options) { backendOptions = options; }
+    // YuNet from the mapped bundle when it is there (nullptr = file only)
+    void setModelBundle(const ModelBundle* bundle) { modelBundle = bundle; }
+    // One detection on a blank frame of the expected size: input reshape and
+    // first-run allocations happen before the first real frame
+    bool warmUp(const cv::Size& frameSize);
     bool detect(const cv::Mat& frame, FaceResult& result);
+    // Every face above scoreThreshold, sorted by confidence (YuNet order)
+    int detectAll(const cv::Mat& frame, std::vector<FaceResult>& results);
+    // YuNet on keyframes only, optical-flow propagation in between (needs enableTracking)
+    int detectTracked(const cv::Mat& frame, std::vector<FaceResult>& results);
+    // Native frame: flow-only frames read Y, BGR is built only for keyframes
+    int detectTracked(const VideoFrame& frame, std::vector<FaceResult>& results);
+    void enableTracking(const TrackingConfig& config);
+    // Run YuNet on a downscaled copy / ROI, results stay in full-resolution coordinates
+    void setScaleConfig(const DetectionScaleConfig& config);
+    // Runtime knobs (QoS governor, detection thread): width cap, keyframe interval (<= 1 = YuNet every frame)
+    void setMaxInputWidth(int width) { scaleConfig.maxInputWidth = std::max(0, width); }
+    void setKeyframeInterval(int maxInterval);
+    const TrackingConfig& getTrackingConfig() const { return tracker.getConfig(); }
+    bool isTrackingEnabled() const { return trackingEnabled.load(std::memory_order_relaxed); }
+    // Written by the detecting thread, read by the stats printer
+    uint64_t getFrameCount() const { return frameCount.load(std::memory_order_relaxed); }
+    uint64_t getDetectorRuns() const { return detectorRuns.load(std::memory_order_relaxed); }
 
 private:
+    bool runModel(const cv::Mat& frame);
+    bool runOnRegion(const cv::Mat& frame, const cv::Rect& region);
+    cv::Rect searchRegion(const cv::Size& frameSize) const;
+    void parseRow(int row, const cv::Size& frameSize, FaceResult& result) const;
+
     bool isInitialized;
+    BackendOptions backendOptions;
+    const ModelBundle* modelBundle;
     cv::Ptr<cv::FaceDetectorYN> model; 
     cv::Size currentInputSize; 
     cv::Mat facesResultBuffer;
+
+    DetectionScaleConfig scaleConfig;
+    cv::Mat detectBuffer;
+    cv::Mat trackGray;       // Y samples of a native frame for the tracker
+    cv::Point2f mapOffset;   // detector coords -> frame coords
+    cv::Point2f mapScale;
+    cv::Rect lastFacesRegion;
+    int framesSinceFullScan;
+
+    LandmarkTracker tracker;
+    std::atomic<bool> trackingEnabled;   // QoS writes on the detect thread, printStats reads
+    std::atomic<uint64_t> frameCount;
+    std::atomic<uint64_t> detectorRuns;
 };
\ No newline at end of file
@@ -6,7 +6,16 @@
 #pragma once
 #include <opencv2/opencv.hpp>
 #include <opencv2/dnn.hpp>
-#include <deque>
+#include <algorithm>
+#include <vector>
+#include "video_frame.h"
+#include "inference_backend.h"
+#include "score_smoother.h"
+#include "metrics.h"
+#include "decision_params.h"
+
+class FrameArena;
+class ModelBundle;
 
 enum class LivenessStatus {
     REAL,
@@ -16,34 +25,110 @@ enum class LivenessStatus {
 
 struct LivenessResult {
     float score;
+    float rawScore;
     LivenessStatus status;
 };
 
+// Smoothing state of one face, plain data so it can live in a flat per-track table
+struct LivenessTrackState {
+    ScoreHistory history;
+    float previousScore = -1.0f;
+    float lastRawScore = -1.0f;
+    int consecutiveLowCount = 0;
+
+    void reset();
+};
+
+// One MiniFASNet of the ensemble. cropScale = crop side / max(face w, h)
+struct LivenessModelSpec {
+    std::string path;
+    float cropScale;
+    float weight;
+};
+
 class Layer3Liveness {
 public:
     Layer3Liveness();
     ~Layer3Liveness();
 
     bool init(const std::string& modelPath);
+    // Fused ensemble, every model gets its own crop scale, probabilities are weight-averaged
+    bool init(const std::vector<LivenessModelSpec>& specs);
+    // Backend / INT8 choice for the next init() call (default OpenCV DNN, FP32)
+    void setBackend(const BackendOptions& options) { backendOptions = options; }
+    // Models found in the mapped bundle are parsed from memory, the rest from models/ (nullptr = files only)
+    void setModelBundle(const ModelBundle* bundle) { modelBundle = bundle; }
+    // Dummy forward passes (batch 1 and maxBatch) so the first real frame pays no
+    // lazy layer allocation / kernel selection; also settles batchSupported
+    void warmUp(int maxBatch = 2);
+    void setSmoothing(const SmoothingConfig& config) { smoother.setConfig(config); }
+    // Crops, blob and model outputs from arena, reset per frame by its owner
+    void bindScratch(FrameArena& arena);
+    size_t getModelCount() const { return models.size(); }
+    // Only the first count ensemble models run (QoS), weights renormalised; 0 = all
+    void setModelLimit(int count) { modelLimit = std::max(0, count); }
     bool checkLiveness(const cv::Mat& frame, const cv::Rect& faceBox, LivenessResult& output);
+    // All faces of one frame in a single forward pass, states[i] belongs to faceBoxes[i].
+    // Smoothing / status bands from params (the frame's DecisionParams snapshot)
+    bool checkLivenessBatch(const cv::Mat& frame, const std::vector<cv::Rect>& faceBoxes,
+                            const std::vector<LivenessTrackState*>& states,
+                            std::vector<LivenessResult>& outputs,
+                            const DecisionParams& params = DecisionParams::current());
+    // Same on a native frame: only the crop regions are converted to BGR
+    bool checkLivenessBatch(const VideoFrame& frame, const std::vector<cv::Rect>& faceBoxes,
+                            const std::vector<LivenessTrackState*>& states,
+                            std::vector<LivenessResult>& outputs,
+                            const DecisionParams& params = DecisionParams::current());
+    // Faces of several frames (e.g. several cameras) in one forward pass,
+    // faceBoxes[i] lies in *frames[frameOf[i]]
+    bool checkLivenessBatch(const std::vector<const VideoFrame*>& frames, const std::vector<int>& frameOf,
+                            const std::vector<cv::Rect>& faceBoxes,
+                            const std::vector<LivenessTrackState*>& states,
+                            std::vector<LivenessResult>& outputs,
+                            const DecisionParams& params = DecisionParams::current());
     void resetHistory();
     float getLastRawScore() const;
 
 private:
+    struct LivenessModel {
+        std::string name;
+        std::unique_ptr<InferenceBackend> backend;
+        float cropScale;
+        float weight;
+        bool batchSupported;
+    };
+
     bool isInitialized;
-    cv::dnn::Net net;
+    BackendOptions backendOptions;
+    const ModelBundle* modelBundle;
+    std::vector<LivenessModel> models;
+    int modelLimit;
     cv::Size inputSize;
     cv::Mat borderBuffer;   
-    std::deque<float> scoreHistory;
-    std::string outputName;
-    const size_t maxHistorySize = 8;
-    float previousScore = -1.0f;
-    float lastRawScore = -1.0f;
-    int consecutiveLowCount = 0; 
-    float getSmoothedScore(float currentScore);
+    LivenessTrackState defaultState;
+    ScoreSmoother smoother;
+    float getSmoothedScore(LivenessTrackState& state, float currentScore, const DecisionParams& p);
+    bool prepareInput(const VideoFrame& frame, const cv::Rect& faceBox, float cropScale, cv::Mat& dst);
+    bool forwardBatch(LivenessModel& model, const std::vector<cv::Mat>& inputs);
+    void runModel(LivenessModel& model, float* realScores);
+    void finishResult(LivenessTrackState& state, float realScore, LivenessResult& output,
+                      const DecisionParams& p);
     cv::Mat validCrop;
-    cv::Mat finalInput;
+    VideoFrame matFrame;    // wraps cv::Mat callers
+    std::vector<const VideoFrame*> singleFrame;
+    std::vector<int> singleFrameOf;
+    std::vector<cv::Mat> cropPool;
+    std::vector<cv::Mat> batchInputs;
+    std::vector<cv::Mat> singleInput;
+    std::vector<int> batchIndex;
+    std::vector<float> modelScores;
+    std::vector<float> fusedScores;
+    std::vector<float> fusedWeights;   // per face, models that produced a score
+    std::vector<uchar> cropMissing;    // per batch row, crop of the current scale failed
+    std::vector<cv::Rect> singleBox;
+    std::vector<LivenessTrackState*> singleState;
+    std::vector<LivenessResult> singleOutput;
     cv::Mat blob;
     cv::Mat prob;
     cv::Mat softmax;
-};
\ No newline at end of file
+};
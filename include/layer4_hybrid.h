@@ -6,35 +6,112 @@
 #pragma once
 #include <opencv2/opencv.hpp>
 #include <vector>
+#include "color_stats.h"
+#include "spectral_engine.h"
+#include "face_roi_cache.h"
+#include "metrics.h"
+#include "decision_params.h"
+
+class FrameArena;
+
+// Raw scores of the five cues of one face, fused by Layer4Hybrid::fuseCues()
+struct QualityCues {
+    bool valid = false;       // ROI big enough to analyse
+    float skin = 0.0f;
+    float temperature = 0.0f;
+    float texture = 0.0f;
+    float edges = 0.0f;
+    bool hasMoire = false;    // centre patch >= 32 px
+    float moire = 0.0f;
+    double highFrequency = 0.0;
+};
 
 class Layer4Hybrid {
 public:
+    // Independent cues. prepareCues() builds every ROI variant (single thread),
+    // then runCue() calls for different cues may run on different threads:
+    // every cue owns its scratch buffers below. fuseCues() after all of them.
+    enum Cue {
+        CUE_COLOR,        // skin consistency + colour temperature (one stats pass)
+        CUE_TEXTURE,
+        CUE_EDGES,
+        CUE_MOIRE,
+        CUE_HIGH_FREQ,
+        CUE_COUNT
+    };
+
     Layer4Hybrid();
     ~Layer4Hybrid();
+    // Every scratch Mat (cues, spectral engine, ROI cache) from arena, reset per frame by its owner
+    void bindScratch(FrameArena& arena);
+
+    // Cue thresholds and fusion weights from params, kept by prepareCues() for
+    // runCue() / fuseCues() of the same face (the frame's DecisionParams snapshot)
+    float analyzeQuality(const cv::Mat& frame, const cv::Rect& faceBox,
+                         const DecisionParams& params = DecisionParams::current());
+    // Native frame (YUYV): grey features read Y, colour stats expand sampled rows only
+    float analyzeQuality(const VideoFrame& frame, const cv::Rect& faceBox,
+                         const DecisionParams& params = DecisionParams::current());
+    // Same, reading every resolution / grey variant from a shared per-face cache
+    float analyzeQuality(FaceRoiCache& roi, const DecisionParams& params = DecisionParams::current());
+
+    bool prepareCues(const VideoFrame& frame, const cv::Rect& faceBox,
+                     const DecisionParams& params = DecisionParams::current());
+    bool prepareCues(FaceRoiCache& roi, const DecisionParams& params = DecisionParams::current());
+    void runCue(int cue);
+    // Cues outside mask are skipped by runCue() and count as neutral (0) in the fusion;
+    // moire / high-frequency only run as a pair (QoS governor)
+    void setCueMask(unsigned mask) { cueMask = mask; }
+    unsigned getCueMask() const { return cueMask; }
+    float fuseCues() const { return fuseCues(cues, *params); }
+    const QualityCues& getCues() const { return cues; }
 
-    float analyzeQuality(const cv::Mat& frame, const cv::Rect& faceBox);
+    static unsigned cueBit(int cue) { return 1u << cue; }
+    // Thresholds / weights from p (default: the active DecisionParams; pass one
+    // snapshot when several calls must agree)
+    static float fuseCues(const QualityCues& cues, const DecisionParams& p = DecisionParams::current());
+    // Weighted share of every cue in fuseCues() before the clamp (decision events)
+    static void cueAdjustments(const QualityCues& cues, float out[CUE_COUNT],
+                               const DecisionParams& p = DecisionParams::current());
+    // Range fuseCues() can still reach when only the cues in knownMask have run
+    static void adjustmentBounds(const QualityCues& cues, unsigned knownMask, float& lo, float& hi,
+                                 const DecisionParams& p = DecisionParams::current());
+
+    // Radial bands of the last high-frequency probe (extra moire features)
+    const SpectralFeatures& getSpectralFeatures() const { return spectralFeatures; }
 
 private:
-    // 1. Buffers cho Texture Gradient & High Frequency
+    friend class Layer4Bench;   // bench/layer4_bench.cpp times each extractor
+
     float analyzeTextureGradient(const cv::Mat& src);
     float detectMoirePattern(const cv::Mat& src);
     double calculateHighFrequency(const cv::Mat& src);
-    bool checkSkinConsistency(const cv::Mat& src, float& outScore);
-    float analyzeColorTemperature(const cv::Mat& src);
+    bool checkSkinConsistency(const ColorStats& stats, float& outScore);
+    float analyzeColorTemperature(const ColorStats& stats);
     float detectScreenEdges(const cv::Mat& src); 
-    
-    cv::Mat grayBuffer, gradX, gradY, magnitude;
-    cv::Mat resizedBuffer, padded, complexI, magI;
-    cv::Mat mask;
-    cv::Mat dftPlanes[2];
 
-    // 2. Buffers cho Moire Pattern
+    // Inputs resolved by prepareCues() (headers into roiCache / the frame, read-only for the cues)
+    QualityCues cues;
+    const DecisionParams* params;   // sets are never freed, see DecisionParams::publish()
+    unsigned cueMask;
+    PixelLayout cueLayout;
+    cv::Mat colorInput;
+    cv::Mat grayInput;
+    cv::Mat edgeInput;
+    cv::Mat moireInput;
+
+    // 1. Texture Gradient
+    cv::Mat grayBuffer, gradX, gradY, magnitude;
+    // 2. High Frequency
+    SpectralEngine spectral;
+    SpectralFeatures spectralFeatures;
+    // 3. Moire Pattern
     cv::Mat moireResized, moireGray, moireLaplacian;
-    // 3. Buffers cho Skin Consistency
-    cv::Mat skinSmall, skinYCrCb, skinHSV;
-    cv::Mat plane0, plane1;
-    // 4. Buffers cho Color Temp
-    cv::Mat tempSmall;
-    // 5. Buffers cho Screen Edge Detection
-    cv::Mat edgeBuffer, edgeMap;
+    // 4. Skin Consistency + Color Temp (computeColorStats, mot lan duyet)
+    ColorStats colorStats;
+    cv::Mat colorRowScratch;
+    // 5. Screen Edge Detection
+    cv::Mat edgeBuffer, edgeGray, edgeMap;
+    // ROI pyramid dung chung (analyzeQuality(frame, box))
+    FaceRoiCache roiCache;
 };
\ No newline at end of file
@@ -0,0 +1,121 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/layer5_visualization.h
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// Description: UI/Display Management Layer - Tách biệt logic hiển thị
+// =================================================================
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include <chrono>
+
+enum class DisplayStatus {
+    IDLE,
+    TOO_FAR,
+    VERIFYING,
+    REAL_PERSON,
+    SPOOF_DETECTED,
+    COUNT
+};
+
+struct VisualizationData {
+    cv::Rect faceBox;               // capture coordinates
+    bool faceDetected;
+    int trackId;
+    float aiScore;
+    float physicalScore;
+    float finalScore;
+
+    DisplayStatus status;
+    int consecutiveRealFrames;
+    int consecutiveSpoofFrames;
+    const std::vector<cv::Point2f>* landmarks;   // capture coordinates, nullptr = none
+
+    VisualizationData() :
+        faceBox(0, 0, 0, 0),
+        faceDetected(false),
+        trackId(-1),
+        aiScore(0.0f),
+        physicalScore(0.0f),
+        finalScore(0.0f),
+        status(DisplayStatus::IDLE),
+        consecutiveRealFrames(0),
+        consecutiveSpoofFrames(0),
+        landmarks(nullptr) {}
+};
+
+// Overlay renderer for the downscaled display buffer. Everything that costs
+// (glyph rasterisation, text metrics, status label images) is built once in
+// init(); a frame only copies cached pixels and draws boxes / bars / dots,
+// so render() never touches the heap.
+class Layer5Visualization {
+private:
+    // ASCII 32..126 rasterised once; dynamic text = masked fills per glyph
+    struct GlyphAtlas {
+        cv::Mat mask;                   // CV_8U, 255 = ink
+        int x[95];
+        int width[95];
+        int height = 0;
+        void build(double scale, int thickness);
+    };
+
+    cv::Size captureSize;
+    cv::Size displaySize;
+    float scaleX;
+    float scaleY;
+    float fontScale;
+    int thickness;
+
+    int frameCount;
+    float lastFPS;
+    std::chrono::steady_clock::time_point startTime;
+
+    struct ColorScheme {
+        cv::Scalar idle;
+        cv::Scalar verifying;
+        cv::Scalar real;
+        cv::Scalar spoof;
+        cv::Scalar warning;
+        cv::Scalar info;
+    } colors;
+
+    GlyphAtlas smallFont;
+    cv::Mat statusLabels[(int)DisplayStatus::COUNT];   // text on a filled badge
+    cv::Mat warningLabel;
+    char textBuffer[96];
+
+    const cv::Scalar& statusColor(DisplayStatus status) const;
+    cv::Mat buildLabel(const char* text, const cv::Scalar& background, const cv::Scalar& foreground) const;
+    void drawLabel(cv::Mat& frame, const cv::Mat& label, cv::Point topLeft);
+    void drawText(cv::Mat& frame, const char* text, cv::Point topLeft, const cv::Scalar& color);
+
+    void drawFaceBox(cv::Mat& frame, const cv::Rect& box, DisplayStatus status);
+    void drawStatusText(cv::Mat& frame, const cv::Rect& box, DisplayStatus status, int trackId);
+    void drawScoreInfo(cv::Mat& frame, const cv::Rect& box,
+                      float aiScore, float physicalScore, float finalScore);
+    void drawFPSCounter(cv::Mat& frame, float fps);
+    void drawProgressBar(cv::Mat& frame, const cv::Rect& box,
+                        int consecutive, int threshold, DisplayStatus status);
+    void drawWarningMessage(cv::Mat& frame);
+
+public:
+    Layer5Visualization();
+    ~Layer5Visualization();
+
+    // Rebuilds the glyph atlas / labels only when the display size changes
+    void init(const cv::Size& captureSize, const cv::Size& displaySize);
+    bool isReady(const cv::Size& capture, const cv::Size& display) const {
+        return capture == captureSize && display == displaySize && !smallFont.mask.empty();
+    }
+    // Frames per second over ~1 s windows, call once per shown frame
+    void updateFPS(float& outFPS);
+    // One face (box, status badge, scores, progress, landmarks) on a displaySize frame
+    void render(cv::Mat& frame, const VisualizationData& data);
+    // Every face of a frame + FPS; "show your face" when there is none
+    void renderFrame(cv::Mat& frame, const std::vector<VisualizationData>& faces, float fps);
+    void drawLandmarks(cv::Mat& frame, const std::vector<cv::Point2f>& landmarks);
+    void drawDebugGrid(cv::Mat& frame);
+    float getFontScale() const { return fontScale; }
+    int getThickness() const { return thickness; }
+};
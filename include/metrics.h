@@ -0,0 +1,96 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/metrics.h (Per-stage latency metrics + tracing)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+enum class MetricStage {
+    CAPTURE,
+    DETECT,
+    LIVENESS_FORWARD,
+    CUE_COLOR,
+    CUE_TEXTURE,
+    CUE_EDGES,
+    CUE_MOIRE,
+    CUE_HIGH_FREQ,
+    DISPLAY,
+    COUNT
+};
+
+const char* metricStageName(MetricStage stage);
+
+struct MetricsExportConfig {
+    std::string filePath;       // Prometheus text, rewritten every intervalSec (empty = off)
+    int intervalSec = 5;
+    int httpPort = 0;           // GET /metrics on 127.0.0.1:port (0 = off)
+};
+
+// Every thread records into its own histograms (single writer, relaxed atomics),
+// the exporter merges them on read. Histograms are log-linear (HDR style):
+// 1 us steps below 64 us, then 32 sub-buckets per power of two (about 3%
+// relative error) up to 2^32 us (~72 min); anything longer lands in the last bucket.
+class Metrics {
+public:
+    static void record(MetricStage stage, uint64_t startNs, uint64_t durationNs);
+    static uint64_t nowNs() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static void writePrometheus(std::ostream& out);
+    static bool startExporter(const MetricsExportConfig& config);
+    static void stopExporter();
+
+    // Chrome trace-event JSON (chrome://tracing, Perfetto); the first
+    // eventsPerThread events of each thread are kept
+    static void enableTrace(size_t eventsPerThread = 1 << 16);
+    static bool writeChromeTrace(const std::string& path);
+};
+
+// Exporter threads are global and joinable: stopping them on every way out of
+// main() (early returns included) keeps the process from std::terminate
+class MetricsExporterScope {
+public:
+    MetricsExporterScope() : started(false) {}
+    ~MetricsExporterScope() { if (started) Metrics::stopExporter(); }
+    bool start(const MetricsExportConfig& config) { return started = Metrics::startExporter(config); }
+
+private:
+    bool started;
+};
+
+// Timers of this thread record nothing while alive (warm-up passes: their
+// cold-start latencies would skew the histograms, the export and the trace)
+class MetricsPause {
+public:
+    MetricsPause();
+    ~MetricsPause();
+    MetricsPause(const MetricsPause&) = delete;
+    MetricsPause& operator=(const MetricsPause&) = delete;
+};
+
+class MetricsScope {
+public:
+    explicit MetricsScope(MetricStage stage) : stage(stage), start(Metrics::nowNs()) {}
+    ~MetricsScope() { Metrics::record(stage, start, Metrics::nowNs() - start); }
+    MetricsScope(const MetricsScope&) = delete;
+    MetricsScope& operator=(const MetricsScope&) = delete;
+
+private:
+    MetricStage stage;
+    uint64_t start;
+};
+
+// Hot-path timer: compiled out entirely with -DENABLE_METRICS=OFF
+#define FACE_METRICS_CONCAT_(a, b) a##b
+#define FACE_METRICS_CONCAT(a, b) FACE_METRICS_CONCAT_(a, b)
+#ifdef FACE_WITH_METRICS
+#define FACE_SCOPED_TIMER(stage) MetricsScope FACE_METRICS_CONCAT(faceMetricsScope, __LINE__)(stage)
+#else
+#define FACE_SCOPED_TIMER(stage) do {} while (0)
+#endif
@@ -0,0 +1,51 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/model_bundle.h (mmap'ed model bundle, fast cold start)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "inference_backend.h"
+
+// File layout (host endianness, every payload page-aligned so the mapping
+// can be handed out as is):
+//   [Header 16 B]["FMB1", version, count, 0]
+//   [Entry 128 B] x count: name[112] (file name), offset, size
+//   payloads
+// The whole file is mmap'ed read-only with MADV_WILLNEED; models are parsed
+// from memory, no per-model open/read.
+class ModelBundle {
+public:
+    ModelBundle();
+    ~ModelBundle();
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return mapping != nullptr; }
+    size_t getModelCount() const { return entries.size(); }
+
+    // models/MiniFASNetV2.onnx -> MiniFASNetV2_int8 (preferInt8) -> .ort (ONNX Runtime) -> .onnx
+    bool find(const std::string& modelPath, const BackendOptions& options, ModelBlob& out) const;
+
+    // modelPath plus the _int8 / .ort siblings that exist next to it
+    static std::vector<std::string> variants(const std::string& modelPath);
+    // Files go in under their file name; missing files are skipped with a warning
+    static bool pack(const std::vector<std::string>& files, const std::string& outPath);
+
+private:
+    struct Mapping;
+    struct Entry {
+        std::string name;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    bool lookup(const std::string& name, ModelBlob& out) const;
+
+    std::shared_ptr<Mapping> mapping;
+    std::vector<Entry> entries;
+};
@@ -0,0 +1,66 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/offline_runner.h (Headless batch scoring + benchmark)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "layer1_capture.h"
+#include "layer2_detection.h"
+#include "frame_analyzer.h"
+#include "decision_events.h"
+
+struct OfflineConfig {
+    std::string inputPath;     // video file, image directory or manifest
+    std::string outputPath;    // .csv or .jsonl, empty = no per-frame output
+    long maxFrames = -1;
+};
+
+class LatencyStats {
+public:
+    void add(double ms) { samples.push_back(ms); sorted = false; }
+    double percentile(double p);
+    double mean() const;
+    size_t count() const { return samples.size(); }
+
+private:
+    std::vector<double> samples;
+    bool sorted = false;
+};
+
+// Runs layers 2-4 at full speed without any highgui call, then reports
+// FPS, per-stage p50/p95/p99 latency and peak RSS
+class OfflineRunner {
+public:
+    OfflineRunner(Layer1Capture& source, Layer2Detection& detector, FrameAnalyzer& analyzer);
+    bool run(const OfflineConfig& config);
+    // Decision events per face (seq = frame index), nullptr = none
+    void setEventSink(DecisionEventSink* sink) { events = sink; }
+
+private:
+    void writeFrame(long index, const std::vector<FaceResult>& faces,
+                    const std::vector<FaceAnalysis>& analyses);
+    void printReport(long frames, double seconds);
+
+    // ALLOC_DEBUG builds: heap allocations inside analyze() once the buffers are sized
+    static constexpr long allocWarmupFrames = 30;
+
+    Layer1Capture& source;
+    Layer2Detection& detector;
+    FrameAnalyzer& analyzer;
+    DecisionEventSink* events;
+
+    std::ofstream out;
+    bool jsonl;
+
+    LatencyStats decodeStats;
+    LatencyStats detectStats;
+    LatencyStats livenessStats;
+    LatencyStats qualityStats;
+    LatencyStats totalStats;
+    uint64_t steadyAllocations;
+    long steadyFrames;
+};
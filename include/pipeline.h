@@ -0,0 +1,94 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/pipeline.h (Multi-threaded staged pipeline)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include "spsc_ring.h"
+#include "layer1_capture.h"
+#include "layer2_detection.h"
+#include "layer3_liveness.h"
+#include "layer4_hybrid.h"
+#include "anti_spoof_decision.h"
+#include "frame_analyzer.h"
+#include "video_frame.h"
+#include "decision_events.h"
+#include "qos_governor.h"
+
+struct PipelineConfig {
+    DropPolicy dropPolicy = DropPolicy::DROP_WHEN_FULL;
+    size_t queueCapacity = 4;
+    int statsIntervalFrames = 300;   // 0 = never print queue stats
+    std::string windowName = "Anti-Spoofing Pro v2.2";
+    bool headless = false;                  // no window, stop with Ctrl+C or at end of source
+    WorkStealingPool* executor = nullptr;   // parallel Layer3 || Layer4 cues, nullptr = sequential
+    CascadeConfig cascade;                  // early-exit stage cascade (off by default)
+    DecisionEventSink* events = nullptr;    // structured decisions, nullptr = none
+    size_t arenaBytes = 8 << 20;            // Layer3/Layer4 frame scratch arena, 0 = heap Mats
+    QosConfig qos;                          // latency SLO governor (off by default)
+    std::chrono::steady_clock::time_point startTime;   // process start, time-to-first-decision log (unset = none)
+};
+
+// One frame travelling through the stages, faces/analyses are index-aligned
+struct FrameSlot {
+    uint64_t seq = 0;
+    std::chrono::steady_clock::time_point captureTime;
+    VideoFrame frame;     // native layout, BGR built lazily
+    std::vector<FaceResult> faces;
+    std::vector<FaceAnalysis> analyses;
+};
+
+class DisplayRenderer;
+
+// capture -> detect -> liveness (L3 + L4 + decision) -> display
+// Each stage runs on its own thread. Display is a separate render thread fed
+// newest-wins (DisplayRenderer), the calling thread only supervises.
+class Pipeline {
+public:
+    Pipeline(Layer1Capture& camera, Layer2Detection& detector,
+             Layer3Liveness& liveness, Layer4Hybrid& hybrid);
+    ~Pipeline();
+
+    void run(const PipelineConfig& config);
+    void stop();
+    void printStats() const;
+
+private:
+    void captureLoop();
+    void detectLoop();
+    void livenessLoop();
+    void join();
+    // Each stage applies its own knobs of the governor's level
+    void applyDetectLevel(int level);
+    void applyLivenessLevel(int level);
+
+    Layer1Capture& camera;
+    Layer2Detection& detector;
+
+    PipelineConfig config;
+    // Owned by the liveness thread
+    FrameAnalyzer analyzer;
+    // observe() on the liveness thread, level read by detect + liveness
+    QosGovernor governor;
+    int baseKeyframeInterval;
+
+    std::unique_ptr<SpscRing<FrameSlot>> captureToDetect;
+    std::unique_ptr<SpscRing<FrameSlot>> detectToLiveness;
+    // nullptr when headless
+    std::unique_ptr<DisplayRenderer> display;
+
+    std::thread captureThread;
+    std::thread detectThread;
+    std::thread livenessThread;
+
+    std::atomic<bool> running;
+    std::atomic<bool> resetRequested;
+    std::atomic<bool> livenessDone;
+    std::atomic<uint64_t> processed;
+};
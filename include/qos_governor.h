@@ -0,0 +1,72 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/qos_governor.h (Latency SLO governor, graceful degradation)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One rung of the quality ladder. 0 / all-ones = what the command line configured.
+struct QosLevel {
+    int detectInputWidth = 0;      // cap on the YuNet input width (px), 0 = no cap
+    unsigned cueMask = ~0u;        // Layer4 cues that run (Layer4Hybrid::cueBit)
+    int livenessModels = 0;        // first N ensemble models, 0 = all
+    int keyframeInterval = 0;      // YuNet at least every N frames (tracking between), 0 = as configured
+};
+
+struct QosConfig {
+    bool enabled = false;
+    double targetP95Ms = 50.0;     // capture -> decision
+    int windowFrames = 30;         // p95 over this many frames, one decision per window
+    double recoverRatio = 0.6;     // step up only when p95 < target * ratio ...
+    int recoverWindows = 3;        // ... for this many windows in a row
+    std::vector<QosLevel> levels;  // [0] = full quality, empty = defaultLevels()
+};
+
+// Watches end-to-end latency and walks the level ladder: one step down as soon
+// as a window misses the target, one step up after several calm windows (the
+// gap between target and target * recoverRatio is the hysteresis band).
+// observe() runs on one thread; getLevel() may be read from any stage, each
+// stage applies its own knobs when the level it last saw changes. The counters
+// are relaxed atomics, printStats() runs on the supervisor.
+class QosGovernor {
+public:
+    QosGovernor();
+
+    void setConfig(const QosConfig& config);
+    const QosConfig& getConfig() const { return config; }
+    bool isEnabled() const { return config.enabled; }
+
+    // Latency of one finished frame; true when the level changed
+    bool observe(double latencyMs);
+
+    int getLevel() const { return level.load(std::memory_order_acquire); }
+    const QosLevel& getLevelConfig(int index) const { return config.levels[index]; }
+    int getLevelCount() const { return (int)config.levels.size(); }
+    uint64_t getTransitions() const { return transitions.load(std::memory_order_relaxed); }
+
+    void printStats(const char* tag) const;
+
+    // full -> detect 640 -> + cheap cues only -> + one model, longer keyframes -> floor
+    static std::vector<QosLevel> defaultLevels();
+    static std::string describe(const QosLevel& level);
+
+private:
+    void moveTo(int next, double p95);
+
+    QosConfig config;
+    std::atomic<int> level;
+
+    std::vector<double> window;    // preallocated, reused every window
+    std::vector<double> sorted;
+    int filled;
+    int calmWindows;
+    std::atomic<double> lastP95;
+
+    std::atomic<uint64_t> transitions;
+    std::atomic<uint64_t> degrades;
+    std::vector<std::atomic<uint64_t>> framesAtLevel;   // sized by setConfig()
+};
@@ -0,0 +1,51 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/score_smoother.h (Per-track liveness score smoothing)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <cstdint>
+#include <string>
+
+enum class SmoothingPolicy {
+    WEIGHTED_WINDOW,   // newest weighs 1.8x the oldest (original behaviour)
+    EMA,               // one multiply-add per frame
+    MEDIAN             // median of the last k, robust to single-frame glitches
+};
+
+struct SmoothingConfig {
+    SmoothingPolicy policy = SmoothingPolicy::WEIGHTED_WINDOW;
+    float emaAlpha = 0.35f;   // weight of the newest score
+    int medianWindow = 5;     // k, at most ScoreHistory::capacity
+};
+
+bool parseSmoothingPolicy(const std::string& text, SmoothingPolicy& policy);
+
+// Fixed inline ring, plain data (40 bytes), no allocation per track
+struct ScoreHistory {
+    static constexpr int capacity = 8;
+    float values[capacity];
+    uint8_t start = 0;
+    uint8_t count = 0;
+    float ema = 0.0f;
+
+    void clear() { start = 0; count = 0; }
+    void push(float value);
+    // i = 0 is the oldest
+    float at(int i) const { return values[(start + i) & (capacity - 1)]; }
+};
+
+// Policy + precomputed weight table for every fill level: no pow(), no division per frame
+class ScoreSmoother {
+public:
+    explicit ScoreSmoother(const SmoothingConfig& config = SmoothingConfig());
+    void setConfig(const SmoothingConfig& config);
+    const SmoothingConfig& getConfig() const { return config; }
+
+    // Smoothed value after history.push(newest)
+    float smooth(ScoreHistory& history) const;
+
+private:
+    SmoothingConfig config;
+    float weights[ScoreHistory::capacity][ScoreHistory::capacity];   // [count - 1][i], sums to 1
+};
@@ -0,0 +1,50 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/spectral_engine.h (Real-input DFT spectral features)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <opencv2/opencv.hpp>
+
+class FrameArena;
+
+struct SpectralFeatures {
+    static constexpr int numBands = 4;
+
+    // Mean log(1 + |F|) outside the centre square (old calculateHighFrequency value)
+    double highFreqMean = 0.0;
+    // Mean log(1 + |F|) per radial band, radius normalised to Nyquist:
+    // [0, 0.125) [0.125, 0.25) [0.25, 0.5) [0.5, ...)
+    float bands[numBands] = {0, 0, 0, 0};
+};
+
+// Real -> complex DFT (CCS packed) on a fixed-size grey patch.
+// Weight/band tables are built once per size and read straight from the
+// half spectrum, so there is no complex merge, split or quadrant swap.
+class SpectralEngine {
+public:
+    explicit SpectralEngine(int side = 128);
+
+    bool compute(const cv::Mat& src, SpectralFeatures& out);
+    int getSide() const { return side; }
+    // Per-call buffers from the frame arena (the tables stay on the heap, built once)
+    void bindScratch(FrameArena& arena);
+
+private:
+    void buildTables();
+    void unpackMagnitude();
+
+    int side;
+    int halfCols;              // side / 2 + 1 columns of the half spectrum
+
+    cv::Mat resized, gray, input, spectrum;
+    cv::Mat halfLogMag;        // side x halfCols, CV_32F
+
+    // Per half-spectrum element: how many full-spectrum bins it stands for
+    // that lie outside the centre square (0, 1 or 2)
+    cv::Mat highWeights;       // CV_32F
+    cv::Mat multiplicity;      // CV_32F, 1 or 2
+    cv::Mat bandIndex;         // CV_8U
+    double highCount;
+    double bandCount[SpectralFeatures::numBands];
+};
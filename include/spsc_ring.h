@@ -0,0 +1,169 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/spsc_ring.h (Lock-free SPSC frame queue)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// DROP_WHEN_FULL: producer never waits (full -> the incoming frame is dropped),
+//                 consumer skips stale slots and takes the freshest queued one.
+//                 The producer cannot evict the oldest slot (tail belongs to the
+//                 consumer), so a full ring holds the last accepted frames.
+// BLOCK:          producer waits for a free slot, nothing is dropped.
+// Waiting (pop, BLOCK push) spins a few rounds, then sleeps until push / pop / close.
+enum class DropPolicy {
+    DROP_WHEN_FULL,
+    BLOCK
+};
+
+struct QueueCounters {
+    uint64_t pushed;
+    uint64_t popped;
+    uint64_t dropped;
+    size_t depth;
+    size_t maxDepth;
+};
+
+template <typename T>
+class SpscRing {
+public:
+    SpscRing(size_t capacity, DropPolicy policy)
+        : policy(policy), closed(false), head(0), tail(0), waiters(0),
+          pushedCount(0), poppedCount(0), droppedCount(0), maxDepthSeen(0) {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        slots.resize(cap);
+        mask = cap - 1;
+    }
+
+    // Producer side. Item is swapped into the slot so buffers (cv::Mat)
+    // circulate between stages instead of being reallocated every frame.
+    bool push(T& item) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) > mask) {
+            if (closed.load(std::memory_order_acquire)) return false;
+            if (policy == DropPolicy::DROP_WHEN_FULL) {
+                droppedCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            waitUntil([&] {
+                return closed.load(std::memory_order_acquire) || h - tail.load(std::memory_order_acquire) <= mask;
+            });
+            if (h - tail.load(std::memory_order_acquire) > mask) return false;   // closed
+        }
+        std::swap(slots[h & mask], item);
+        head.store(h + 1, std::memory_order_release);
+        pushedCount.fetch_add(1, std::memory_order_relaxed);
+        notifyWaiters();
+
+        size_t d = h + 1 - tail.load(std::memory_order_relaxed);
+        if (d > maxDepthSeen.load(std::memory_order_relaxed)) {
+            maxDepthSeen.store(d, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    // Consumer side, non blocking.
+    bool tryPop(T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        if (t == h) return false;
+
+        if (policy == DropPolicy::DROP_WHEN_FULL && h - t > 1) {
+            droppedCount.fetch_add(h - t - 1, std::memory_order_relaxed);
+            t = h - 1;
+        }
+        std::swap(item, slots[t & mask]);
+        tail.store(t + 1, std::memory_order_release);
+        poppedCount.fetch_add(1, std::memory_order_relaxed);
+        if (policy == DropPolicy::BLOCK) notifyWaiters();
+        return true;
+    }
+
+    // Consumer side, waits until an item arrives or the ring is closed and drained.
+    bool pop(T& item) {
+        while (!tryPop(item)) {
+            if (closed.load(std::memory_order_acquire) &&
+                head.load(std::memory_order_acquire) == tail.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            waitUntil([&] {
+                return closed.load(std::memory_order_acquire) ||
+                       head.load(std::memory_order_acquire) != tail.load(std::memory_order_relaxed);
+            });
+        }
+        return true;
+    }
+
+    void close() {
+        closed.store(true, std::memory_order_release);
+        notifyWaiters();
+    }
+    bool isClosed() const { return closed.load(std::memory_order_acquire); }
+
+    size_t capacity() const { return mask + 1; }
+    size_t depth() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    QueueCounters counters() const {
+        QueueCounters c;
+        c.pushed = pushedCount.load(std::memory_order_relaxed);
+        c.popped = poppedCount.load(std::memory_order_relaxed);
+        c.dropped = droppedCount.load(std::memory_order_relaxed);
+        c.depth = depth();
+        c.maxDepth = maxDepthSeen.load(std::memory_order_relaxed);
+        return c;
+    }
+
+private:
+    static const int spinRounds = 64;
+
+    template <typename Ready>
+    void waitUntil(Ready ready) {
+        for (int i = 0; i < spinRounds; ++i) {
+            if (ready()) return;
+            std::this_thread::yield();
+        }
+        std::unique_lock<std::mutex> lock(waitMutex);
+        waiters.fetch_add(1, std::memory_order_seq_cst);
+        // Pairs with the fence in notifyWaiters(): either the notifier sees the
+        // waiter, or ready() sees the notifier's store
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!ready()) wake.wait(lock);
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // One fence + one load when nobody sleeps
+    void notifyWaiters() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) == 0) return;
+        std::lock_guard<std::mutex> lock(waitMutex);
+        wake.notify_all();
+    }
+
+    std::vector<T> slots;
+    size_t mask;
+    DropPolicy policy;
+    std::atomic<bool> closed;
+
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+
+    std::mutex waitMutex;
+    std::condition_variable wake;
+    std::atomic<int> waiters;
+
+    alignas(64) std::atomic<uint64_t> pushedCount;
+    std::atomic<uint64_t> poppedCount;
+    std::atomic<uint64_t> droppedCount;
+    std::atomic<size_t> maxDepthSeen;
+};
@@ -0,0 +1,102 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/stream_server.h (Multi-camera server, shared workers)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "pipeline.h"
+#include "offline_runner.h"
+#include "inference_backend.h"
+#include "decision_events.h"
+#include "model_bundle.h"
+
+struct StreamServerConfig {
+    // "/dev/videoN" (V4L2), "N" (OpenCV camera index) or video file / image dir / manifest
+    std::vector<std::string> sources;
+    int workers = 2;               // each worker owns one detector + one liveness + one Layer4
+    int maxBatchStreams = 4;       // frames of up to N streams share one Layer3 forward pass
+    size_t queueCapacity = 2;      // per stream, capture -> workers
+    DropPolicy dropPolicy = DropPolicy::DROP_WHEN_FULL;
+    long maxFrames = -1;           // per stream
+    int statsIntervalSec = 5;      // 0 = report only at the end
+    std::string detectorPath = "models/face_detection_yunet_2023mar.onnx";
+    std::vector<LivenessModelSpec> models;
+    BackendOptions backend;
+    SmoothingConfig smoothing;
+    DecisionEventSink* events = nullptr;   // streamId = index in sources
+    size_t arenaBytes = 8 << 20;           // per worker Layer3/Layer4 scratch arena, 0 = heap Mats
+    const ModelBundle* bundle = nullptr;   // mmap'ed models, nullptr = models/ files
+};
+
+// One process, N capture sources, W shared inference workers (W copies of the
+// weights instead of N). A stream is claimed by at most one worker at a time,
+// so its tracks / decisions stay in order; workers start their scan at a
+// rotating stream index, so no stream is starved by a faster one.
+class StreamServer {
+public:
+    StreamServer();
+    ~StreamServer();
+
+    bool init(const StreamServerConfig& config);
+    // Runs until every source ended or SIGINT
+    void run();
+    void stop();
+    void printStats(bool final);
+
+private:
+    struct Stream {
+        int index = 0;
+        std::string source;
+        Layer1Capture camera;
+        std::unique_ptr<SpscRing<FrameSlot>> queue;
+        std::thread captureThread;
+        std::atomic<bool> claimed{false};
+        std::atomic<bool> ended{false};
+        FrameAnalyzer analyzer;     // per-stream tracks + decisions
+        FrameSlot work;             // frame being scored by the claiming worker
+
+        std::mutex statsMutex;
+        LatencyStats windowLatency; // capture -> decision, since the last report
+        LatencyStats totalLatency;
+        uint64_t windowFrames = 0;
+        uint64_t totalFrames = 0;
+        uint64_t totalFaces = 0;
+    };
+
+    struct Worker {
+        Layer2Detection detector;
+        Layer3Liveness liveness;
+        Layer4Hybrid hybrid;
+        std::thread thread;
+
+        std::vector<Stream*> batch;
+        std::vector<const VideoFrame*> frames;
+        std::vector<int> frameOf;
+        std::vector<cv::Rect> boxes;
+        std::vector<LivenessTrackState*> states;
+        std::vector<LivenessResult> results;
+        // Last member: destroyed first, while liveness / hybrid still exist
+        std::unique_ptr<FrameArena> arena;
+    };
+
+    bool openStream(Stream& stream);
+    void captureLoop(Stream& stream);
+    void workerLoop(Worker& worker);
+    bool claimBatch(Worker& worker);
+    void scoreBatch(Worker& worker);
+
+    StreamServerConfig config;
+    std::vector<std::unique_ptr<Stream>> streams;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<bool> running;
+    std::atomic<uint32_t> cursor;
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::time_point windowStart;
+};
@@ -0,0 +1,94 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/task_pool.h (Work-stealing pool + task graph)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Plain function + context, no std::function so spawning does not allocate
+typedef void (*TaskFn)(void* ctx, int arg);
+
+struct TaskGroup {
+    std::atomic<int> pending{0};
+};
+
+// Each worker pushes / pops its own deque at the back (LIFO, cache-warm) and
+// steals from the front of the others when it runs dry. Threads outside the
+// pool submit into a shared injection queue; wait() lets the caller execute
+// tasks too, so a frame never idles while its tasks are queued.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(int threads = 0);   // 0 = defaultThreads()
+    ~WorkStealingPool();
+
+    void spawn(TaskGroup& group, TaskFn fn, void* ctx, int arg = 0);
+    void wait(TaskGroup& group);
+    int size() const { return (int)threads.size(); }
+    // Half the hardware threads, the rest is left to OpenCV's parallel_for_
+    static int defaultThreads();
+
+private:
+    struct Task {
+        TaskFn fn;
+        void* ctx;
+        int arg;
+        TaskGroup* group;
+    };
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    int currentWorker() const;
+    bool popLocal(int self, Task& task);
+    bool steal(int self, Task& task);
+    void execute(Task& task);
+    void workerLoop(int index);
+
+    std::vector<std::unique_ptr<Queue>> queues;   // one per worker + injection queue (last)
+    std::vector<std::thread> threads;
+    std::atomic<bool> stopping;
+    std::atomic<int> queued;
+    std::mutex sleepMutex;
+    std::condition_variable wake;   // workers: a task was queued
+    std::condition_variable idle;   // wait(): a task was queued or a group finished
+    int blockedWaiters;             // guarded by sleepMutex
+};
+
+// Small DAG rebuilt per frame: add() nodes, precede() edges, run() blocks until
+// every node finished. Nodes start as soon as their last predecessor is done.
+class TaskGraph {
+public:
+    TaskGraph() : nodeCount(0), pool(nullptr) {}
+
+    int add(TaskFn fn, void* ctx, int arg = 0);
+    void precede(int before, int after);
+    void run(WorkStealingPool& executor);
+    void clear() { nodeCount = 0; }
+    int size() const { return nodeCount; }
+
+private:
+    struct Node {
+        TaskFn fn;
+        void* ctx;
+        int arg;
+        int dependencies;
+        std::vector<int> successors;
+    };
+
+    static void runNode(void* graph, int node);
+
+    std::vector<Node> nodes;   // kept across clear(), successor lists keep their capacity
+    std::unique_ptr<std::atomic<int>[]> remaining;
+    size_t remainingCapacity = 0;
+    int nodeCount;
+    WorkStealingPool* pool;
+    TaskGroup group;
+};
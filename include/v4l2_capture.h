@@ -0,0 +1,88 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/v4l2_capture.h (Zero-copy V4L2 mmap capture)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class V4L2PixelFormat {
+    YUYV,
+    MJPEG
+};
+
+struct V4L2Config {
+    std::string device = "/dev/video2";
+    int width = 1280;
+    int height = 720;
+    int fps = 30;
+    bool preferMjpeg = true;   // falls back to YUYV when the driver refuses
+    int bufferCount = 4;
+};
+
+// Native capture: VIDIOC_REQBUFS mmap buffers handed out as cv::Mat views.
+// A raw view holds its driver buffer until the last Mat referencing it is
+// released, then the buffer is queued back (VIDIOC_QBUF). Works against real
+// cameras and v4l2loopback; openFile() is a file-backed stand-in that serves
+// packed YUYV frames from an mmapped file through the same buffer rules.
+class V4L2Capture : public cv::MatAllocator {
+public:
+    V4L2Capture();
+    ~V4L2Capture();
+
+    bool open(const V4L2Config& config);
+    // Raw YUYV frames back to back (width * height * 2 bytes each), looped, paced at fps (0 = unthrottled)
+    bool openFile(const std::string& path, int width, int height, int fps = 30);
+    void close();
+    bool isOpened() const { return opened; }
+
+    // YUYV: CV_8UC2 height x width, MJPEG: CV_8UC1 1 x bytesused. Read-only.
+    bool grab(cv::Mat& raw);
+    // Decode / convert a raw view into bgr (bgr keeps its buffer when the size matches)
+    bool toBGR(const cv::Mat& raw, cv::Mat& bgr) const;
+
+    V4L2PixelFormat getFormat() const { return format; }
+    cv::Size getSize() const { return frameSize; }
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override;
+    bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags,
+                  cv::UMatUsageFlags usageFlags) const override;
+    void deallocate(cv::UMatData* data) const override;
+
+private:
+    struct Buffer {
+        void* start = nullptr;
+        size_t length = 0;
+        std::unique_ptr<cv::UMatData> u;
+        std::atomic<bool> held{false};   // a raw view is alive downstream
+    };
+
+    bool grabDevice(cv::Mat& raw);
+    bool grabFile(cv::Mat& raw);
+    void wrap(int index, cv::Mat& raw, int rows, int cols, int type, size_t step, size_t bytes);
+    void requeue(int index) const;
+
+    bool opened;
+    bool fileBacked;
+    int fd;
+    V4L2PixelFormat format;
+    cv::Size frameSize;
+    size_t bytesPerLine;
+
+    std::unique_ptr<Buffer[]> buffers;
+    int bufferCount;
+
+    // File-backed stand-in
+    void* fileMap;
+    size_t fileSize;
+    size_t fileFrames;
+    size_t fileFrameIndex;
+    std::chrono::steady_clock::duration framePeriod;
+    std::chrono::steady_clock::time_point nextFrameTime;
+};
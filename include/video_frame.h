@@ -0,0 +1,50 @@
+// ========================== Nguyen Hien ==========================
+// FILE: include/video_frame.h (Native-format frame: BGR or YUYV)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#pragma once
+#include <opencv2/opencv.hpp>
+
+enum class PixelLayout {
+    BGR,
+    YUYV     // CV_8UC2, channel 0 = Y of every pixel, channel 1 = U/V alternating
+};
+
+// A frame as the camera delivered it. Grey comes straight from the Y samples,
+// BGR is produced only when asked for: per region for crops, or once for the
+// whole frame (cached with the frame, e.g. for the detector or the display).
+// One stage owns a frame at a time, so the lazy cache needs no locking.
+class VideoFrame {
+public:
+    VideoFrame();
+
+    void setBGR(const cv::Mat& bgr);
+    void setYUYV(const cv::Mat& yuyv);
+    void release();
+
+    bool empty() const { return native.empty(); }
+    cv::Size size() const { return native.size(); }
+    PixelLayout getLayout() const { return layout; }
+    const cv::Mat& getNative() const { return native; }
+
+    // Whole frame in BGR (converted on first call, reused afterwards)
+    const cv::Mat& bgr() const;
+    cv::Mat& bgrForDrawing();
+    bool hasBGR() const { return layout == PixelLayout::BGR || bgrValid; }
+
+    // Whole frame grey (YUYV: Y samples, no colour math)
+    void gray(cv::Mat& out) const;
+    // Region in BGR: a view when BGR exists, otherwise only the region is converted
+    // (then out points into a buffer reused by the next bgrRegion call)
+    void bgrRegion(const cv::Rect& region, cv::Mat& out) const;
+    // Native-layout view of a region (YUYV regions are widened to even x / width)
+    cv::Mat nativeRegion(cv::Rect& region) const;
+
+private:
+    PixelLayout layout;
+    cv::Mat native;
+    mutable cv::Mat bgrCache;
+    mutable bool bgrValid;
+    mutable cv::Mat regionBuffer;
+};
@@ -0,0 +1,141 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/anti_spoof_decision.cpp (BALANCED ANTI-SPOOFING)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "anti_spoof_decision.h"
+#include <algorithm>
+
+const char* decisionStateName(DecisionState state) {
+    switch (state) {
+        case DecisionState::REAL:    return "REAL";
+        case DecisionState::FAKE:    return "FAKE";
+        case DecisionState::TOO_FAR: return "TOO_FAR";
+        default:                     return "ANALYZING";
+    }
+}
+
+AntiSpoofDecision::AntiSpoofDecision() {
+    reset();
+}
+
+void AntiSpoofDecision::reset() {
+    realConsecutive = 0;
+    spoofConsecutive = 0;
+    lastRealScore = -1.0f;
+    suddenDropCount = 0;
+    confidenceAccumulator = 0.0f;
+}
+
+void AntiSpoofDecision::manualReset() {
+    realConsecutive = 0;
+    spoofConsecutive = 0;
+    confidenceAccumulator = 0.0f;
+}
+
+float AntiSpoofDecision::fuseScore(float livenessScore, float adjustment, const DecisionParams& p) {
+    float finalScore = livenessScore * p.livenessWeight + adjustment * p.adjustmentWeight;
+
+    if (adjustment < p.penaltyStrongBelow) {
+        finalScore *= p.penaltyStrong;
+    } else if (adjustment < p.penaltyBelow) {
+        finalScore *= p.penalty;
+    }
+
+    return std::max(0.0f, std::min(1.0f, finalScore));
+}
+
+bool AntiSpoofDecision::isStrongReal(float livenessScore, float adjustment, const DecisionParams& p) {
+    return fuseScore(livenessScore, adjustment, p) > p.strongRealScore &&
+           livenessScore > p.strongRealLiveness && adjustment > p.strongRealAdjustment;
+}
+
+bool AntiSpoofDecision::isStrongFake(float livenessScore, float adjustment, const DecisionParams& p) {
+    return fuseScore(livenessScore, adjustment, p) < p.strongFakeScore ||
+           adjustment < p.strongFakeAdjustment || livenessScore < p.strongFakeLiveness;
+}
+
+DecisionOutput AntiSpoofDecision::update(float livenessScore, float rawScore, float adjustment,
+                                         const DecisionParams& p) {
+    float finalScore = fuseScore(livenessScore, adjustment, p);
+
+    if (lastRealScore > p.dropFrom && rawScore < p.dropTo) {
+        suddenDropCount++;
+        if (suddenDropCount >= p.dropFrames) {
+            finalScore = std::min(finalScore, p.dropCap);
+            spoofConsecutive = std::max(spoofConsecutive, 2);
+        }
+    } else if (rawScore > p.dropRecover) {
+        suddenDropCount = 0;
+    }
+
+    bool isStrongReal = (finalScore > p.strongRealScore && livenessScore > p.strongRealLiveness &&
+                         adjustment > p.strongRealAdjustment);
+    bool isWeakReal = (finalScore > p.weakRealScore && livenessScore > p.weakRealLiveness &&
+                       adjustment > p.weakRealAdjustment);
+    bool isStrongFake = (finalScore < p.strongFakeScore || adjustment < p.strongFakeAdjustment ||
+                         livenessScore < p.strongFakeLiveness);
+    bool isWeakFake = (finalScore < p.weakFakeScore && livenessScore < p.weakFakeLiveness &&
+                       adjustment < p.weakFakeAdjustment);
+
+    if (isStrongReal || isWeakReal) {
+        realConsecutive++;
+        spoofConsecutive = 0;
+        lastRealScore = finalScore;
+
+        if (isStrongReal) {
+            confidenceAccumulator += p.strongRealCredit;
+        } else {
+            confidenceAccumulator += p.weakRealCredit;
+        }
+    } else {
+        realConsecutive = 0;
+        confidenceAccumulator = 0.0f;
+
+        if (isStrongFake || isWeakFake) {
+            spoofConsecutive++;
+            lastRealScore = -1.0f;
+        }
+    }
+
+    DecisionOutput out;
+    out.finalScore = finalScore;
+    out.realStreak = realConsecutive;
+    out.spoofStreak = spoofConsecutive;
+
+    // REAL:
+    if (realConsecutive >= p.confirmFrames && confidenceAccumulator >= p.realConfidence) {
+        out.state = DecisionState::REAL;
+    }
+    // FAKE:
+    else if (spoofConsecutive >= p.confirmFrames || isStrongFake) {
+        out.state = DecisionState::FAKE;
+    }
+    // Analyzing
+    else {
+        out.state = DecisionState::ANALYZING;
+    }
+    return out;
+}
+
+DecisionOutput AntiSpoofDecision::updateWithoutLiveness(float adjustment, const DecisionParams& p) {
+    DecisionOutput out;
+    out.finalScore = fuseScore(1.0f, adjustment, p);
+
+    if (isStrongFake(1.0f, adjustment, p)) {
+        realConsecutive = 0;
+        confidenceAccumulator = 0.0f;
+        spoofConsecutive++;
+        lastRealScore = -1.0f;
+        out.state = DecisionState::FAKE;
+    } else if (realConsecutive >= p.confirmFrames && confidenceAccumulator >= p.realConfidence) {
+        out.state = DecisionState::REAL;
+    } else if (spoofConsecutive >= p.confirmFrames) {
+        out.state = DecisionState::FAKE;
+    } else {
+        out.state = DecisionState::ANALYZING;
+    }
+    out.realStreak = realConsecutive;
+    out.spoofStreak = spoofConsecutive;
+    return out;
+}
@@ -0,0 +1,141 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/backend_parity.cpp (Backend / INT8 accuracy gate)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "backend_parity.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include "layer1_capture.h"
+#include "layer2_detection.h"
+#include "offline_runner.h"
+
+namespace {
+double elapsedMs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+float iou(const cv::Rect& a, const cv::Rect& b) {
+    int inter = (a & b).area();
+    int uni = a.area() + b.area() - inter;
+    return uni > 0 ? (float)inter / uni : 0.0f;
+}
+}
+
+int runBackendParity(const ParityConfig& config) {
+    Layer1Capture source;
+    if (!source.openSource(config.inputPath)) {
+        std::cerr << "[Parity] ERROR: Cannot open " << config.inputPath << std::endl;
+        return 1;
+    }
+
+    // Reference detector decides the faces, both liveness runs score the same boxes
+    Layer2Detection refDetector;
+    Layer2Detection candDetector;
+    candDetector.setBackend(config.candidate);
+    Layer3Liveness reference;
+    Layer3Liveness candidate;
+    candidate.setBackend(config.candidate);
+    if (!refDetector.init(config.detectorPath) || !candDetector.init(config.detectorPath) ||
+        !reference.init(config.models) || !candidate.init(config.models)) {
+        std::cerr << "[Parity] ERROR: Model init failed" << std::endl;
+        return 1;
+    }
+
+    cv::Mat frame;
+    std::vector<FaceResult> refFaces;
+    std::vector<FaceResult> candFaces;
+    std::vector<cv::Rect> boxes;
+    std::vector<LivenessTrackState> refStates;
+    std::vector<LivenessTrackState> candStates;
+    std::vector<LivenessTrackState*> refPtrs;
+    std::vector<LivenessTrackState*> candPtrs;
+    std::vector<LivenessResult> refOut;
+    std::vector<LivenessResult> candOut;
+    LatencyStats refLatency;
+    LatencyStats candLatency;
+
+    long frames = 0;
+    long faces = 0;
+    long flips = 0;
+    long detectorMisses = 0;
+    double sumDiff = 0.0;
+    float maxDiff = 0.0f;
+
+    while ((config.maxFrames < 0 || frames < config.maxFrames) && source.grabFrame(frame)) {
+        ++frames;
+        refDetector.detectAll(frame, refFaces);
+        candDetector.detectAll(frame, candFaces);
+        if (refFaces.empty()) continue;
+
+        boxes.clear();
+        for (const FaceResult& face : refFaces) {
+            boxes.push_back(face.bbox);
+            bool matched = false;
+            for (const FaceResult& other : candFaces) {
+                if (iou(face.bbox, other.bbox) >= 0.5f) { matched = true; break; }
+            }
+            if (!matched) ++detectorMisses;
+        }
+
+        // Fresh state per face: compare raw model output, not smoothed history
+        refStates.assign(boxes.size(), LivenessTrackState());
+        candStates.assign(boxes.size(), LivenessTrackState());
+        refPtrs.clear();
+        candPtrs.clear();
+        for (size_t i = 0; i < boxes.size(); ++i) {
+            refStates[i].reset();
+            candStates[i].reset();
+            refPtrs.push_back(&refStates[i]);
+            candPtrs.push_back(&candStates[i]);
+        }
+
+        auto t0 = std::chrono::steady_clock::now();
+        bool refOk = reference.checkLivenessBatch(frame, boxes, refPtrs, refOut);
+        double refMs = elapsedMs(t0);
+        t0 = std::chrono::steady_clock::now();
+        bool candOk = candidate.checkLivenessBatch(frame, boxes, candPtrs, candOut);
+        double candMs = elapsedMs(t0);
+        if (!refOk || !candOk) continue;
+
+        for (size_t i = 0; i < boxes.size(); ++i) {
+            if (refOut[i].rawScore < 0.0f || candOut[i].rawScore < 0.0f) continue;
+            float diff = std::fabs(refOut[i].rawScore - candOut[i].rawScore);
+            sumDiff += diff;
+            maxDiff = std::max(maxDiff, diff);
+            if ((refOut[i].rawScore > 0.5f) != (candOut[i].rawScore > 0.5f)) ++flips;
+            ++faces;
+        }
+        refLatency.add(refMs / boxes.size());
+        candLatency.add(candMs / boxes.size());
+    }
+
+    if (faces == 0) {
+        std::cerr << "[Parity] ERROR: No faces scored in " << frames << " frames" << std::endl;
+        return 1;
+    }
+
+    double meanDiff = sumDiff / faces;
+    double refP50 = refLatency.percentile(50);
+    double candP50 = candLatency.percentile(50);
+    std::cout << std::fixed << std::setprecision(4)
+              << "[Parity] INFO: opencv/fp32 vs " << backendKindName(config.candidate.kind)
+              << (config.candidate.preferInt8 ? "/int8" : "/fp32") << std::endl
+              << "  frames " << frames << ", faces " << faces << std::endl
+              << "  |score diff| mean " << meanDiff << ", max " << maxDiff << std::endl
+              << "  decision flips " << flips << ", detector misses " << detectorMisses << std::endl
+              << std::setprecision(2)
+              << "  per-face p50 " << refP50 << " ms -> " << candP50 << " ms"
+              << " (x" << (candP50 > 0.0 ? refP50 / candP50 : 0.0) << ")" << std::endl;
+
+    if (meanDiff > config.tolerance) {
+        std::cerr << "[Parity] ERROR: Mean score drift " << meanDiff
+                  << " exceeds tolerance " << config.tolerance << std::endl;
+        return 1;
+    }
+    std::cout << "[Parity] INFO: PASS" << std::endl;
+    return 0;
+}
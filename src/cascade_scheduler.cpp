@@ -0,0 +1,88 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/cascade_scheduler.cpp (Early-exit stage cascade)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "cascade_scheduler.h"
+#include <iostream>
+#include <sstream>
+
+bool parseCascadeOrder(const std::string& text, std::vector<CascadeStage>& order) {
+    std::vector<CascadeStage> parsed;
+    std::stringstream ss(text);
+    std::string name;
+    while (std::getline(ss, name, ',')) {
+        CascadeStage stage;
+        if (name == "cheap") stage = CascadeStage::CHEAP_CUES;
+        else if (name == "liveness") stage = CascadeStage::LIVENESS;
+        else if (name == "deep") stage = CascadeStage::DEEP_CUES;
+        else return false;
+        for (CascadeStage s : parsed) {
+            if (s == stage) return false;
+        }
+        parsed.push_back(stage);
+    }
+    if (parsed.empty()) return false;
+    order = parsed;
+    return true;
+}
+
+unsigned CascadeScheduler::stageCues(CascadeStage stage) {
+    switch (stage) {
+        case CascadeStage::CHEAP_CUES:
+            return Layer4Hybrid::cueBit(Layer4Hybrid::CUE_COLOR) | Layer4Hybrid::cueBit(Layer4Hybrid::CUE_EDGES);
+        case CascadeStage::DEEP_CUES:
+            return Layer4Hybrid::cueBit(Layer4Hybrid::CUE_TEXTURE) | Layer4Hybrid::cueBit(Layer4Hybrid::CUE_MOIRE) |
+                   Layer4Hybrid::cueBit(Layer4Hybrid::CUE_HIGH_FREQ);
+        default:
+            return 0;
+    }
+}
+
+CascadeVerdict CascadeScheduler::check(const QualityCues& cues, unsigned knownMask, bool hasLiveness,
+                                       float livenessScore, float& exitAdjustment,
+                                       const DecisionParams& p) const {
+    // Bounds and verdicts from the same parameter set
+    float adjLo = 0.0f;
+    float adjHi = 0.0f;
+    Layer4Hybrid::adjustmentBounds(cues, knownMask, adjLo, adjHi, p);
+    float liveLo = hasLiveness ? livenessScore : 0.0f;
+    float liveHi = hasLiveness ? livenessScore : 1.0f;
+
+    // Strong verdicts are monotonic: the worst corner decides
+    if (AntiSpoofDecision::isStrongFake(liveHi, adjHi, p)) {
+        exitAdjustment = adjHi;
+        return CascadeVerdict::FAKE;
+    }
+    if (AntiSpoofDecision::isStrongReal(liveLo, adjLo, p)) {
+        exitAdjustment = adjLo;
+        return CascadeVerdict::REAL;
+    }
+    return CascadeVerdict::OPEN;
+}
+
+bool CascadeScheduler::mayRunLight(const CascadeTrackState& track) const {
+    return track.lastState == DecisionState::REAL && track.hasLiveness && track.hasDeep &&
+           track.framesSinceFull + 1 < config.reverifyInterval;
+}
+
+bool CascadeScheduler::checkLight(const CascadeTrackState& track, QualityCues& cues, float& adjustment,
+                                  const DecisionParams& p) const {
+    cues.texture = track.texture;
+    cues.moire = track.moire;
+    cues.highFrequency = track.highFrequency;
+    adjustment = Layer4Hybrid::fuseCues(cues, p);
+    return AntiSpoofDecision::isStrongReal(track.livenessScore, adjustment, p);
+}
+
+void CascadeScheduler::printStats(const char* tag) const {
+    const uint64_t faceCount = counters.faces.load(std::memory_order_relaxed);
+    if (!config.enabled || faceCount == 0) return;
+    const double faces = (double)faceCount;
+    std::cout << tag << " Cascade: faces " << faceCount
+              << ", Layer3 " << (int)(100.0 * counters.livenessRuns.load(std::memory_order_relaxed) / faces) << "%"
+              << ", deep cues " << (int)(100.0 * counters.deepRuns.load(std::memory_order_relaxed) / faces) << "%"
+              << ", early exits " << counters.earlyExits.load(std::memory_order_relaxed)
+              << ", light " << counters.lightFrames.load(std::memory_order_relaxed)
+              << ", escalations " << counters.escalations.load(std::memory_order_relaxed) << std::endl;
+}
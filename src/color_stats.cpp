@@ -0,0 +1,200 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/color_stats.cpp (Fused colour statistics kernel)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "color_stats.h"
+#include <opencv2/core/hal/intrin.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Y = 0.114 B + 0.587 G + 0.299 R in 8.8 fixed point (29 + 150 + 77 = 256)
+const int kYB = 29, kYG = 150, kYR = 77;
+
+struct RowSums {
+    uint64_t sumB = 0, sumG = 0, sumR = 0, sumY = 0;
+    double sumSat = 0.0;
+    int minY = 255, maxY = 0;
+};
+
+inline void scalarPixel(const uchar* p, RowSums& acc) {
+    int b = p[0], g = p[1], r = p[2];
+    int y = (b * kYB + g * kYG + r * kYR + 128) >> 8;
+    int vmax = std::max(b, std::max(g, r));
+    int vmin = std::min(b, std::min(g, r));
+    acc.sumB += b; acc.sumG += g; acc.sumR += r; acc.sumY += y;
+    acc.minY = std::min(acc.minY, y);
+    acc.maxY = std::max(acc.maxY, y);
+    if (vmax > 0) acc.sumSat += (vmax - vmin) * 255.0 / vmax;
+}
+
+void processRow(const uchar* row, int width, RowSums& acc) {
+    int x = 0;
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+    using namespace cv;
+    const int lanes = VTraits<v_uint8>::vlanes();
+
+    const v_uint16 cB = vx_setall_u16(kYB), cG = vx_setall_u16(kYG), cR = vx_setall_u16(kYR);
+    const v_uint16 half = vx_setall_u16(128);
+    const v_uint8 one = vx_setall_u8(1);
+    const v_float32 scale255 = vx_setall_f32(255.0f);
+
+    v_uint32 accB = vx_setzero_u32(), accG = vx_setzero_u32(), accR = vx_setzero_u32(), accY = vx_setzero_u32();
+    v_float32 accSat = vx_setzero_f32();
+    v_uint8 yMin = vx_setall_u8(255), yMax = vx_setzero_u8();
+
+    for (; x <= width - lanes; x += lanes) {
+        v_uint8 b, g, r;
+        v_load_deinterleave(row + 3 * x, b, g, r);
+
+        v_uint16 b0, b1, g0, g1, r0, r1;
+        v_expand(b, b0, b1);
+        v_expand(g, g0, g1);
+        v_expand(r, r0, r1);
+
+        // Luma, products stay below 2^16 so the 16-bit math is exact
+        v_uint16 y0 = v_shr<8>(v_add(v_add(v_mul(b0, cB), v_mul(g0, cG)), v_add(v_mul(r0, cR), half)));
+        v_uint16 y1 = v_shr<8>(v_add(v_add(v_mul(b1, cB), v_mul(g1, cG)), v_add(v_mul(r1, cR), half)));
+        v_uint8 y = v_pack(y0, y1);
+        yMin = v_min(yMin, y);
+        yMax = v_max(yMax, y);
+
+        v_uint32 lo, hi;
+        v_expand(v_add(b0, b1), lo, hi); accB = v_add(accB, v_add(lo, hi));
+        v_expand(v_add(g0, g1), lo, hi); accG = v_add(accG, v_add(lo, hi));
+        v_expand(v_add(r0, r1), lo, hi); accR = v_add(accR, v_add(lo, hi));
+        v_expand(v_add(y0, y1), lo, hi); accY = v_add(accY, v_add(lo, hi));
+
+        // HSV saturation = (max - min) * 255 / max, max clamped to 1 (diff is 0 there anyway)
+        v_uint8 vmax = v_max(v_max(b, g), r);
+        v_uint8 diff = v_sub(vmax, v_min(v_min(b, g), r));
+        vmax = v_max(vmax, one);
+
+        v_uint16 d16[2], m16[2];
+        v_expand(diff, d16[0], d16[1]);
+        v_expand(vmax, m16[0], m16[1]);
+        for (int h = 0; h < 2; ++h) {
+            v_uint32 d32[2], m32[2];
+            v_expand(d16[h], d32[0], d32[1]);
+            v_expand(m16[h], m32[0], m32[1]);
+            for (int q = 0; q < 2; ++q) {
+                v_float32 df = v_cvt_f32(v_reinterpret_as_s32(d32[q]));
+                v_float32 mf = v_cvt_f32(v_reinterpret_as_s32(m32[q]));
+                accSat = v_add(accSat, v_div(v_mul(df, scale255), mf));
+            }
+        }
+    }
+
+    // Flush per row: 32-bit lanes cannot overflow within one row
+    acc.sumB += v_reduce_sum(accB);
+    acc.sumG += v_reduce_sum(accG);
+    acc.sumR += v_reduce_sum(accR);
+    acc.sumY += v_reduce_sum(accY);
+    acc.sumSat += v_reduce_sum(accSat);
+    if (x > 0) {
+        acc.minY = std::min(acc.minY, (int)v_reduce_min(yMin));
+        acc.maxY = std::max(acc.maxY, (int)v_reduce_max(yMax));
+    }
+#endif
+    for (; x < width; ++x) {
+        scalarPixel(row + 3 * x, acc);
+    }
+}
+
+// Source taps of one output coordinate of an INTER_LINEAR resize (half-pixel
+// centres, clamped at the border); w = weight of i1 in 1/256
+struct Tap {
+    int i0, i1, w;
+};
+
+const int maxGrid = 256;
+
+void linearTaps(int srcLen, int dstLen, Tap* taps) {
+    const double scale = (double)srcLen / dstLen;
+    for (int d = 0; d < dstLen; ++d) {
+        double f = (d + 0.5) * scale - 0.5;
+        int i = (int)std::floor(f);
+        f -= i;
+        if (i < 0) {
+            i = 0;
+            f = 0.0;
+        }
+        if (i >= srcLen - 1) {
+            i = srcLen - 1;
+            f = 0.0;
+        }
+        taps[d].i0 = i;
+        taps[d].i1 = std::min(i + 1, srcLen - 1);
+        taps[d].w = (int)std::lround(f * 256.0);
+    }
+}
+
+// One grid row, bilinear between source rows r0 / r1 (BGR), into out
+void sampleRow(const uchar* r0, const uchar* r1, int wy, const Tap* xTaps, int grid, uchar* out) {
+    for (int d = 0; d < grid; ++d) {
+        const int a = 3 * xTaps[d].i0, b = 3 * xTaps[d].i1, wx = xTaps[d].w;
+        for (int c = 0; c < 3; ++c) {
+            int top = r0[a + c] * (256 - wx) + r0[b + c] * wx;
+            int bottom = r1[a + c] * (256 - wx) + r1[b + c] * wx;
+            out[3 * d + c] = (uchar)((top * (256 - wy) + bottom * wy + (1 << 15)) >> 16);
+        }
+    }
+}
+
+bool finishStats(const RowSums& acc, int rows, int cols, ColorStats& out) {
+    const double n = (double)rows * cols;
+    if (n <= 0) return false;
+
+    out.meanB = (float)(acc.sumB / n);
+    out.meanG = (float)(acc.sumG / n);
+    out.meanR = (float)(acc.sumR / n);
+    out.meanY = (float)(acc.sumY / n);
+    out.minY = (float)acc.minY;
+    out.maxY = (float)acc.maxY;
+    out.meanSat = (float)(acc.sumSat / n);
+    // Cr/Cb are linear in B, G, R, Y: mean of the transform = transform of the means
+    out.meanCr = (out.meanR - out.meanY) * 0.713f + 128.0f;
+    out.meanCb = (out.meanB - out.meanY) * 0.564f + 128.0f;
+    out.samples = (int)n;
+    return true;
+}
+}
+
+bool computeColorStats(const cv::Mat& bgr, ColorStats& out, int grid) {
+    if (bgr.empty() || bgr.type() != CV_8UC3) return false;
+
+    grid = std::max(1, std::min(grid, maxGrid));
+    Tap xTaps[maxGrid], yTaps[maxGrid];
+    linearTaps(bgr.cols, grid, xTaps);
+    linearTaps(bgr.rows, grid, yTaps);
+
+    uchar samples[3 * maxGrid];
+    RowSums acc;
+    for (int gy = 0; gy < grid; ++gy) {
+        const Tap& ty = yTaps[gy];
+        sampleRow(bgr.ptr<uchar>(ty.i0), bgr.ptr<uchar>(ty.i1), ty.w, xTaps, grid, samples);
+        processRow(samples, grid, acc);
+    }
+    return finishStats(acc, grid, grid, out);
+}
+
+bool computeColorStatsYUYV(const cv::Mat& yuyv, ColorStats& out, cv::Mat& rowScratch, int grid) {
+    if (yuyv.empty() || yuyv.type() != CV_8UC2 || (yuyv.cols & 1)) return false;
+
+    grid = std::max(1, std::min(grid, maxGrid));
+    Tap xTaps[maxGrid], yTaps[maxGrid];
+    linearTaps(yuyv.cols, grid, xTaps);
+    linearTaps(yuyv.rows, grid, yTaps);
+
+    // Only the (one or two) source rows of each grid row are expanded to BGR
+    uchar samples[3 * maxGrid];
+    RowSums acc;
+    for (int gy = 0; gy < grid; ++gy) {
+        const Tap& ty = yTaps[gy];
+        cv::cvtColor(yuyv.rowRange(ty.i0, ty.i1 + 1), rowScratch, cv::COLOR_YUV2BGR_YUYV);
+        sampleRow(rowScratch.ptr<uchar>(0), rowScratch.ptr<uchar>(ty.i1 - ty.i0), ty.w, xTaps, grid, samples);
+        processRow(samples, grid, acc);
+    }
+    return finishStats(acc, grid, grid, out);
+}
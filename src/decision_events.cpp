@@ -0,0 +1,348 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/decision_events.cpp (Decision event stream + async sink)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "decision_events.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+namespace {
+constexpr size_t shmSlotOffset = 64;
+constexpr int maxBatch = 256;
+
+const char* cueNames[Layer4Hybrid::CUE_COUNT] = {"color", "texture", "edges", "moire", "high_freq"};
+
+int64_t unixMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+}
+
+DecisionEventSink::DecisionEventSink()
+    : mask(0), head(0), tail(0), running(false),
+      jsonlFile(nullptr), ownsJsonlFile(false), listenFd(-1),
+      shmHeader(nullptr), shmSlots(nullptr), shmBytes(0), shmIndex(0),
+      publishedCount(0), droppedCount(0), writtenCount(0), disconnectedCount(0) {}
+
+DecisionEventSink::~DecisionEventSink() {
+    close();
+}
+
+bool DecisionEventSink::init(const DecisionSinkConfig& cfg) {
+    close();
+    config = cfg;
+    if (!config.enabled()) return false;
+
+    size_t capacity = 2;
+    while (capacity < config.capacity) capacity <<= 1;
+    cells.reset(new Cell[capacity]);
+    for (size_t i = 0; i < capacity; ++i) cells[i].sequence.store(i, std::memory_order_relaxed);
+    mask = capacity - 1;
+    head = 0;
+    tail = 0;
+
+    if (!config.jsonlPath.empty()) {
+        if (config.jsonlPath == "-" && config.stdoutFd >= 0) {
+            const int fd = dup(config.stdoutFd);
+            jsonlFile = fd >= 0 ? fdopen(fd, "w") : nullptr;
+            if (!jsonlFile && fd >= 0) ::close(fd);
+            ownsJsonlFile = true;
+        } else if (config.jsonlPath == "-") {
+            jsonlFile = stdout;
+        } else {
+            jsonlFile = std::fopen(config.jsonlPath.c_str(), "a");
+            ownsJsonlFile = true;
+        }
+        if (!jsonlFile) {
+            std::cerr << "[Events] ERROR: Cannot open " << config.jsonlPath << std::endl;
+            closeOutputs();
+            return false;
+        }
+    }
+    if (!config.socketPath.empty() && !openSocket(config.socketPath)) {
+        closeOutputs();
+        return false;
+    }
+    if (!config.shmName.empty() && !openShm(config.shmName, std::max<size_t>(2, config.shmSlots))) {
+        closeOutputs();
+        return false;
+    }
+
+    running = true;
+    writer = std::thread(&DecisionEventSink::writerLoop, this);
+    std::cout << "[Events] INFO: Decision events ->"
+              << (config.jsonlPath.empty() ? "" : " jsonl:" + config.jsonlPath)
+              << (config.socketPath.empty() ? "" : " unix:" + config.socketPath)
+              << (config.shmName.empty() ? "" : " shm:" + config.shmName) << std::endl;
+    return true;
+}
+
+int DecisionEventSink::detachStdout() {
+    std::cout.flush();
+    std::fflush(stdout);
+    const int kept = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 3);
+    if (kept < 0) return -1;
+    if (dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+        ::close(kept);
+        return -1;
+    }
+    return kept;
+}
+
+void DecisionEventSink::close() {
+    if (!writer.joinable()) return;
+    running.store(false, std::memory_order_release);
+    writer.join();
+    closeOutputs();
+}
+
+bool DecisionEventSink::publish(const DecisionEvent& event) {
+    if (!cells) return false;
+    size_t pos = head.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+        cell = &cells[pos & mask];
+        const size_t seq = cell->sequence.load(std::memory_order_acquire);
+        const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = head.load(std::memory_order_relaxed);
+        }
+    }
+    cell->event = event;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    publishedCount.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool DecisionEventSink::tryPop(DecisionEvent& event) {
+    Cell& cell = cells[tail & mask];
+    if (cell.sequence.load(std::memory_order_acquire) != tail + 1) return false;
+    event = cell.event;
+    cell.sequence.store(tail + mask + 1, std::memory_order_release);
+    tail++;
+    return true;
+}
+
+void DecisionEventSink::publishFrame(int streamId, uint64_t seq,
+                                     std::chrono::steady_clock::time_point captureTime,
+                                     const std::vector<FaceResult>& faces,
+                                     const std::vector<FaceAnalysis>& analyses) {
+    if (!isOpen() || faces.empty()) return;
+    const int64_t now = unixMicros();
+    int64_t latency = -1;
+    if (captureTime.time_since_epoch().count() != 0) {
+        latency = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - captureTime).count();
+    }
+
+    DecisionEvent event;
+    for (size_t i = 0; i < faces.size() && i < analyses.size(); ++i) {
+        const FaceAnalysis& a = analyses[i];
+        const cv::Rect& box = faces[i].bbox;
+        event.seq = seq;
+        event.timestampUs = now;
+        event.latencyUs = latency;
+        event.streamId = streamId;
+        event.trackId = a.trackId;
+        event.x = box.x;
+        event.y = box.y;
+        event.w = box.width;
+        event.h = box.height;
+        event.state = (int32_t)a.state;
+        event.cueMask = a.cueMask;
+        event.rawScore = a.rawScore;
+        event.livenessScore = a.livenessScore;
+        event.adjustment = a.adjustment;
+        event.finalScore = a.finalScore;
+        std::memcpy(event.cueAdjustment, a.cueAdjustment, sizeof(event.cueAdjustment));
+        publish(event);
+    }
+}
+
+void DecisionEventSink::formatJson(const DecisionEvent& e, std::string& out) {
+    char buffer[640];
+    int n = std::snprintf(buffer, sizeof(buffer),
+        "{\"ts_us\":%lld,\"stream\":%d,\"seq\":%llu,\"track_id\":%d,\"state\":\"%s\","
+        "\"raw_score\":%.4f,\"liveness_score\":%.4f,\"adjustment\":%.4f,\"final_score\":%.4f,\"cues\":{",
+        (long long)e.timestampUs, e.streamId, (unsigned long long)e.seq, e.trackId,
+        decisionStateName((DecisionState)e.state),
+        e.rawScore, e.livenessScore, e.adjustment, e.finalScore);
+    for (int cue = 0; cue < Layer4Hybrid::CUE_COUNT; ++cue) {
+        if (!(e.cueMask & Layer4Hybrid::cueBit(cue))) continue;   // not measured on this frame
+        n += std::snprintf(buffer + n, sizeof(buffer) - n, "%s\"%s\":%.4f",
+                           buffer[n - 1] == '{' ? "" : ",", cueNames[cue], e.cueAdjustment[cue]);
+    }
+    n += std::snprintf(buffer + n, sizeof(buffer) - n, "},\"bbox\":[%d,%d,%d,%d],\"latency_us\":%lld}",
+                       e.x, e.y, e.w, e.h, (long long)e.latencyUs);
+    out.append(buffer, std::min(n, (int)sizeof(buffer) - 1));
+}
+
+void DecisionEventSink::writerLoop() {
+    std::string lines;
+    lines.reserve(maxBatch * 320);
+    const bool textOutput = jsonlFile || listenFd >= 0;
+    DecisionEvent event;
+
+    for (;;) {
+        // Read the flag first so everything published before close() is drained
+        const bool stopping = !running.load(std::memory_order_acquire);
+        if (listenFd >= 0) acceptClients();
+
+        lines.clear();
+        int count = 0;
+        while (count < maxBatch && tryPop(event)) {
+            if (shmHeader) writeShm(event);
+            if (textOutput) {
+                formatJson(event, lines);
+                lines += '\n';
+            }
+            count++;
+        }
+        if (count > 0) {
+            if (textOutput) writeLines(lines);
+            writtenCount.fetch_add(count, std::memory_order_relaxed);
+            continue;
+        }
+        if (stopping) break;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+bool DecisionEventSink::openSocket(const std::string& path) {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "[Events] ERROR: Socket path too long: " << path << std::endl;
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) return false;
+    unlink(path.c_str());   // stale socket of a previous run
+    if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenFd, 8) != 0) {
+        std::cerr << "[Events] ERROR: Cannot listen on " << path << ": " << std::strerror(errno) << std::endl;
+        ::close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    return true;
+}
+
+void DecisionEventSink::acceptClients() {
+    for (;;) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        clients.push_back(fd);
+    }
+}
+
+void DecisionEventSink::writeLines(const std::string& lines) {
+    if (jsonlFile) {
+        std::fwrite(lines.data(), 1, lines.size(), jsonlFile);
+        std::fflush(jsonlFile);
+    }
+    for (size_t c = 0; c < clients.size();) {
+        // Partial write would cut a line: a client that lags behind is dropped
+        ssize_t sent = send(clients[c], lines.data(), lines.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent == (ssize_t)lines.size()) {
+            ++c;
+            continue;
+        }
+        ::close(clients[c]);
+        clients.erase(clients.begin() + c);
+        disconnectedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool DecisionEventSink::openShm(const std::string& name, size_t slots) {
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        std::cerr << "[Events] ERROR: shm_open " << name << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    const size_t bytes = shmSlotOffset + slots * sizeof(DecisionShmSlot);
+    void* base = MAP_FAILED;
+    if (ftruncate(fd, (off_t)bytes) == 0) {
+        base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        std::cerr << "[Events] ERROR: Cannot map " << name << ": " << std::strerror(errno) << std::endl;
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    std::memset(base, 0, bytes);
+    shmHeader = static_cast<DecisionShmHeader*>(base);
+    shmSlots = reinterpret_cast<DecisionShmSlot*>(static_cast<char*>(base) + shmSlotOffset);
+    shmBytes = bytes;
+    shmIndex = 0;
+    shmHeader->slotCount = (uint32_t)slots;
+    shmHeader->slotSize = (uint32_t)sizeof(DecisionShmSlot);
+    shmHeader->version = DECISION_SHM_VERSION;
+    shmHeader->writeIndex.store(0, std::memory_order_relaxed);
+    // Magic last: a reader that sees it sees a complete header
+    std::atomic_thread_fence(std::memory_order_release);
+    shmHeader->magic = DECISION_SHM_MAGIC;
+    return true;
+}
+
+void DecisionEventSink::writeShm(const DecisionEvent& event) {
+    DecisionShmSlot& slot = shmSlots[shmIndex % shmHeader->slotCount];
+    slot.sequence.store(2 * shmIndex + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&slot.event, &event, sizeof(DecisionEvent));
+    slot.sequence.store(2 * shmIndex + 2, std::memory_order_release);
+    shmIndex++;
+    shmHeader->writeIndex.store(shmIndex, std::memory_order_release);
+}
+
+void DecisionEventSink::closeOutputs() {
+    if (jsonlFile) {
+        std::fflush(jsonlFile);
+        if (ownsJsonlFile) std::fclose(jsonlFile);
+    }
+    jsonlFile = nullptr;
+    ownsJsonlFile = false;
+
+    for (int fd : clients) ::close(fd);
+    clients.clear();
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        unlink(config.socketPath.c_str());
+        listenFd = -1;
+    }
+
+    if (shmHeader) {
+        munmap(shmHeader, shmBytes);
+        shm_unlink(config.shmName.c_str());   // mapped readers keep their view
+    }
+    shmHeader = nullptr;
+    shmSlots = nullptr;
+    shmBytes = 0;
+}
+
+void DecisionEventSink::printStats(const char* tag) const {
+    if (!cells) return;
+    std::cout << tag << " Decision events: published=" << getPublished() << " written=" << getWritten()
+              << " dropped=" << getDropped();
+    if (!config.socketPath.empty()) {
+        std::cout << " slow_clients_dropped=" << disconnectedCount.load(std::memory_order_relaxed);
+    }
+    std::cout << std::endl;
+}
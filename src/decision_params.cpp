@@ -0,0 +1,307 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/decision_params.cpp (Hot-reloadable thresholds + fusion weights)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "decision_params.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace {
+// One config key: section.key -> float or int member
+struct ParamField {
+    const char* section;
+    const char* key;
+    float DecisionParams::* f;
+    int DecisionParams::* i;
+};
+
+#define PF(section, key, member) {section, key, &DecisionParams::member, nullptr}
+#define PI(section, key, member) {section, key, nullptr, &DecisionParams::member}
+const ParamField paramFields[] = {
+    PF("layer3", "real_strong", livenessRealStrong),
+    PF("layer3", "spoof_strong", livenessSpoofStrong),
+    PF("layer3", "real", livenessReal),
+    PF("layer3", "spoof", livenessSpoof),
+
+    PF("smoothing", "reset_below", smoothResetBelow),
+    PF("smoothing", "drop_from", smoothDropFrom),
+    PF("smoothing", "drop_to", smoothDropTo),
+    PF("smoothing", "low_score", smoothLowScore),
+    PI("smoothing", "low_frames", smoothLowFrames),
+    PF("smoothing", "lag_margin", smoothLagMargin),
+    PF("smoothing", "lag_blend", smoothLagBlend),
+
+    PF("texture", "ratio_good_lo", textureRatioGoodLo),
+    PF("texture", "ratio_good_hi", textureRatioGoodHi),
+    PF("texture", "ratio_flat", textureRatioFlat),
+    PF("texture", "ratio_noisy", textureRatioNoisy),
+    PF("texture", "grad_low", textureGradLow),
+    PF("texture", "grad_mid", textureGradMid),
+    PF("texture", "grad_high", textureGradHigh),
+
+    PF("moire", "variance_high", moireVarianceHigh),
+    PF("moire", "variance_mid", moireVarianceMid),
+    PF("moire", "variance_low", moireVarianceLow),
+    PF("moire", "variance_good_lo", moireVarianceGoodLo),
+    PF("moire", "variance_good_hi", moireVarianceGoodHi),
+
+    PF("skin", "cr_min", skinCrMin),
+    PF("skin", "cr_max", skinCrMax),
+    PF("skin", "cb_min", skinCbMin),
+    PF("skin", "cb_max", skinCbMax),
+    PF("skin", "contrast_low", skinContrastLow),
+    PF("skin", "contrast_high", skinContrastHigh),
+    PF("skin", "contrast_good_lo", skinContrastGoodLo),
+    PF("skin", "contrast_good_hi", skinContrastGoodHi),
+    PF("skin", "sat_good_lo", skinSatGoodLo),
+    PF("skin", "sat_good_hi", skinSatGoodHi),
+    PF("skin", "sat_low", skinSatLow),
+    PF("skin", "sat_high", skinSatHigh),
+
+    PF("temperature", "rg_good_lo", tempRgGoodLo),
+    PF("temperature", "rg_good_hi", tempRgGoodHi),
+    PF("temperature", "gb_good_lo", tempGbGoodLo),
+    PF("temperature", "gb_good_hi", tempGbGoodHi),
+    PF("temperature", "rg_lo", tempRgLo),
+    PF("temperature", "rg_hi", tempRgHi),
+    PF("temperature", "gb_lo", tempGbLo),
+    PF("temperature", "gb_hi", tempGbHi),
+    PF("temperature", "bright_low", tempBrightLow),
+    PF("temperature", "bright_high", tempBrightHigh),
+    PF("temperature", "bright_good_lo", tempBrightGoodLo),
+    PF("temperature", "bright_good_hi", tempBrightGoodHi),
+
+    PF("edges", "canny_low", edgeCannyLow),
+    PF("edges", "canny_high", edgeCannyHigh),
+    PF("edges", "ratio_high", edgeRatioHigh),
+    PF("edges", "ratio_mid", edgeRatioMid),
+
+    PF("frequency", "high", freqHigh),
+    PF("frequency", "mid", freqMid),
+    PF("frequency", "low", freqLow),
+    PF("frequency", "good_lo", freqGoodLo),
+    PF("frequency", "good_hi", freqGoodHi),
+
+    PF("fusion", "weight_skin", weightSkin),
+    PF("fusion", "weight_texture", weightTexture),
+    PF("fusion", "weight_temperature", weightTemperature),
+    PF("fusion", "weight_edges", weightEdges),
+    PF("fusion", "weight_moire", weightMoire),
+    PF("fusion", "adjustment_min", adjustmentMin),
+    PF("fusion", "adjustment_max", adjustmentMax),
+
+    PF("decision", "liveness_weight", livenessWeight),
+    PF("decision", "adjustment_weight", adjustmentWeight),
+    PF("decision", "penalty_strong_below", penaltyStrongBelow),
+    PF("decision", "penalty_strong", penaltyStrong),
+    PF("decision", "penalty_below", penaltyBelow),
+    PF("decision", "penalty", penalty),
+    PF("decision", "strong_real_score", strongRealScore),
+    PF("decision", "strong_real_liveness", strongRealLiveness),
+    PF("decision", "strong_real_adjustment", strongRealAdjustment),
+    PF("decision", "weak_real_score", weakRealScore),
+    PF("decision", "weak_real_liveness", weakRealLiveness),
+    PF("decision", "weak_real_adjustment", weakRealAdjustment),
+    PF("decision", "strong_fake_score", strongFakeScore),
+    PF("decision", "strong_fake_adjustment", strongFakeAdjustment),
+    PF("decision", "strong_fake_liveness", strongFakeLiveness),
+    PF("decision", "weak_fake_score", weakFakeScore),
+    PF("decision", "weak_fake_liveness", weakFakeLiveness),
+    PF("decision", "weak_fake_adjustment", weakFakeAdjustment),
+    PF("decision", "drop_from", dropFrom),
+    PF("decision", "drop_to", dropTo),
+    PI("decision", "drop_frames", dropFrames),
+    PF("decision", "drop_cap", dropCap),
+    PF("decision", "drop_recover", dropRecover),
+    PF("decision", "strong_real_credit", strongRealCredit),
+    PF("decision", "weak_real_credit", weakRealCredit),
+    PF("decision", "real_confidence", realConfidence),
+    PI("decision", "confirm_frames", confirmFrames),
+    PI("decision", "missing_frames", missingFrames),
+};
+#undef PF
+#undef PI
+
+const ParamField* findField(const std::string& section, const std::string& key) {
+    for (const ParamField& field : paramFields) {
+        if (section == field.section && key == field.key) return &field;
+    }
+    return nullptr;
+}
+
+int countChanged(const DecisionParams& a, const DecisionParams& b) {
+    int changed = 0;
+    for (const ParamField& field : paramFields) {
+        if (field.f ? a.*field.f != b.*field.f : a.*field.i != b.*field.i) changed++;
+    }
+    return changed;
+}
+
+// Constant-initialized, so current() is valid before main()
+const DecisionParams defaultParams;
+std::mutex publishMutex;
+std::vector<std::unique_ptr<DecisionParams>> publishedParams;
+std::atomic<uint32_t> publishCount(0);
+}
+
+std::atomic<const DecisionParams*> DecisionParams::active(&defaultParams);
+
+void DecisionParams::publish(const DecisionParams& params) {
+    std::lock_guard<std::mutex> lock(publishMutex);
+    publishedParams.emplace_back(new DecisionParams(params));
+    active.store(publishedParams.back().get(), std::memory_order_release);
+    publishCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint32_t DecisionParams::generation() {
+    return publishCount.load(std::memory_order_relaxed);
+}
+
+std::string DecisionParams::validate() const {
+    if (!(livenessSpoofStrong <= livenessSpoof && livenessSpoof <= livenessReal && livenessReal <= livenessRealStrong))
+        return "layer3 bands need spoof_strong <= spoof <= real <= real_strong";
+    if (smoothLagBlend < 0.0f || smoothLagBlend > 1.0f) return "smoothing.lag_blend outside [0, 1]";
+    if (weightSkin < 0.0f || weightTexture < 0.0f || weightTemperature < 0.0f || weightEdges < 0.0f ||
+        weightMoire < 0.0f || livenessWeight < 0.0f || adjustmentWeight < 0.0f)
+        return "negative weight (the cascade bounds need monotonic fusion)";
+    if (adjustmentMin >= adjustmentMax) return "fusion.adjustment_min >= adjustment_max";
+    if (!(0.0f < penaltyStrong && penaltyStrong <= penalty && penalty <= 1.0f) || penaltyStrongBelow > penaltyBelow)
+        return "decision penalties need 0 < penalty_strong <= penalty <= 1, penalty_strong_below <= penalty_below";
+    if (edgeCannyLow >= edgeCannyHigh) return "edges.canny_low >= canny_high";
+    if (smoothLowFrames < 1 || dropFrames < 1 || confirmFrames < 1 || missingFrames < 1)
+        return "frame counts must be >= 1";
+    return std::string();
+}
+
+bool DecisionParams::load(const std::string& path, DecisionParams& out) {
+    DecisionParams params;
+    try {
+        cv::FileStorage fs(path, cv::FileStorage::READ);
+        if (!fs.isOpened()) {
+            std::cerr << "[Config] ERROR: Cannot open " << path << std::endl;
+            return false;
+        }
+        cv::FileNode root = fs.root();
+        for (cv::FileNodeIterator s = root.begin(); s != root.end(); ++s) {
+            cv::FileNode section = *s;
+            if (!section.isMap()) {
+                std::cerr << "[Config] ERROR: " << path << ": " << section.name() << " is not a section" << std::endl;
+                return false;
+            }
+            for (cv::FileNodeIterator k = section.begin(); k != section.end(); ++k) {
+                cv::FileNode value = *k;
+                const ParamField* field = findField(section.name(), value.name());
+                if (!field || !(value.isReal() || value.isInt())) {
+                    std::cerr << "[Config] ERROR: " << path << ": " << section.name() << "." << value.name()
+                              << (field ? " is not a number" : " is not a known key") << std::endl;
+                    return false;
+                }
+                if (field->f) params.*field->f = (float)(double)value;
+                else params.*field->i = (int)value;
+            }
+        }
+    } catch (const cv::Exception& e) {
+        std::cerr << "[Config] ERROR: " << path << ": " << e.what() << std::endl;
+        return false;
+    }
+
+    const std::string problem = params.validate();
+    if (!problem.empty()) {
+        std::cerr << "[Config] ERROR: " << path << ": " << problem << std::endl;
+        return false;
+    }
+    out = params;
+    return true;
+}
+
+bool DecisionParams::save(const std::string& path, const DecisionParams& params) {
+    try {
+        cv::FileStorage fs(path, cv::FileStorage::WRITE);
+        if (!fs.isOpened()) {
+            std::cerr << "[Config] ERROR: Cannot write " << path << std::endl;
+            return false;
+        }
+        const char* open = nullptr;
+        for (const ParamField& field : paramFields) {
+            if (!open || std::string(open) != field.section) {
+                if (open) fs << "}";
+                open = field.section;
+                fs << open << "{";
+            }
+            if (field.f) fs << field.key << params.*field.f;
+            else fs << field.key << params.*field.i;
+        }
+        if (open) fs << "}";
+    } catch (const cv::Exception& e) {
+        std::cerr << "[Config] ERROR: " << path << ": " << e.what() << std::endl;
+        return false;
+    }
+    std::cout << "[Config] INFO: Wrote " << sizeof(paramFields) / sizeof(paramFields[0])
+              << " decision parameters to " << path << std::endl;
+    return true;
+}
+
+DecisionConfigWatcher::DecisionConfigWatcher() : pollMs(1000), running(false), reloads(0), rejected(0) {}
+
+DecisionConfigWatcher::~DecisionConfigWatcher() {
+    stop();
+}
+
+bool DecisionConfigWatcher::start(const std::string& configPath, int poll) {
+    stop();
+    std::error_code ec;
+    if (!std::filesystem::exists(configPath, ec)) {
+        std::cerr << "[Config] ERROR: " << configPath << " does not exist" << std::endl;
+        return false;
+    }
+    path = configPath;
+    pollMs = std::max(50, poll);
+    running = true;
+    watcher = std::thread(&DecisionConfigWatcher::watchLoop, this);
+    std::cout << "[Config] INFO: Watching " << path << " (every " << pollMs << " ms)" << std::endl;
+    return true;
+}
+
+void DecisionConfigWatcher::stop() {
+    if (!watcher.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wake.notify_all();
+    watcher.join();
+}
+
+void DecisionConfigWatcher::watchLoop() {
+    std::error_code ec;
+    auto lastWrite = std::filesystem::last_write_time(path, ec);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        wake.wait_for(lock, std::chrono::milliseconds(pollMs), [this] { return !running; });
+        if (!running) break;
+
+        // Missing for a moment = an editor replacing the file, try again next poll
+        const auto writeTime = std::filesystem::last_write_time(path, ec);
+        if (ec || writeTime == lastWrite) continue;
+        lastWrite = writeTime;
+
+        DecisionParams params;
+        if (!DecisionParams::load(path, params)) {
+            rejected.fetch_add(1, std::memory_order_relaxed);
+            std::cerr << "[Config] WARN: Keeping generation " << DecisionParams::generation() << std::endl;
+            continue;
+        }
+        const int changed = countChanged(params, DecisionParams::current());
+        DecisionParams::publish(params);
+        reloads.fetch_add(1, std::memory_order_relaxed);
+        std::cout << "[Config] INFO: Reloaded " << path << " (generation " << DecisionParams::generation()
+                  << ", " << changed << " values changed)" << std::endl;
+    }
+}
@@ -0,0 +1,98 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/display_renderer.cpp (Off-thread display, newest wins)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "display_renderer.h"
+#include <iostream>
+
+namespace {
+DisplayStatus displayStatus(DecisionState state) {
+    switch (state) {
+        case DecisionState::REAL:    return DisplayStatus::REAL_PERSON;
+        case DecisionState::FAKE:    return DisplayStatus::SPOOF_DETECTED;
+        case DecisionState::TOO_FAR: return DisplayStatus::TOO_FAR;
+        default:                     return DisplayStatus::VERIFYING;
+    }
+}
+}
+
+DisplayRenderer::DisplayRenderer()
+    : displaySize(640, 480), fps(0.0f), running(false), quitRequested(false),
+      resetRequested(false), shown(0) {}
+
+DisplayRenderer::~DisplayRenderer() {
+    stop();
+}
+
+bool DisplayRenderer::start(const std::string& name, cv::Size size) {
+#ifdef FACE_HEADLESS
+    (void)name;
+    (void)size;
+    std::cerr << "[Display] WARN: Built with HEADLESS=ON, no window available" << std::endl;
+    return false;
+#else
+    if (thread.joinable()) return true;
+    windowName = name;
+    displaySize = size;
+    quitRequested = false;
+    resetRequested = false;
+    running = true;
+    thread = std::thread(&DisplayRenderer::renderLoop, this);
+    return true;
+#endif
+}
+
+void DisplayRenderer::stop() {
+    running = false;
+    if (thread.joinable()) thread.join();
+}
+
+void DisplayRenderer::renderLoop() {
+#ifndef FACE_HEADLESS
+    // The window lives and dies on this thread, waitKey keeps idling at ~1 ms
+    cv::namedWindow(windowName, cv::WINDOW_AUTOSIZE);
+    FrameSlot slot;
+
+    while (running) {
+        if (mailbox.take(slot)) {
+            FACE_SCOPED_TIMER(MetricStage::DISPLAY);
+            // Only the display needs the whole frame in BGR (unless a keyframe built it already)
+            cv::Mat& canvas = slot.frame.bgrForDrawing();
+            cv::Mat* view = &canvas;
+            if (canvas.size() != displaySize) {
+                cv::resize(canvas, displayBuffer, displaySize);
+                view = &displayBuffer;
+            }
+
+            // Overlay on the small buffer, box / landmark coordinates are scaled by Layer5
+            if (!overlay.isReady(canvas.size(), displaySize)) overlay.init(canvas.size(), displaySize);
+            overlayFaces.clear();
+            for (size_t i = 0; i < slot.faces.size() && i < slot.analyses.size(); ++i) {
+                const FaceAnalysis& a = slot.analyses[i];
+                VisualizationData data;
+                data.faceBox = slot.faces[i].bbox;
+                data.faceDetected = true;
+                data.trackId = a.trackId;
+                data.aiScore = a.livenessScore;
+                data.physicalScore = a.adjustment;
+                data.finalScore = a.finalScore;
+                data.status = displayStatus(a.state);
+                data.consecutiveRealFrames = a.realStreak;
+                data.landmarks = &slot.faces[i].landmarks;
+                overlayFaces.push_back(data);
+            }
+            overlay.updateFPS(fps);
+            overlay.renderFrame(*view, overlayFaces, fps);
+
+            cv::imshow(windowName, *view);
+            shown.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        char key = (char)cv::waitKey(1);
+        if (key == 27) quitRequested = true; // ESC
+        if (key == 'r' || key == 'R') resetRequested = true;
+    }
+    cv::destroyWindow(windowName);
+#endif
+}
@@ -0,0 +1,117 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/face_roi_cache.cpp (Shared per-face ROI pyramid)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "face_roi_cache.h"
+#include <cmath>
+#include "frame_arena.h"
+
+FaceRoiCache::FaceRoiCache()
+    : layout(PixelLayout::BGR), roiBgrValid(false), fullGrayValid(false), resizeCount(0), convertCount(0) {}
+
+void FaceRoiCache::bindScratch(FrameArena& arena) {
+    arena.bind(roiBgr);
+    arena.bind(fullGray);
+    for (Level& level : levels) arena.bind(level.image);
+}
+
+bool FaceRoiCache::reset(const cv::Mat& frame, const cv::Rect& faceBox) {
+    roiBox = faceBox & cv::Rect(0, 0, frame.cols, frame.rows);
+    layout = PixelLayout::BGR;
+    roiBgrValid = false;
+    fullGrayValid = false;
+    for (Level& level : levels) level.valid = false;
+    if (roiBox.area() <= 0) {
+        roi = cv::Mat();
+        return false;
+    }
+    roi = frame(roiBox);
+    return true;
+}
+
+bool FaceRoiCache::reset(const VideoFrame& frame, const cv::Rect& faceBox) {
+    if (frame.getLayout() == PixelLayout::BGR) return reset(frame.getNative(), faceBox);
+
+    roiBox = faceBox;
+    layout = frame.getLayout();
+    roiBgrValid = false;
+    fullGrayValid = false;
+    for (Level& level : levels) level.valid = false;
+    roi = frame.nativeRegion(roiBox);
+    return !roi.empty();
+}
+
+const cv::Mat& FaceRoiCache::bgr() {
+    if (layout == PixelLayout::BGR) return roi;
+    if (!roiBgrValid && !roi.empty()) {
+        cv::cvtColor(roi, roiBgr, cv::COLOR_YUV2BGR_YUYV);
+        convertCount++;
+        roiBgrValid = true;
+    }
+    return roiBgr;
+}
+
+const cv::Mat& FaceRoiCache::gray() {
+    if (!fullGrayValid) {
+        if (layout == PixelLayout::YUYV) cv::extractChannel(roi, fullGray, 0);
+        else if (roi.channels() == 3) cv::cvtColor(roi, fullGray, cv::COLOR_BGR2GRAY);
+        else roi.copyTo(fullGray);
+        convertCount++;
+        fullGrayValid = true;
+    }
+    return fullGray;
+}
+
+const cv::Mat& FaceRoiCache::gray(const cv::Rect& region, const cv::Size& size) {
+    const cv::Rect clipped = region & cv::Rect(0, 0, roi.cols, roi.rows);
+
+    // Exact hit, or pick the smallest built level that covers the region at
+    // no less than the requested resolution
+    const Level* source = nullptr;
+    double bestArea = 0.0;
+    for (const Level& level : levels) {
+        if (!level.valid) continue;
+        if (level.region == clipped && level.size == size) return level.image;
+        if ((level.region & clipped) != clipped) continue;
+        double sx = (double)level.size.width / level.region.width;
+        double sy = (double)level.size.height / level.region.height;
+        if (sx * clipped.width < size.width || sy * clipped.height < size.height) continue;
+        double area = (double)level.size.area();
+        if (!source || area < bestArea) {
+            source = &level;
+            bestArea = area;
+        }
+    }
+
+    cv::Mat src;
+    if (source) {
+        double sx = (double)source->size.width / source->region.width;
+        double sy = (double)source->size.height / source->region.height;
+        cv::Rect inLevel((int)std::lround((clipped.x - source->region.x) * sx),
+                         (int)std::lround((clipped.y - source->region.y) * sy),
+                         (int)std::lround(clipped.width * sx),
+                         (int)std::lround(clipped.height * sy));
+        src = source->image(inLevel & cv::Rect(0, 0, source->image.cols, source->image.rows));
+    } else {
+        src = gray()(clipped);
+    }
+
+    // Free slot keeps its buffer from the previous face; when all are taken the
+    // last one is recycled (more variants than maxLevels is a caller bug)
+    Level* slot = &levels[maxLevels - 1];
+    for (Level& level : levels) {
+        if (!level.valid) { slot = &level; break; }
+    }
+    if (slot == source) src = src.clone();
+    slot->region = clipped;
+    slot->size = size;
+    if (src.size() == size) src.copyTo(slot->image);
+    else {
+        AllocationCounter::Exclude opencvScratch;
+        cv::resize(src, slot->image, size);   // INTER_LINEAR like the old per-extractor resizes
+    }
+    resizeCount++;
+    slot->valid = true;
+    return slot->image;
+}
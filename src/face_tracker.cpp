@@ -0,0 +1,100 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/face_tracker.cpp (IoU/centroid multi-face tracker)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "face_tracker.h"
+#include <algorithm>
+#include <cmath>
+
+FaceTracker::FaceTracker(float iouThreshold, int maxMissedFrames)
+    : iouThreshold(iouThreshold), maxMissedFrames(maxMissedFrames), nextId(1) {}
+
+void FaceTracker::reset() {
+    tracks.clear();
+    removedIds.clear();
+}
+
+// IoU when boxes overlap enough, otherwise a centroid-distance fallback for
+// fast moving faces (always ranked below a real IoU match)
+float FaceTracker::matchScore(const cv::Rect& a, const cv::Rect& b) const {
+    int inter = (a & b).area();
+    int uni = a.area() + b.area() - inter;
+    float iou = uni > 0 ? (float)inter / uni : 0.0f;
+    if (iou >= iouThreshold) return 1.0f + iou;
+
+    float dx = (a.x + a.width * 0.5f) - (b.x + b.width * 0.5f);
+    float dy = (a.y + a.height * 0.5f) - (b.y + b.height * 0.5f);
+    float dist = std::sqrt(dx * dx + dy * dy);
+    float reach = 0.5f * std::max(std::max(a.width, a.height), std::max(b.width, b.height));
+    if (reach <= 0.0f || dist >= reach) return 0.0f;
+    return 1.0f - dist / reach;
+}
+
+void FaceTracker::update(const std::vector<FaceResult>& detections, std::vector<int>& trackIds) {
+    removedIds.clear();
+    trackIds.assign(detections.size(), -1);
+
+    // Greedy assignment, best pair first
+    candidates.clear();
+    for (size_t t = 0; t < tracks.size(); ++t) {
+        for (size_t d = 0; d < detections.size(); ++d) {
+            float s = matchScore(tracks[t].bbox, detections[d].bbox);
+            if (s > 0.0f) candidates.push_back({s, (int)t, (int)d});
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate& a, const Candidate& b) { return a.score > b.score; });
+
+    trackUsed.assign(tracks.size(), 0);
+    for (const Candidate& c : candidates) {
+        if (trackUsed[c.track] || trackIds[c.detection] >= 0) continue;
+        trackUsed[c.track] = 1;
+        trackIds[c.detection] = tracks[c.track].id;
+        tracks[c.track].bbox = detections[c.detection].bbox;
+        tracks[c.track].missed = 0;
+    }
+
+    // Age unmatched tracks, drop the expired ones
+    size_t keep = 0;
+    for (size_t t = 0; t < tracks.size(); ++t) {
+        if (!trackUsed[t] && ++tracks[t].missed > maxMissedFrames) {
+            removedIds.push_back(tracks[t].id);
+            continue;
+        }
+        tracks[keep++] = tracks[t];
+    }
+    tracks.resize(keep);
+
+    // New faces
+    for (size_t d = 0; d < detections.size(); ++d) {
+        if (trackIds[d] >= 0) continue;
+        Track t;
+        t.id = nextId++;
+        t.bbox = detections[d].bbox;
+        t.missed = 0;
+        tracks.push_back(t);
+        trackIds[d] = t.id;
+    }
+}
+
+int TrackStateTable::acquire(int trackId) {
+    for (size_t i = 0; i < states.size(); ++i) {
+        if (states[i].trackId == trackId) return (int)i;
+    }
+    states.emplace_back();
+    states.back().trackId = trackId;
+    states.back().liveness.reset();
+    states.back().decision.reset();
+    return (int)states.size() - 1;
+}
+
+void TrackStateTable::remove(int trackId) {
+    for (size_t i = 0; i < states.size(); ++i) {
+        if (states[i].trackId == trackId) {
+            if (i + 1 != states.size()) std::swap(states[i], states.back());
+            states.pop_back();
+            return;
+        }
+    }
+}
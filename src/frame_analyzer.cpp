@@ -0,0 +1,388 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/frame_analyzer.cpp (Layer3 + Layer4 + decision per frame)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "frame_analyzer.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+double elapsedMs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+}
+
+FrameAnalyzer::FrameAnalyzer(Layer3Liveness& liveness, Layer4Hybrid& hybrid)
+    : liveness(&liveness), hybrid(&hybrid), minFaceWidth(0),
+      frameParams(&DecisionParams::current()),
+      lastLivenessMs(0.0), lastQualityMs(0.0), cueMask(~0u), executor(nullptr), graphFrame(nullptr), graphFaces(nullptr) {}
+
+FrameAnalyzer::FrameAnalyzer()
+    : liveness(nullptr), hybrid(nullptr), minFaceWidth(0),
+      frameParams(&DecisionParams::current()),
+      lastLivenessMs(0.0), lastQualityMs(0.0), cueMask(~0u), executor(nullptr), graphFrame(nullptr), graphFaces(nullptr) {}
+
+void FrameAnalyzer::enableArena(size_t bytes) {
+    if (arena || !liveness || !hybrid) return;
+    arena.reset(new FrameArena(bytes));
+    liveness->bindScratch(*arena);
+    hybrid->bindScratch(*arena);
+    for (auto& quality : faceQuality) quality->bindScratch(*arena);
+}
+
+void FrameAnalyzer::setCueMask(unsigned mask) {
+    cueMask = mask;
+    if (hybrid) hybrid->setCueMask(mask);
+    for (auto& quality : faceQuality) quality->setCueMask(mask);
+}
+
+void FrameAnalyzer::setModelLimit(int count) {
+    if (liveness) liveness->setModelLimit(count);
+}
+
+Layer4Hybrid* FrameAnalyzer::addFaceQuality() {
+    faceQuality.emplace_back(new Layer4Hybrid());
+    faceQuality.back()->setCueMask(cueMask);
+    if (arena) faceQuality.back()->bindScratch(*arena);
+    return faceQuality.back().get();
+}
+
+void FrameAnalyzer::reset() {
+    tracker.reset();
+    trackTable.clear();
+}
+
+void FrameAnalyzer::manualReset() {
+    for (size_t i = 0; i < trackTable.size(); ++i) {
+        trackTable.at((int)i).decision.manualReset();
+        trackTable.at((int)i).liveness.reset();
+        trackTable.at((int)i).cascade.reset();
+    }
+}
+
+void FrameAnalyzer::analyze(const cv::Mat& frame, const std::vector<FaceResult>& faces,
+                            std::vector<FaceAnalysis>& results) {
+    matFrame.setBGR(frame);
+    analyze(matFrame, faces, results);
+    matFrame.release();
+}
+
+void FrameAnalyzer::analyze(const VideoFrame& frame, const std::vector<FaceResult>& faces,
+                            std::vector<FaceAnalysis>& results) {
+    if (!liveness || !hybrid) return;
+    if (cascade.isEnabled()) {
+        analyzeCascade(frame, faces, results);
+    } else if (executor) {
+        analyzeParallel(frame, faces, results);
+    } else {
+        analyzeSequential(frame, faces, results);
+    }
+    // Frame done, every scratch buffer of the layers goes back in O(1)
+    if (arena) arena->reset();
+}
+
+void FrameAnalyzer::analyzeSequential(const VideoFrame& frame, const std::vector<FaceResult>& faces,
+                                      std::vector<FaceAnalysis>& results) {
+    prepare(faces, results);
+
+    // Liveness check, one forward pass for every face
+    auto t0 = std::chrono::steady_clock::now();
+    if (!livenessBoxes.empty()) {
+        liveness->checkLivenessBatch(frame, livenessBoxes, livenessStates, livenessResults, *frameParams);
+    }
+    lastLivenessMs = elapsedMs(t0);
+
+    t0 = std::chrono::steady_clock::now();
+    finish(frame, faces, livenessResults.data(), *hybrid, results);
+    lastQualityMs = elapsedMs(t0);
+}
+
+void FrameAnalyzer::prepare(const std::vector<FaceResult>& faces, std::vector<FaceAnalysis>& results,
+                            const DecisionParams& params) {
+    frameParams = &params;
+    // Stable IDs, expired tracks lose their history
+    tracker.setMaxMissedFrames(params.missingFrames);
+    tracker.update(faces, trackIds);
+    for (int id : tracker.getRemovedIds()) trackTable.remove(id);
+
+    const size_t faceCount = faces.size();
+    results.assign(faceCount, FaceAnalysis());
+    tableIndex.resize(faceCount);
+    for (size_t i = 0; i < faceCount; ++i) {
+        tableIndex[i] = trackTable.acquire(trackIds[i]);
+        results[i].trackId = trackIds[i];
+    }
+
+    livenessFaces.clear();
+    withoutLiveness.clear();
+    livenessBoxes.clear();
+    livenessStates.clear();
+    for (size_t i = 0; i < faceCount; ++i) {
+        TrackState& track = trackTable.at(tableIndex[i]);
+        if (faces[i].bbox.width < minFaceWidth) {
+            results[i].state = DecisionState::TOO_FAR;
+            track.liveness.reset();
+            track.decision.reset();
+            track.cascade.reset();
+            continue;
+        }
+        livenessFaces.push_back((int)i);
+        livenessBoxes.push_back(faces[i].bbox);
+        livenessStates.push_back(&track.liveness);
+    }
+}
+
+void FrameAnalyzer::finish(const VideoFrame& frame, const std::vector<FaceResult>& faces,
+                           const LivenessResult* liveResults, Layer4Hybrid& quality,
+                           std::vector<FaceAnalysis>& results) {
+    // Quality analysis
+    const unsigned allCues = (1u << Layer4Hybrid::CUE_COUNT) - 1;
+    adjustments.assign(livenessFaces.size(), 0.0f);
+    adjustmentCues.assign(livenessFaces.size(), QualityCues());
+    adjustmentMasks.assign(livenessFaces.size(), 0u);
+    for (size_t k = 0; k < livenessFaces.size(); ++k) {
+        if (liveResults[k].score < 0.0f) continue;
+        adjustments[k] = quality.analyzeQuality(frame, faces[livenessFaces[k]].bbox, *frameParams);
+        adjustmentCues[k] = quality.getCues();
+        adjustmentMasks[k] = allCues & quality.getCueMask();
+    }
+    decide(liveResults, results);
+}
+
+void FrameAnalyzer::decide(const LivenessResult* liveResults, std::vector<FaceAnalysis>& results) {
+    for (size_t k = 0; k < livenessFaces.size(); ++k) {
+        const LivenessResult& liveResult = liveResults[k];
+        const bool cuesOnly = k < withoutLiveness.size() && withoutLiveness[k];
+        if (liveResult.score < 0.0f && !cuesOnly) continue;
+        int i = livenessFaces[k];
+
+        float adjustment = adjustments[k];
+        TrackState& track = trackTable.at(tableIndex[i]);
+        // Unmeasured liveness stays -1 in the result (events, CSV, JSONL)
+        DecisionOutput decision = cuesOnly
+            ? track.decision.updateWithoutLiveness(adjustment, *frameParams)
+            : track.decision.update(liveResult.score, liveResult.rawScore, adjustment, *frameParams);
+
+        FaceAnalysis& out = results[i];
+        out.state = decision.state;
+        out.rawScore = liveResult.rawScore;
+        out.livenessScore = liveResult.score;
+        out.adjustment = adjustment;
+        out.finalScore = decision.finalScore;
+        out.realStreak = decision.realStreak;
+        Layer4Hybrid::cueAdjustments(adjustmentCues[k], out.cueAdjustment, *frameParams);
+        out.cueMask = adjustmentMasks[k];
+    }
+}
+
+// ===== Task graph: Layer3 batch || (prepare ROI -> 5 cues) per face, join, decide =====
+void FrameAnalyzer::livenessTask(void* self, int) {
+    FrameAnalyzer& fa = *static_cast<FrameAnalyzer*>(self);
+    auto t0 = std::chrono::steady_clock::now();
+    fa.liveness->checkLivenessBatch(*fa.graphFrame, fa.livenessBoxes, fa.livenessStates, fa.livenessResults,
+                                    *fa.frameParams);
+    fa.lastLivenessMs = elapsedMs(t0);
+}
+
+void FrameAnalyzer::prepareCuesTask(void* self, int face) {
+    FrameAnalyzer& fa = *static_cast<FrameAnalyzer*>(self);
+    const cv::Rect& box = (*fa.graphFaces)[fa.livenessFaces[face]].bbox;
+    fa.faceQuality[face]->prepareCues(*fa.graphFrame, box, *fa.frameParams);
+}
+
+void FrameAnalyzer::cueTask(void* self, int faceCue) {
+    FrameAnalyzer& fa = *static_cast<FrameAnalyzer*>(self);
+    fa.faceQuality[faceCue / Layer4Hybrid::CUE_COUNT]->runCue(faceCue % Layer4Hybrid::CUE_COUNT);
+}
+
+void FrameAnalyzer::analyzeParallel(const VideoFrame& frame, const std::vector<FaceResult>& faces,
+                                    std::vector<FaceAnalysis>& results) {
+    prepare(faces, results);
+    const size_t count = livenessFaces.size();
+    lastLivenessMs = 0.0;
+    if (count == 0) {
+        lastQualityMs = 0.0;
+        return;
+    }
+    while (faceQuality.size() < count) addFaceQuality();
+
+    graphFrame = &frame;
+    graphFaces = &faces;
+    graph.clear();
+    graph.add(&FrameAnalyzer::livenessTask, this);
+    for (size_t k = 0; k < count; ++k) {
+        int prep = graph.add(&FrameAnalyzer::prepareCuesTask, this, (int)k);
+        for (int cue = 0; cue < Layer4Hybrid::CUE_COUNT; ++cue) {
+            if (!(cueMask & Layer4Hybrid::cueBit(cue))) continue;
+            int node = graph.add(&FrameAnalyzer::cueTask, this, (int)k * Layer4Hybrid::CUE_COUNT + cue);
+            graph.precede(prep, node);
+        }
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    graph.run(*executor);
+    lastQualityMs = std::max(0.0, elapsedMs(t0) - lastLivenessMs);
+    graphFrame = nullptr;
+    graphFaces = nullptr;
+
+    adjustments.resize(count);
+    adjustmentCues.resize(count);
+    adjustmentMasks.assign(count, ((1u << Layer4Hybrid::CUE_COUNT) - 1) & cueMask);
+    for (size_t k = 0; k < count; ++k) {
+        adjustments[k] = faceQuality[k]->fuseCues();
+        adjustmentCues[k] = faceQuality[k]->getCues();
+    }
+    decide(livenessResults.data(), results);
+}
+
+// ===== Early-exit cascade: stages in config order, a face leaves as soon as the
+// strong verdict of AntiSpoofDecision can no longer change =====
+void FrameAnalyzer::runCascadeLiveness(const VideoFrame& frame) {
+    livenessBoxes.clear();
+    livenessStates.clear();
+    for (int k : cascadeBatch) {
+        const int i = livenessFaces[k];
+        livenessBoxes.push_back((*graphFaces)[i].bbox);
+        livenessStates.push_back(&trackTable.at(tableIndex[i]).liveness);
+    }
+    if (livenessBoxes.empty()) return;
+
+    auto t0 = std::chrono::steady_clock::now();
+    liveness->checkLivenessBatch(frame, livenessBoxes, livenessStates, livenessResults, *frameParams);
+    lastLivenessMs += elapsedMs(t0);
+    CascadeStats::add(cascade.stats().livenessRuns, livenessBoxes.size());
+
+    for (size_t b = 0; b < cascadeBatch.size(); ++b) {
+        const int k = cascadeBatch[b];
+        if (livenessResults[b].score < 0.0f) continue;
+        cascadeLive[k] = livenessResults[b];
+        cascadeFaces[k].hasLiveness = true;
+    }
+}
+
+void FrameAnalyzer::analyzeCascade(const VideoFrame& frame, const std::vector<FaceResult>& faces,
+                                   std::vector<FaceAnalysis>& results) {
+    prepare(faces, results);
+    const size_t count = livenessFaces.size();
+    lastLivenessMs = 0.0;
+    lastQualityMs = 0.0;
+    if (count == 0) return;
+    while (faceQuality.size() < count) addFaceQuality();
+
+    graphFaces = &faces;
+    cascadeFaces.assign(count, CascadeFace());
+    cascadeLive.assign(count, LivenessResult{-1.0f, -1.0f, LivenessStatus::UNCERTAIN});
+    adjustments.assign(count, 0.0f);
+    adjustmentCues.resize(count);
+    adjustmentMasks.resize(count);
+    withoutLiveness.assign(count, 0);
+    const unsigned cheap = CascadeScheduler::stageCues(CascadeStage::CHEAP_CUES);
+    double cueMs = 0.0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t k = 0; k < count; ++k) {
+        CascadeFace& face = cascadeFaces[k];
+        Layer4Hybrid& quality = *faceQuality[k];
+        quality.prepareCues(frame, faces[livenessFaces[k]].bbox, *frameParams);
+        CascadeStats::add(cascade.stats().faces);
+
+        // Settled REAL track: fresh cheap cues, last Layer3 + deep cues
+        const CascadeTrackState& memory = trackTable.at(tableIndex[livenessFaces[k]]).cascade;
+        if (!cascade.mayRunLight(memory)) continue;
+        for (int cue = 0; cue < Layer4Hybrid::CUE_COUNT; ++cue) {
+            if (cheap & Layer4Hybrid::cueBit(cue)) quality.runCue(cue);
+        }
+        face.known = cheap;
+        QualityCues merged = quality.getCues();
+        if (cascade.checkLight(memory, merged, face.exitAdjustment, *frameParams)) {
+            face.light = true;
+            face.done = true;
+            CascadeStats::add(cascade.stats().lightFrames);
+        } else {
+            CascadeStats::add(cascade.stats().escalations);
+        }
+    }
+    cueMs += elapsedMs(t0);
+
+    const std::vector<CascadeStage>& order = cascade.getConfig().order;
+    for (size_t s = 0; s < order.size(); ++s) {
+        const CascadeStage stage = order[s];
+        const bool lastStage = (s + 1 == order.size());
+
+        if (stage == CascadeStage::LIVENESS) {
+            cascadeBatch.clear();
+            for (size_t k = 0; k < count; ++k) {
+                if (!cascadeFaces[k].done) cascadeBatch.push_back((int)k);
+            }
+            runCascadeLiveness(frame);
+        } else {
+            t0 = std::chrono::steady_clock::now();
+            const unsigned mask = CascadeScheduler::stageCues(stage);
+            for (size_t k = 0; k < count; ++k) {
+                CascadeFace& face = cascadeFaces[k];
+                if (face.done || (face.known & mask) == mask) continue;
+                for (int cue = 0; cue < Layer4Hybrid::CUE_COUNT; ++cue) {
+                    if ((mask & Layer4Hybrid::cueBit(cue)) && !(face.known & Layer4Hybrid::cueBit(cue))) {
+                        faceQuality[k]->runCue(cue);
+                    }
+                }
+                face.known |= mask;
+                if (stage == CascadeStage::DEEP_CUES) CascadeStats::add(cascade.stats().deepRuns);
+            }
+            cueMs += elapsedMs(t0);
+        }
+
+        for (size_t k = 0; k < count; ++k) {
+            CascadeFace& face = cascadeFaces[k];
+            if (face.done) continue;
+            if (lastStage) {
+                face.ranAllStages = true;
+                continue;
+            }
+            CascadeVerdict verdict = cascade.check(faceQuality[k]->getCues(), face.known, face.hasLiveness,
+                                                   cascadeLive[k].score, face.exitAdjustment, *frameParams);
+            if (verdict != CascadeVerdict::OPEN) {
+                face.done = true;
+                CascadeStats::add(cascade.stats().earlyExits);
+            }
+        }
+    }
+    lastQualityMs = cueMs;
+
+    // Decide with fresh values where a stage ran, remembered ones where it was skipped
+    for (size_t k = 0; k < count; ++k) {
+        CascadeFace& face = cascadeFaces[k];
+        CascadeTrackState& memory = trackTable.at(tableIndex[livenessFaces[k]]).cascade;
+        const QualityCues& cues = faceQuality[k]->getCues();
+        const unsigned deep = CascadeScheduler::stageCues(CascadeStage::DEEP_CUES);
+
+        adjustments[k] = face.ranAllStages ? faceQuality[k]->fuseCues() : face.exitAdjustment;
+        adjustmentCues[k] = cues;
+        adjustmentMasks[k] = face.known & cueMask;
+        if (face.hasLiveness) {
+            memory.hasLiveness = true;
+            memory.livenessScore = cascadeLive[k].score;
+            memory.rawScore = cascadeLive[k].rawScore;
+        } else if (face.ranAllStages) {
+            continue;   // Layer3 failed on this crop, no decision (as without the cascade)
+        } else if (memory.hasLiveness) {
+            cascadeLive[k].score = memory.livenessScore;
+            cascadeLive[k].rawScore = memory.rawScore;
+        } else {
+            withoutLiveness[k] = 1;   // no score to remember yet: decide from the cues
+        }
+        if ((face.known & deep) == deep) {
+            memory.hasDeep = true;
+            memory.texture = cues.texture;
+            memory.moire = cues.moire;
+            memory.highFrequency = cues.highFrequency;
+        }
+        if (face.hasLiveness && (face.known & deep) == deep) memory.framesSinceFull = 0;
+        else memory.framesSinceFull++;
+    }
+    decide(cascadeLive.data(), results);
+    for (size_t k = 0; k < count; ++k) {
+        trackTable.at(tableIndex[livenessFaces[k]]).cascade.lastState = results[livenessFaces[k]].state;
+    }
+    graphFaces = nullptr;
+}
@@ -0,0 +1,204 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/frame_arena.cpp (Per-worker frame scratch arena)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "frame_arena.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+namespace {
+constexpr size_t slabAlign = 64;
+
+size_t alignUp(size_t n) {
+    return (n + slabAlign - 1) & ~(slabAlign - 1);
+}
+}
+
+FrameArena::FrameArena(size_t bytes, int maxBuffers)
+    : slab(nullptr), slabBytes(alignUp(std::max<size_t>(bytes, slabAlign))),
+      headerCount(std::max(1, maxBuffers)), headers(nullptr),
+      offset(0), nextHeader(0), highWater(0), warned(false), fallbacks(0) {
+    slab = static_cast<uchar*>(std::aligned_alloc(slabAlign, slabBytes));
+    if (!slab) throw std::bad_alloc();
+    headers = static_cast<cv::UMatData*>(::operator new(sizeof(cv::UMatData) * headerCount));
+    for (int i = 0; i < headerCount; ++i) new (&headers[i]) cv::UMatData(this);
+}
+
+FrameArena::~FrameArena() {
+    // Bound headers must not point into the slab (or at this allocator) after it is gone
+    for (cv::Mat* mat : boundMats) {
+        mat->release();
+        mat->allocator = nullptr;
+    }
+    for (std::vector<cv::Mat>* mats : boundVectors) {
+        for (cv::Mat& mat : *mats) {
+            mat.release();
+            mat.allocator = nullptr;
+        }
+    }
+    for (int i = 0; i < headerCount; ++i) headers[i].~UMatData();
+    ::operator delete(headers);
+    std::free(slab);
+}
+
+void FrameArena::bind(cv::Mat& mat) {
+    mat.release();
+    mat.allocator = this;
+    boundMats.push_back(&mat);
+}
+
+void FrameArena::bind(std::vector<cv::Mat>& mats) {
+    for (cv::Mat& mat : mats) {
+        mat.release();
+        mat.allocator = this;
+    }
+    boundVectors.push_back(&mats);
+}
+
+void FrameArena::reset() {
+    // Assigning a view (a = frame(roi)) also copies its allocator, re-arm every header
+    for (cv::Mat* mat : boundMats) {
+        mat->release();
+        mat->allocator = this;
+    }
+    for (std::vector<cv::Mat>* mats : boundVectors) {
+        for (cv::Mat& mat : *mats) {
+            mat.release();
+            mat.allocator = this;
+        }
+    }
+
+    const size_t used = offset.load(std::memory_order_relaxed);
+    if (used > highWater.load(std::memory_order_relaxed)) highWater.store(used, std::memory_order_relaxed);
+    offset.store(0, std::memory_order_relaxed);
+    nextHeader.store(0, std::memory_order_relaxed);
+
+    if (!warned && fallbacks.load(std::memory_order_relaxed) > 0) {
+        warned = true;
+        std::cerr << "[FrameArena] WARN: Frame needed " << getHighWater() / 1024 << " KiB of "
+                  << slabBytes / 1024 << " KiB, overflow goes to the heap" << std::endl;
+    }
+}
+
+cv::UMatData* FrameArena::allocate(int dims, const int* sizes, int type, void* data0, size_t* step,
+                                   cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const {
+    if (data0) {
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data0, step, flags, usageFlags);
+    }
+
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; --i) {
+        if (step) step[i] = total;
+        total *= sizes[i];
+    }
+
+    // Bump both cursors; losing a header to an overflowed slab is fine, reset() rewinds it
+    const size_t bytes = alignUp(std::max<size_t>(total, 1));
+    const size_t start = offset.fetch_add(bytes, std::memory_order_relaxed);
+    const int index = nextHeader.fetch_add(1, std::memory_order_relaxed);
+    if (start + bytes > slabBytes || index >= headerCount) {
+        fallbacks.fetch_add(1, std::memory_order_relaxed);
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data0, step, flags, usageFlags);
+    }
+
+    cv::UMatData* u = &headers[index];
+    u->data = u->origdata = slab + start;
+    u->size = total;
+    u->refcount = 0;
+    u->urefcount = 0;
+    u->currAllocator = u->prevAllocator = this;
+    return u;
+}
+
+bool FrameArena::allocate(cv::UMatData* data, cv::AccessFlag, cv::UMatUsageFlags) const {
+    return data != nullptr;
+}
+
+void FrameArena::deallocate(cv::UMatData* u) const {
+    if (!u || owns(u)) return;   // slab bytes come back at reset()
+    cv::Mat::getStdAllocator()->deallocate(u);
+}
+
+void FrameArena::printStats(const char* tag) const {
+    std::cout << tag << " Frame arena: high water " << std::max(getHighWater(), getUsed()) / 1024
+              << " KiB of " << slabBytes / 1024 << " KiB, heap fallbacks " << getFallbacks() << std::endl;
+}
+
+// ===== Steady-state allocation counter =====
+namespace {
+std::atomic<uint64_t> heapAllocations(0);
+#ifdef FACE_ALLOC_DEBUG
+thread_local int excludeDepth = 0;
+
+void countAllocation() {
+    if (excludeDepth == 0) heapAllocations.fetch_add(1, std::memory_order_relaxed);
+}
+#endif
+
+#ifdef FACE_ALLOC_DEBUG
+// Counts the cv::Mat buffers that do not come from an arena / pool
+class CountingAllocator : public cv::MatAllocator {
+public:
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+        if (!data) countAllocation();
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+    bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override {
+        return cv::Mat::getStdAllocator()->allocate(data, accessFlags, usageFlags);
+    }
+    void deallocate(cv::UMatData* data) const override {
+        cv::Mat::getStdAllocator()->deallocate(data);
+    }
+};
+
+CountingAllocator countingAllocator;
+#endif
+}
+
+#ifdef FACE_ALLOC_DEBUG
+void* operator new(std::size_t n) {
+    countAllocation();
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+#endif
+
+bool AllocationCounter::enabled() {
+#ifdef FACE_ALLOC_DEBUG
+    return true;
+#else
+    return false;
+#endif
+}
+
+void AllocationCounter::install() {
+#ifdef FACE_ALLOC_DEBUG
+    cv::Mat::setDefaultAllocator(&countingAllocator);
+#endif
+}
+
+uint64_t AllocationCounter::count() {
+    return heapAllocations.load(std::memory_order_relaxed);
+}
+
+#ifdef FACE_ALLOC_DEBUG
+AllocationCounter::Exclude::Exclude() {
+    ++excludeDepth;
+}
+
+AllocationCounter::Exclude::~Exclude() {
+    --excludeDepth;
+}
+#endif
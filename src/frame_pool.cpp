@@ -0,0 +1,93 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/frame_pool.cpp (Refcounted frame-buffer pool)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "frame_pool.h"
+#include <iostream>
+
+FramePool::FramePool(int maxSlots)
+    : slotCount(std::max(1, maxSlots)), slots(new Slot[std::max(1, maxSlots)]), fallbacks(0) {
+    for (int i = 0; i < slotCount; ++i) {
+        slots[i].u.reset(new cv::UMatData(this));
+    }
+}
+
+FramePool::~FramePool() {
+    for (int i = 0; i < slotCount; ++i) {
+        if (slots[i].inUse.load()) {
+            // Someone still holds the frame: leak the buffer rather than dangle
+            std::cerr << "[FramePool] WARN: Slot " << i << " still in use at shutdown" << std::endl;
+            slots[i].u.release();
+            continue;
+        }
+        if (slots[i].data) cv::fastFree(slots[i].data);
+    }
+}
+
+void FramePool::acquire(cv::Mat& frame, const cv::Size& size, int type) {
+    // create() would reuse the current buffer when the size matches, so drop it first
+    frame.release();
+    frame.allocator = this;
+    frame.create(size, type);
+}
+
+int FramePool::getInUse() const {
+    int n = 0;
+    for (int i = 0; i < slotCount; ++i) {
+        if (slots[i].inUse.load(std::memory_order_relaxed)) n++;
+    }
+    return n;
+}
+
+cv::UMatData* FramePool::allocate(int dims, const int* sizes, int type, void* data0, size_t* step,
+                                  cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const {
+    if (data0) {
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data0, step, flags, usageFlags);
+    }
+
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; --i) {
+        if (step) step[i] = total;
+        total *= sizes[i];
+    }
+
+    for (int i = 0; i < slotCount; ++i) {
+        Slot& slot = slots[i];
+        bool expected = false;
+        if (!slot.inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) continue;
+
+        if (slot.bytes < total) {
+            // First use (or a bigger frame): the only allocation this slot ever makes
+            if (slot.data) cv::fastFree(slot.data);
+            slot.data = (uchar*)cv::fastMalloc(total);
+            slot.bytes = total;
+        }
+        cv::UMatData* u = slot.u.get();
+        u->data = u->origdata = slot.data;
+        u->size = total;
+        u->refcount = 0;
+        u->urefcount = 0;
+        u->currAllocator = u->prevAllocator = this;
+        return u;
+    }
+
+    fallbacks.fetch_add(1, std::memory_order_relaxed);
+    return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data0, step, flags, usageFlags);
+}
+
+bool FramePool::allocate(cv::UMatData* data, cv::AccessFlag, cv::UMatUsageFlags) const {
+    return data != nullptr;
+}
+
+void FramePool::deallocate(cv::UMatData* u) const {
+    if (!u) return;
+    for (int i = 0; i < slotCount; ++i) {
+        if (slots[i].u.get() == u) {
+            slots[i].inUse.store(false, std::memory_order_release);
+            return;
+        }
+    }
+    // Heap fallback
+    cv::Mat::getStdAllocator()->deallocate(u);
+}
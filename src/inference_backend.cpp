@@ -0,0 +1,286 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/inference_backend.cpp (Pluggable ONNX inference)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "inference_backend.h"
+#include <opencv2/dnn.hpp>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+#ifdef FACE_WITH_ONNXRUNTIME
+#include <onnxruntime_cxx_api.h>
+#endif
+#ifdef FACE_WITH_OPENVINO
+#include <openvino/openvino.hpp>
+#endif
+
+const char* backendKindName(BackendKind kind) {
+    switch (kind) {
+        case BackendKind::ONNXRUNTIME: return "onnxruntime";
+        case BackendKind::OPENVINO:    return "openvino";
+        default:                       return "opencv";
+    }
+}
+
+bool parseBackendKind(const std::string& text, BackendKind& kind) {
+    if (text == "opencv")      { kind = BackendKind::OPENCV; return true; }
+    if (text == "onnxruntime" || text == "ort") { kind = BackendKind::ONNXRUNTIME; return true; }
+    if (text == "openvino")    { kind = BackendKind::OPENVINO; return true; }
+    return false;
+}
+
+bool isBackendAvailable(BackendKind kind) {
+    switch (kind) {
+#ifdef FACE_WITH_ONNXRUNTIME
+        case BackendKind::ONNXRUNTIME: return true;
+#endif
+#ifdef FACE_WITH_OPENVINO
+        case BackendKind::OPENVINO: return true;
+#endif
+        case BackendKind::OPENCV: return true;
+        default: return false;
+    }
+}
+
+std::string resolveModelPath(const std::string& fp32Path, bool preferInt8) {
+    if (!preferInt8) return fp32Path;
+    namespace fs = std::filesystem;
+    fs::path p(fp32Path);
+    fs::path int8 = p.parent_path() / (p.stem().string() + "_int8" + p.extension().string());
+    std::error_code ec;
+    if (fs::exists(int8, ec)) {
+        std::cout << "[Backend] INFO: Using INT8 model " << int8.string() << std::endl;
+        return int8.string();
+    }
+    std::cerr << "[Backend] WARN: No INT8 model next to " << fp32Path << ", using FP32" << std::endl;
+    return fp32Path;
+}
+
+bool ModelBlob::isOrtFormat() const {
+    return name.size() > 4 && name.compare(name.size() - 4, 4, ".ort") == 0;
+}
+
+namespace {
+
+// ===== OpenCV DNN =====
+class OpenCvBackend : public InferenceBackend {
+public:
+    bool load(const std::string& modelPath) override {
+        try {
+            net = cv::dnn::readNetFromONNX(modelPath);
+            return setup();
+        } catch (const cv::Exception& e) {
+            std::cerr << "[Backend] ERROR: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    // Parsed straight from the mapping, no prepacked layout exists for cv::dnn
+    bool load(const ModelBlob& blob) override {
+        if (blob.isOrtFormat()) return false;
+        try {
+            net = cv::dnn::readNetFromONNX(reinterpret_cast<const char*>(blob.data), blob.size);
+            return setup();
+        } catch (const cv::Exception& e) {
+            std::cerr << "[Backend] ERROR: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    bool forward(const cv::Mat& blob, cv::Mat& output) override {
+        try {
+            net.setInput(blob);
+            if (!outputName.empty()) net.forward(raw, outputName);
+            else raw = net.forward();
+            output = raw.reshape(1, blob.size[0]);
+            return true;
+        } catch (const cv::Exception&) {
+            return false;
+        }
+    }
+
+    const char* name() const override { return "opencv"; }
+
+private:
+    bool setup() {
+        if (net.empty()) return false;
+        net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+        net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+        std::vector<std::string> outNames = net.getUnconnectedOutLayersNames();
+        if (!outNames.empty()) outputName = outNames[0];
+        return true;
+    }
+
+    cv::dnn::Net net;
+    std::string outputName;
+    cv::Mat raw;
+};
+
+#ifdef FACE_WITH_ONNXRUNTIME
+// ===== ONNX Runtime CPU (VNNI kernels for QDQ/QOperator INT8 models) =====
+class OrtBackend : public InferenceBackend {
+public:
+    explicit OrtBackend(int threads)
+        : env(ORT_LOGGING_LEVEL_WARNING, "face_app"),
+          memoryInfo(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)) {
+        sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+        if (threads > 0) sessionOptions.SetIntraOpNumThreads(threads);
+    }
+
+    bool load(const std::string& modelPath) override {
+        try {
+            session.reset(new Ort::Session(env, modelPath.c_str(), sessionOptions));
+            return readNames();
+        } catch (const Ort::Exception& e) {
+            std::cerr << "[Backend] ERROR: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    // ORT format: graph already optimised and weights used in place from the mapping
+    bool load(const ModelBlob& blob) override {
+        try {
+            Ort::SessionOptions options = sessionOptions.Clone();
+            if (blob.isOrtFormat()) {
+                options.AddConfigEntry("session.load_model_format", "ORT");
+                options.AddConfigEntry("session.use_ort_model_bytes_directly", "1");
+                options.AddConfigEntry("session.use_ort_model_bytes_for_initializers", "1");
+                modelBytes = blob.keepAlive;
+            }
+            session.reset(new Ort::Session(env, blob.data, blob.size, options));
+            return readNames();
+        } catch (const Ort::Exception& e) {
+            std::cerr << "[Backend] ERROR: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    bool forward(const cv::Mat& blob, cv::Mat& output) override {
+        if (!session || !blob.isContinuous() || blob.dims != 4) return false;
+        try {
+            int64_t shape[4] = {blob.size[0], blob.size[1], blob.size[2], blob.size[3]};
+            Ort::Value input = Ort::Value::CreateTensor<float>(
+                memoryInfo, (float*)blob.ptr<float>(), blob.total(), shape, 4);
+            const char* inNames[] = {inputName.c_str()};
+            const char* outNames[] = {outputName.c_str()};
+            std::vector<Ort::Value> outputs = session->Run(Ort::RunOptions{nullptr}, inNames, &input, 1, outNames, 1);
+
+            Ort::TensorTypeAndShapeInfo info = outputs[0].GetTensorTypeAndShapeInfo();
+            size_t total = info.GetElementCount();
+            int batch = blob.size[0];
+            cv::Mat(batch, (int)(total / batch), CV_32F, outputs[0].GetTensorMutableData<float>()).copyTo(output);
+            return true;
+        } catch (const Ort::Exception&) {
+            return false;
+        }
+    }
+
+    const char* name() const override { return "onnxruntime"; }
+
+private:
+    bool readNames() {
+        Ort::AllocatorWithDefaultOptions allocator;
+        inputName = session->GetInputNameAllocated(0, allocator).get();
+        outputName = session->GetOutputNameAllocated(0, allocator).get();
+        return true;
+    }
+
+    std::shared_ptr<const void> modelBytes;   // ORT format reads weights from here
+    Ort::Env env;
+    Ort::SessionOptions sessionOptions;
+    Ort::MemoryInfo memoryInfo;
+    std::unique_ptr<Ort::Session> session;
+    std::string inputName;
+    std::string outputName;
+};
+#endif
+
+#ifdef FACE_WITH_OPENVINO
+// ===== OpenVINO CPU =====
+class OpenVinoBackend : public InferenceBackend {
+public:
+    explicit OpenVinoBackend(int threads) : threads(threads) {}
+
+    bool load(const std::string& modelPath) override {
+        try {
+            return compile(core.read_model(modelPath), modelPath);
+        } catch (const std::exception& e) {
+            std::cerr << "[Backend] ERROR: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    bool load(const ModelBlob& blob) override {
+        if (blob.isOrtFormat()) return false;
+        try {
+            // ONNX frontend reads the model bytes from a string, weights are embedded
+            std::string bytes(reinterpret_cast<const char*>(blob.data), blob.size);
+            return compile(core.read_model(bytes, ov::Tensor()), blob.name);
+        } catch (const std::exception& e) {
+            std::cerr << "[Backend] ERROR: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    bool forward(const cv::Mat& blob, cv::Mat& output) override {
+        if (!blob.isContinuous() || blob.dims != 4) return false;
+        try {
+            ov::Shape shape = {(size_t)blob.size[0], (size_t)blob.size[1], (size_t)blob.size[2], (size_t)blob.size[3]};
+            ov::Tensor input(ov::element::f32, shape, (void*)blob.ptr<float>());
+            request.set_input_tensor(input);
+            request.infer();
+            const ov::Tensor& result = request.get_output_tensor();
+            int batch = blob.size[0];
+            cv::Mat(batch, (int)(result.get_size() / batch), CV_32F, (void*)result.data<float>()).copyTo(output);
+            return true;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    const char* name() const override { return "openvino"; }
+
+private:
+    bool compile(std::shared_ptr<ov::Model> model, const std::string& label) {
+        // Dynamic batch so all faces of a frame go in one request
+        try {
+            ov::PartialShape shape = model->input().get_partial_shape();
+            shape[0] = ov::Dimension::dynamic();
+            model->reshape(shape);
+        } catch (const std::exception&) {
+            std::cerr << "[Backend] WARN: " << label << " keeps a static batch" << std::endl;
+        }
+        ov::AnyMap config = {ov::hint::performance_mode(ov::hint::PerformanceMode::LATENCY)};
+        if (threads > 0) config.emplace(ov::inference_num_threads(threads));
+        compiled = core.compile_model(model, "CPU", config);
+        request = compiled.create_infer_request();
+        return true;
+    }
+
+    int threads;
+    ov::Core core;
+    ov::CompiledModel compiled;
+    ov::InferRequest request;
+};
+#endif
+
+}
+
+std::unique_ptr<InferenceBackend> createInferenceBackend(const BackendOptions& options) {
+    switch (options.kind) {
+#ifdef FACE_WITH_ONNXRUNTIME
+        case BackendKind::ONNXRUNTIME: return std::unique_ptr<InferenceBackend>(new OrtBackend(options.threads));
+#endif
+#ifdef FACE_WITH_OPENVINO
+        case BackendKind::OPENVINO: return std::unique_ptr<InferenceBackend>(new OpenVinoBackend(options.threads));
+#endif
+        case BackendKind::OPENCV: break;
+        default:
+            std::cerr << "[Backend] WARN: " << backendKindName(options.kind)
+                      << " not compiled in, using OpenCV DNN" << std::endl;
+            break;
+    }
+    return std::unique_ptr<InferenceBackend>(new OpenCvBackend());
+}
@@ -0,0 +1,171 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/landmark_tracker.cpp (Keyframe face propagation)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "landmark_tracker.h"
+#include <opencv2/video/tracking.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+float median(std::vector<float>& v) {
+    size_t mid = v.size() / 2;
+    std::nth_element(v.begin(), v.begin() + mid, v.end());
+    return v[mid];
+}
+}
+
+LandmarkTracker::LandmarkTracker()
+    : interval(2), framesSinceKeyframe(0), forceKeyframe(true), peakMotion(0.0f) {}
+
+void LandmarkTracker::setConfig(const TrackingConfig& cfg) {
+    config = cfg;
+    config.minInterval = std::max(1, config.minInterval);
+    config.maxInterval = std::max(config.minInterval, config.maxInterval);
+    interval = config.minInterval;
+    forceKeyframe = true;
+}
+
+bool LandmarkTracker::needsKeyframe() const {
+    if (forceKeyframe) return true;
+    // Nobody in view: new faces can only come from the detector
+    if (tracked.empty()) return framesSinceKeyframe >= config.minInterval;
+    return framesSinceKeyframe >= interval;
+}
+
+void LandmarkTracker::toGray(const cv::Mat& frame, cv::Mat& dst) {
+    cv::resize(frame, smallBuffer, cv::Size(), config.workScale, config.workScale, cv::INTER_AREA);
+    if (smallBuffer.channels() == 3) cv::cvtColor(smallBuffer, dst, cv::COLOR_BGR2GRAY);
+    else smallBuffer.copyTo(dst);
+}
+
+// 5 landmarks + a grid over the inner face, in work-scale coordinates
+void LandmarkTracker::buildPoints(const std::vector<FaceResult>& faces) {
+    const float s = config.workScale;
+    prevPts.clear();
+    for (const FaceResult& face : faces) {
+        for (int k = 0; k < 5; ++k) {
+            cv::Point2f p = k < (int)face.landmarks.size() ? face.landmarks[k]
+                          : cv::Point2f(face.bbox.x + face.bbox.width * 0.5f, face.bbox.y + face.bbox.height * 0.5f);
+            prevPts.push_back(cv::Point2f(p.x * s, p.y * s));
+        }
+        for (int gy = 0; gy < gridSide; ++gy) {
+            for (int gx = 0; gx < gridSide; ++gx) {
+                float fx = face.bbox.x + face.bbox.width * (0.25f + 0.25f * gx);
+                float fy = face.bbox.y + face.bbox.height * (0.25f + 0.25f * gy);
+                prevPts.push_back(cv::Point2f(fx * s, fy * s));
+            }
+        }
+    }
+}
+
+void LandmarkTracker::resetKeyframe(const cv::Mat& frame, const std::vector<FaceResult>& faces) {
+    // Adapt the interval to the fastest face of the finished segment
+    if (!tracked.empty()) {
+        if (peakMotion > config.fastMotion) {
+            interval = std::max(config.minInterval, interval / 2);
+        } else if (peakMotion < config.slowMotion) {
+            interval = std::min(config.maxInterval, interval + 1);
+        }
+    }
+
+    toGray(frame, prevGray);
+    tracked = faces;
+    framesSinceKeyframe = 0;
+    forceKeyframe = false;
+    peakMotion = 0.0f;
+}
+
+bool LandmarkTracker::propagate(const cv::Mat& frame, std::vector<FaceResult>& faces) {
+    framesSinceKeyframe++;
+    toGray(frame, currGray);
+
+    if (tracked.empty()) {
+        faces.clear();
+        std::swap(prevGray, currGray);
+        return true;
+    }
+
+    buildPoints(tracked);
+    const cv::Size win(15, 15);
+    const cv::TermCriteria criteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 10, 0.03);
+    cv::calcOpticalFlowPyrLK(prevGray, currGray, prevPts, nextPts, status, err, win, 2, criteria);
+    cv::calcOpticalFlowPyrLK(currGray, prevGray, nextPts, backPts, backStatus, err, win, 2, criteria);
+
+    const float s = config.workScale;
+    float frameMotion = 0.0f;
+
+    for (size_t f = 0; f < tracked.size(); ++f) {
+        const size_t base = f * pointsPerFace;
+        FaceResult& face = tracked[f];
+
+        dxs.clear(); dys.clear();
+        cv::Point2f prevCenter(0, 0), nextCenter(0, 0);
+        for (int k = 0; k < pointsPerFace; ++k) {
+            size_t i = base + k;
+            if (!status[i] || !backStatus[i]) continue;
+            cv::Point2f fb = backPts[i] - prevPts[i];
+            if (fb.x * fb.x + fb.y * fb.y > 1.0f) continue;
+            dxs.push_back(nextPts[i].x - prevPts[i].x);
+            dys.push_back(nextPts[i].y - prevPts[i].y);
+            prevCenter += prevPts[i];
+            nextCenter += nextPts[i];
+        }
+
+        int valid = (int)dxs.size();
+        if ((float)valid / pointsPerFace < config.minQuality || valid < 4) {
+            forceKeyframe = true;
+            return false;
+        }
+        prevCenter = prevCenter * (1.0f / valid);
+        nextCenter = nextCenter * (1.0f / valid);
+
+        // Scale change = median ratio of spreads around the point centroid
+        ratios.clear();
+        for (int k = 0; k < pointsPerFace; ++k) {
+            size_t i = base + k;
+            if (!status[i] || !backStatus[i]) continue;
+            cv::Point2f dp = prevPts[i] - prevCenter;
+            cv::Point2f dn = nextPts[i] - nextCenter;
+            float lp = std::sqrt(dp.x * dp.x + dp.y * dp.y);
+            if (lp < 1.0f) continue;
+            ratios.push_back(std::sqrt(dn.x * dn.x + dn.y * dn.y) / lp);
+        }
+        float scale = ratios.empty() ? 1.0f : std::max(0.8f, std::min(1.25f, median(ratios)));
+        float dx = median(dxs) / s;
+        float dy = median(dys) / s;
+
+        float cx = face.bbox.x + face.bbox.width * 0.5f + dx;
+        float cy = face.bbox.y + face.bbox.height * 0.5f + dy;
+        float w = face.bbox.width * scale;
+        float h = face.bbox.height * scale;
+        face.bbox = cv::Rect((int)std::lround(cx - w * 0.5f), (int)std::lround(cy - h * 0.5f),
+                             (int)std::lround(w), (int)std::lround(h));
+        face.bbox &= cv::Rect(0, 0, frame.cols, frame.rows);
+        if (face.bbox.area() == 0) {
+            forceKeyframe = true;
+            return false;
+        }
+
+        for (int k = 0; k < (int)face.landmarks.size() && k < 5; ++k) {
+            size_t i = base + k;
+            cv::Point2f fb = backPts[i] - prevPts[i];
+            if (status[i] && backStatus[i] && fb.x * fb.x + fb.y * fb.y <= 1.0f) {
+                face.landmarks[k] = cv::Point2f(nextPts[i].x / s, nextPts[i].y / s);
+            } else {
+                face.landmarks[k] += cv::Point2f(dx, dy);
+            }
+        }
+
+        frameMotion = std::max(frameMotion, std::sqrt(dx * dx + dy * dy) / std::max(1, face.bbox.width));
+    }
+
+    peakMotion = std::max(peakMotion, frameMotion);
+    // Face moving much faster than the interval assumes: re-detect next frame
+    if (frameMotion > 2.0f * config.fastMotion) forceKeyframe = true;
+
+    std::swap(prevGray, currGray);
+    faces = tracked;
+    return true;
+}
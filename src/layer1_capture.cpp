@@ -5,8 +5,16 @@
 // =================================================================
 #include "layer1_capture.h"
 #include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <thread>
 
-Layer1Capture::Layer1Capture() : isInitialized(false), displaySize(640, 480) {}
+Layer1Capture::Layer1Capture()
+    : isInitialized(false), captureWidth(0), captureHeight(0), displaySize(640, 480),
+      offline(false), imageIndex(0), frameIndex(0) {}
 
 Layer1Capture::~Layer1Capture() {
     release();
@@ -15,17 +23,19 @@ Layer1Capture::~Layer1Capture() {
 bool Layer1Capture::init(int camID, int captureWidth, int captureHeight, 
                          int displayWidth, int displayHeight) {
     if (isInitialized) release();
+    offline = false;
 
     displaySize = cv::Size(displayWidth, displayHeight);
     this->captureWidth = captureWidth;
     this->captureHeight = captureHeight;
 
+    // Back-off 100 / 200 / 400 ms: a camera still held by the previous process is usually free quickly
     for(int i = 0; i < 3; ++i) {
         cap.open(camID, cv::CAP_V4L2);
         if (!cap.isOpened()) cap.open(camID, cv::CAP_ANY);
         if (cap.isOpened()) break;
         std::cout << "[Layer1] WARN: Camera busy, retrying... (" << i+1 << ")" << std::endl;
-        cv::waitKey(500);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100 << i));
     }
 
     if (!cap.isOpened()) return false;
@@ -33,14 +43,110 @@ bool Layer1Capture::init(int camID, int captureWidth, int captureHeight,
     cap.set(cv::CAP_PROP_FRAME_WIDTH, captureWidth);
     cap.set(cv::CAP_PROP_FRAME_HEIGHT, captureHeight);
     cap.set(cv::CAP_PROP_FPS, 30);
+    // Wait for the first real frame only; exposure settles while the pipeline runs
     cv::Mat dummy;
-    for(int i = 0; i < 10; i++) cap.read(dummy);
+    for(int i = 0; i < 10; i++) {
+        if (cap.read(dummy) && !dummy.empty()) break;
+    }
 
     isInitialized = true;
     std::cout << "[Layer1] INFO: Camera OK (" << captureWidth << "x" << captureHeight << ")" << std::endl;
     return true;
 }
 
+bool Layer1Capture::initV4L2(const V4L2Config& config, int displayWidth, int displayHeight) {
+    if (isInitialized) release();
+    offline = false;
+    displaySize = cv::Size(displayWidth, displayHeight);
+
+    v4l2.reset(new V4L2Capture());
+    if (!v4l2->open(config)) {
+        v4l2.reset();
+        return false;
+    }
+    captureWidth = v4l2->getSize().width;
+    captureHeight = v4l2->getSize().height;
+    isInitialized = true;
+    std::cout << "[Layer1] INFO: V4L2 camera OK (" << captureWidth << "x" << captureHeight << ")" << std::endl;
+    return true;
+}
+
+bool Layer1Capture::initFakeDevice(const std::string& path, int width, int height, int fps,
+                                   int displayWidth, int displayHeight) {
+    if (isInitialized) release();
+    offline = false;
+    displaySize = cv::Size(displayWidth, displayHeight);
+
+    v4l2.reset(new V4L2Capture());
+    if (!v4l2->openFile(path, width, height, fps)) {
+        v4l2.reset();
+        return false;
+    }
+    captureWidth = width;
+    captureHeight = height;
+    isInitialized = true;
+    return true;
+}
+
+bool Layer1Capture::openSource(const std::string& path) {
+    if (isInitialized) release();
+    namespace fs = std::filesystem;
+
+    offline = true;
+    sourcePath = path;
+    imageList.clear();
+    imageIndex = 0;
+    frameIndex = 0;
+
+    std::error_code ec;
+    std::string ext = fs::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+    if (fs::is_directory(path, ec)) {
+        for (const auto& entry : fs::directory_iterator(path, ec)) {
+            std::string e = entry.path().extension().string();
+            std::transform(e.begin(), e.end(), e.begin(), ::tolower);
+            if (e == ".jpg" || e == ".jpeg" || e == ".png" || e == ".bmp" || e == ".webp") {
+                imageList.push_back(entry.path().string());
+            }
+        }
+        std::sort(imageList.begin(), imageList.end());
+    } else if (ext == ".txt" || ext == ".lst") {
+        // Manifest, relative paths are relative to the manifest itself
+        std::ifstream manifest(path);
+        fs::path base = fs::path(path).parent_path();
+        std::string line;
+        while (std::getline(manifest, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+            fs::path p(line);
+            imageList.push_back(p.is_absolute() ? line : (base / p).string());
+        }
+    } else {
+        cap.open(path, cv::CAP_ANY);
+        if (!cap.isOpened()) {
+            std::cerr << "[Layer1] ERROR: Cannot open video " << path << std::endl;
+            return false;
+        }
+        captureWidth = (int)cap.get(cv::CAP_PROP_FRAME_WIDTH);
+        captureHeight = (int)cap.get(cv::CAP_PROP_FRAME_HEIGHT);
+        isInitialized = true;
+        std::cout << "[Layer1] INFO: Video source " << path << " (" << captureWidth << "x" << captureHeight << ")" << std::endl;
+        return true;
+    }
+
+    if (imageList.empty()) {
+        std::cerr << "[Layer1] ERROR: No images found in " << path << std::endl;
+        return false;
+    }
+    cv::Mat first = cv::imread(imageList[0]);
+    captureWidth = first.cols;
+    captureHeight = first.rows;
+    isInitialized = true;
+    std::cout << "[Layer1] INFO: Image source " << path << " (" << imageList.size() << " images)" << std::endl;
+    return true;
+}
+
 int Layer1Capture::getMinFaceWidth() const {
     return captureWidth / 8; 
 }
@@ -50,25 +156,69 @@ cv::Size Layer1Capture::getCaptureSize() const {
 }
 
 bool Layer1Capture::grabFrame(cv::Mat& frame) {
-    if (!isInitialized || !cap.isOpened()) return false;
-    
+    if (!isInitialized) return false;
+    FACE_SCOPED_TIMER(MetricStage::CAPTURE);
+
+    if (offline && !imageList.empty()) {
+        while (imageIndex < imageList.size()) {
+            frameName = imageList[imageIndex++];
+            frame = cv::imread(frameName, cv::IMREAD_COLOR);
+            if (!frame.empty()) return true;
+            std::cerr << "[Layer1] WARN: Cannot read " << frameName << std::endl;
+        }
+        return false;
+    }
+
+    if (v4l2) {
+        if (!v4l2->grab(rawFrame)) return false;
+        // BGR lands in a pooled slot, the driver buffer goes back right away
+        framePool.acquire(frame, v4l2->getSize(), CV_8UC3);
+        bool ok = v4l2->toBGR(rawFrame, frame);
+        rawFrame.release();
+        return ok;
+    }
+
+    if (!cap.isOpened()) return false;
     if (!cap.read(frame) || frame.empty()) {
         return false;
     }
+    if (offline) frameName = sourcePath + "#" + std::to_string(frameIndex++);
     return true; 
 }
 
-void Layer1Capture::show(const cv::String& windowName, const cv::Mat& frame) {
-    if (frame.empty()) return;
-    if (frame.size() == displaySize) {
-        cv::imshow(windowName, frame);
-    } else {
-        cv::resize(frame, displayBuffer, displaySize);
-        cv::imshow(windowName, displayBuffer);
+bool Layer1Capture::grabFrame(VideoFrame& frame) {
+    if (!isInitialized) return false;
+
+    if (v4l2 && v4l2->getFormat() == V4L2PixelFormat::YUYV) {
+        FACE_SCOPED_TIMER(MetricStage::CAPTURE);
+        if (!v4l2->grab(rawFrame)) return false;
+        // Copy, not convert: a frame can sit in the pipeline queues longer than
+        // the driver has buffers, so the mmap buffer goes back right away
+        framePool.acquire(yuyvFrame, v4l2->getSize(), CV_8UC2);
+        rawFrame.copyTo(yuyvFrame);
+        rawFrame.release();
+        frame.setYUYV(yuyvFrame);
+        yuyvFrame.release();
+        return true;
     }
+
+    // BGR source: reuse the frame's buffer when nobody else holds it
+    cv::Mat target = frame.getLayout() == PixelLayout::BGR ? frame.getNative() : cv::Mat();
+    frame.release();
+    if (!grabFrame(target)) return false;
+    frame.setBGR(target);
+    return true;
 }
 
 void Layer1Capture::release() {
     if (cap.isOpened()) cap.release();
+    rawFrame.release();
+    if (v4l2) {
+        if (framePool.getFallbacks() > 0) {
+            std::cout << "[Layer1] INFO: Frame pool fell back to the heap " << framePool.getFallbacks() << " times" << std::endl;
+        }
+        v4l2.reset();
+    }
     isInitialized = false;
+    offline = false;
 }
\ No newline at end of file
@@ -4,17 +4,62 @@
 // Email: trannguyenhien29085@gmail.com
 // =================================================================
 #include "layer2_detection.h"
+#include <opencv2/dnn.hpp>
 #include <iostream>
+#include "model_bundle.h"
 
-Layer2Detection::Layer2Detection() : isInitialized(false), currentInputSize(0, 0) {}
+Layer2Detection::Layer2Detection()
+    : isInitialized(false), modelBundle(nullptr), currentInputSize(0, 0),
+      mapOffset(0, 0), mapScale(1, 1), framesSinceFullScan(0),
+      trackingEnabled(false), frameCount(0), detectorRuns(0) {}
 Layer2Detection::~Layer2Detection() {}
 
 bool Layer2Detection::init(const std::string& modelPath, float scoreThreshold, float nmsThreshold) {
+    int backendId = cv::dnn::DNN_BACKEND_OPENCV;
+    if (backendOptions.kind == BackendKind::OPENVINO) {
+        backendId = cv::dnn::DNN_BACKEND_INFERENCE_ENGINE;
+    } else if (backendOptions.kind == BackendKind::ONNXRUNTIME) {
+        std::cerr << "[Layer2] WARN: YuNet has no ONNX Runtime path, using OpenCV DNN" << std::endl;
+    }
+    ModelBlob blob;
+    BackendOptions bundleOptions = backendOptions;
+    bundleOptions.kind = BackendKind::OPENCV;   // no .ort variant for cv::FaceDetectorYN
+
     try {
-        model = cv::FaceDetectorYN::create(
-            modelPath, "", cv::Size(320, 320), 
-            scoreThreshold, nmsThreshold, 5000
-        );
+        std::vector<uchar> buffer;
+        std::string path;
+        if (modelBundle && modelBundle->find(modelPath, bundleOptions, blob)) {
+            // FaceDetectorYN only takes an owning buffer: one memcpy from the mapping, no file read
+            buffer.assign(blob.data, blob.data + blob.size);
+        } else {
+            path = resolveModelPath(modelPath, backendOptions.preferInt8);
+        }
+        auto create = [&](int backend) {
+            if (!buffer.empty()) {
+                return cv::FaceDetectorYN::create("onnx", buffer, std::vector<uchar>(), cv::Size(320, 320),
+                                                  scoreThreshold, nmsThreshold, 5000, backend, cv::dnn::DNN_TARGET_CPU);
+            }
+            return cv::FaceDetectorYN::create(path, "", cv::Size(320, 320), scoreThreshold, nmsThreshold, 5000,
+                                              backend, cv::dnn::DNN_TARGET_CPU);
+        };
+
+        if (backendId == cv::dnn::DNN_BACKEND_INFERENCE_ENGINE) {
+            // Stock OpenCV builds have no Inference Engine: the backend only fails
+            // at the first forward, so probe one blank frame here
+            try {
+                model = create(backendId);
+                cv::Mat probe(320, 320, CV_8UC3, cv::Scalar::all(0)), faces;
+                if (!model.empty()) model->detect(probe, faces);
+            } catch (const cv::Exception&) {
+                model.reset();
+            }
+            if (model.empty()) {
+                std::cerr << "[Layer2] WARN: OpenVINO (Inference Engine) not available in this OpenCV build, "
+                          << "YuNet runs on OpenCV DNN" << std::endl;
+                backendId = cv::dnn::DNN_BACKEND_OPENCV;
+            }
+        }
+        if (backendId == cv::dnn::DNN_BACKEND_OPENCV) model = create(backendId);
         
         if (model.empty()) {
             std::cerr << "[Layer2] ERROR: Failed to load YuNet model at " << modelPath << std::endl;
@@ -30,27 +75,186 @@ bool Layer2Detection::init(const std::string& modelPath, float scoreThreshold, f
     }
 }
 
-bool Layer2Detection::detect(const cv::Mat& frame, FaceResult& result) {
+void Layer2Detection::setScaleConfig(const DetectionScaleConfig& config) {
+    scaleConfig = config;
+    lastFacesRegion = cv::Rect();
+    framesSinceFullScan = 0;
+    std::cout << "[Layer2] INFO: Detection downscale " << (config.downscale ? "ON" : "OFF")
+              << ", ROI search " << (config.roiMode ? "ON" : "OFF") << std::endl;
+}
+
+// Area around the faces of the previous frame, snapped to 64 px so the
+// detector input size (and its internal buffers) changes rarely
+cv::Rect Layer2Detection::searchRegion(const cv::Size& frameSize) const {
+    int mx = (int)(lastFacesRegion.width * scaleConfig.roiMargin);
+    int my = (int)(lastFacesRegion.height * scaleConfig.roiMargin);
+    int w = ((lastFacesRegion.width + 2 * mx + 63) / 64) * 64;
+    int h = ((lastFacesRegion.height + 2 * my + 63) / 64) * 64;
+    int x = lastFacesRegion.x + lastFacesRegion.width / 2 - w / 2;
+    int y = lastFacesRegion.y + lastFacesRegion.height / 2 - h / 2;
+    return cv::Rect(x, y, w, h) & cv::Rect(0, 0, frameSize.width, frameSize.height);
+}
+
+bool Layer2Detection::runOnRegion(const cv::Mat& frame, const cv::Rect& region) {
+    cv::Mat src = frame(region);
+    mapOffset = cv::Point2f((float)region.x, (float)region.y);
+    mapScale = cv::Point2f(1.0f, 1.0f);
+
+    float scale = 1.0f;
+    if (scaleConfig.downscale && scaleConfig.minFaceWidth > 0) {
+        // Smallest wanted face must still cover the smallest detector anchor
+        scale = (float)scaleConfig.minDetectableFace / scaleConfig.minFaceWidth;
+        scale = std::max(scale, (float)scaleConfig.minInputWidth / frame.cols);
+        scale = std::min(1.0f, scale);
+    }
+    if (scaleConfig.maxInputWidth > 0) {
+        scale = std::min(scale, (float)scaleConfig.maxInputWidth / frame.cols);
+    }
+
+    if (scale < 1.0f) {
+        cv::Size target(std::max(32, (int)std::lround(region.width * scale)),
+                        std::max(32, (int)std::lround(region.height * scale)));
+        cv::resize(src, detectBuffer, target, 0, 0, cv::INTER_AREA);
+        src = detectBuffer;
+        mapScale = cv::Point2f((float)region.width / target.width, (float)region.height / target.height);
+    }
+
+    if (src.size() != currentInputSize) {
+        model->setInputSize(src.size());
+        currentInputSize = src.size();
+    }
+    model->detect(src, facesResultBuffer);
+    detectorRuns.fetch_add(1, std::memory_order_relaxed);
+    return facesResultBuffer.rows > 0;
+}
+
+bool Layer2Detection::warmUp(const cv::Size& frameSize) {
+    if (!isInitialized || model.empty() || frameSize.area() <= 0) return false;
+    cv::Mat blank(frameSize, CV_8UC3, cv::Scalar::all(0));
+    bool ok = true;
+    try {
+        runOnRegion(blank, cv::Rect(0, 0, blank.cols, blank.rows));
+    } catch (const cv::Exception& e) {
+        std::cerr << "[Layer2] WARN: Warm-up failed: " << e.what() << std::endl;
+        ok = false;
+    }
+    detectorRuns.store(0, std::memory_order_relaxed);   // not a frame
+    return ok;
+}
+
+bool Layer2Detection::runModel(const cv::Mat& frame) {
     if (!isInitialized || model.empty() || frame.empty()) return false;
-    if (frame.size() != currentInputSize) {
-        model->setInputSize(frame.size());
-        currentInputSize = frame.size();
+
+    if (scaleConfig.roiMode && !lastFacesRegion.empty() &&
+        framesSinceFullScan < scaleConfig.fullScanInterval) {
+        framesSinceFullScan++;
+        cv::Rect region = searchRegion(frame.size());
+        if (region.area() > 0 && runOnRegion(frame, region)) return true;
     }
-    model->detect(frame, facesResultBuffer);
-    
-    if (facesResultBuffer.rows < 1) return false;
 
-    float* data = facesResultBuffer.ptr<float>(0);  
+    // Full frame (no ROI, periodic rescan, or the face left the ROI)
+    framesSinceFullScan = 0;
+    return runOnRegion(frame, cv::Rect(0, 0, frame.cols, frame.rows));
+}
+
+void Layer2Detection::parseRow(int row, const cv::Size& frameSize, FaceResult& result) const {
+    const float* data = facesResultBuffer.ptr<float>(row);
     result.confidence = data[14];
-    result.bbox = cv::Rect((int)data[0], (int)data[1], (int)data[2], (int)data[3]);
-    result.bbox = result.bbox & cv::Rect(0, 0, frame.cols, frame.rows);
-    result.landmarks.clear();
-    
-    result.landmarks.push_back(cv::Point2f(data[4], data[5]));   
-    result.landmarks.push_back(cv::Point2f(data[6], data[7]));   
-    result.landmarks.push_back(cv::Point2f(data[8], data[9]));   
-    result.landmarks.push_back(cv::Point2f(data[10], data[11])); 
-    result.landmarks.push_back(cv::Point2f(data[12], data[13]));
+    result.bbox = cv::Rect((int)(data[0] * mapScale.x + mapOffset.x), (int)(data[1] * mapScale.y + mapOffset.y),
+                           (int)(data[2] * mapScale.x), (int)(data[3] * mapScale.y));
+    result.bbox = result.bbox & cv::Rect(0, 0, frameSize.width, frameSize.height);
+    result.landmarks.resize(5);
+    for (int k = 0; k < 5; ++k) {
+        result.landmarks[k] = cv::Point2f(data[4 + 2 * k] * mapScale.x + mapOffset.x,
+                                          data[5 + 2 * k] * mapScale.y + mapOffset.y);
+    }
+}
 
+bool Layer2Detection::detect(const cv::Mat& frame, FaceResult& result) {
+    frameCount.fetch_add(1, std::memory_order_relaxed);
+    if (!runModel(frame)) {
+        lastFacesRegion = cv::Rect();
+        return false;
+    }
+    parseRow(0, frame.size(), result);
+    lastFacesRegion = result.bbox;
     return true;
-}
\ No newline at end of file
+}
+
+int Layer2Detection::detectAll(const cv::Mat& frame, std::vector<FaceResult>& results) {
+    frameCount.fetch_add(1, std::memory_order_relaxed);
+    bool found = runModel(frame);
+    lastFacesRegion = cv::Rect();
+    if (!found) {
+        results.clear();
+        return 0;
+    }
+    // resize() keeps the landmark vectors of previous frames alive
+    results.resize(facesResultBuffer.rows);
+    for (int i = 0; i < facesResultBuffer.rows; ++i) {
+        parseRow(i, frame.size(), results[i]);
+        lastFacesRegion = lastFacesRegion.empty() ? results[i].bbox : (lastFacesRegion | results[i].bbox);
+    }
+    return (int)results.size();
+}
+
+void Layer2Detection::enableTracking(const TrackingConfig& config) {
+    tracker.setConfig(config);
+    trackingEnabled.store(true, std::memory_order_relaxed);
+    std::cout << "[Layer2] INFO: Keyframe tracking ON (interval " << config.minInterval
+              << "-" << config.maxInterval << ")" << std::endl;
+}
+
+void Layer2Detection::setKeyframeInterval(int maxInterval) {
+    if (maxInterval <= 1) {
+        trackingEnabled.store(false, std::memory_order_relaxed);
+        return;
+    }
+    TrackingConfig config = tracker.getConfig();
+    config.maxInterval = maxInterval;
+    config.minInterval = std::min(config.minInterval, maxInterval);
+    tracker.setConfig(config);   // next frame is a keyframe
+    trackingEnabled.store(true, std::memory_order_relaxed);
+}
+
+int Layer2Detection::detectTracked(const cv::Mat& frame, std::vector<FaceResult>& results) {
+    if (!trackingEnabled.load(std::memory_order_relaxed)) return detectAll(frame, results);
+    if (frame.empty()) {
+        results.clear();
+        return 0;
+    }
+
+    if (!tracker.needsKeyframe()) {
+        if (tracker.propagate(frame, results)) {
+            frameCount.fetch_add(1, std::memory_order_relaxed);
+            return (int)results.size();
+        }
+    }
+
+    // Keyframe (scheduled or tracking lost)
+    detectAll(frame, results);
+    tracker.resetKeyframe(frame, results);
+    return (int)results.size();
+}
+
+int Layer2Detection::detectTracked(const VideoFrame& frame, std::vector<FaceResult>& results) {
+    if (frame.getLayout() == PixelLayout::BGR) return detectTracked(frame.getNative(), results);
+    if (!trackingEnabled.load(std::memory_order_relaxed)) return detectAll(frame.bgr(), results);
+    if (frame.empty()) {
+        results.clear();
+        return 0;
+    }
+
+    // The tracker only needs grey: take the Y samples, no colour conversion
+    frame.gray(trackGray);
+    if (!tracker.needsKeyframe()) {
+        if (tracker.propagate(trackGray, results)) {
+            frameCount.fetch_add(1, std::memory_order_relaxed);
+            return (int)results.size();
+        }
+    }
+
+    detectAll(frame.bgr(), results);
+    tracker.resetKeyframe(trackGray, results);
+    return (int)results.size();
+}
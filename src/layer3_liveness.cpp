@@ -4,94 +4,122 @@
 // Email: trannguyenhien29085@gmail.com
 // =================================================================
 #include "layer3_liveness.h"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include "decision_params.h"
+#include "frame_arena.h"
+#include "model_bundle.h"
 
-Layer3Liveness::Layer3Liveness() : isInitialized(false), inputSize(80, 80) {}
+void LivenessTrackState::reset() {
+    history.clear();
+    previousScore = -1.0f;
+    lastRawScore = -1.0f;
+    consecutiveLowCount = 0;
+}
+
+Layer3Liveness::Layer3Liveness()
+    : isInitialized(false), modelBundle(nullptr), modelLimit(0), inputSize(80, 80) {}
 Layer3Liveness::~Layer3Liveness() {}
 
+void Layer3Liveness::bindScratch(FrameArena& arena) {
+    arena.bind(validCrop);
+    arena.bind(borderBuffer);
+    arena.bind(blob);
+    arena.bind(prob);
+    arena.bind(softmax);
+    arena.bind(cropPool);
+    // Headers sharing cropPool buffers
+    arena.bind(batchInputs);
+    arena.bind(singleInput);
+}
+
 bool Layer3Liveness::init(const std::string& modelPath) {
+    return init(std::vector<LivenessModelSpec>{ {modelPath, 1.8f, 1.0f} });
+}
+
+bool Layer3Liveness::init(const std::vector<LivenessModelSpec>& specs) {
+    isInitialized = false;
+    models.clear();
     try {
-        net = cv::dnn::readNetFromONNX(modelPath);
-        if (net.empty()) return false;
-        
-        net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
-        net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
-        
-        std::vector<std::string> outNames = net.getUnconnectedOutLayersNames();
-        if (!outNames.empty()) {
-            outputName = outNames[0];
-        }
+        for (const LivenessModelSpec& spec : specs) {
+            LivenessModel model;
+            model.backend = createInferenceBackend(backendOptions);
+            ModelBlob blob;
+            if (modelBundle && modelBundle->find(spec.path, backendOptions, blob) && model.backend->load(blob)) {
+                model.name = blob.name + " (bundle)";
+            } else {
+                std::string path = resolveModelPath(spec.path, backendOptions.preferInt8);
+                if (!model.backend->load(path)) return false;
+                model.name = path.substr(path.find_last_of("/\\") + 1);
+            }
 
-        isInitialized = true;
-        return true;
+            model.cropScale = spec.cropScale;
+            model.weight = std::max(0.0f, spec.weight);
+            model.batchSupported = true;
+            std::cout << "[Layer3] INFO: Loaded " << model.name << " on " << model.backend->name()
+                      << " (crop scale " << model.cropScale << ", weight " << model.weight << ")" << std::endl;
+            models.push_back(std::move(model));
+        }
     } catch (...) { return false; }
+
+    isInitialized = !models.empty();
+    return isInitialized;
 }
 
 void Layer3Liveness::resetHistory() { 
-    scoreHistory.clear();
-    previousScore = -1.0f;
-    consecutiveLowCount = 0;
+    defaultState.reset();
 }
 
-float Layer3Liveness::getSmoothedScore(float currentScore) {
-    if (currentScore < 0.25f) {
-        scoreHistory.clear();
-        scoreHistory.push_back(currentScore);
-        previousScore = currentScore;
-        consecutiveLowCount++;
+float Layer3Liveness::getSmoothedScore(LivenessTrackState& state, float currentScore, const DecisionParams& p) {
+    if (currentScore < p.smoothResetBelow) {
+        state.history.clear();
+        state.history.push(currentScore);
+        state.previousScore = currentScore;
+        state.consecutiveLowCount++;
         return currentScore;
     }
     
-    if (previousScore > 0.70f && currentScore < 0.45f) {
-        scoreHistory.clear();
-        previousScore = currentScore;
-        consecutiveLowCount = 0;
+    if (state.previousScore > p.smoothDropFrom && currentScore < p.smoothDropTo) {
+        state.history.clear();
+        state.previousScore = currentScore;
+        state.consecutiveLowCount = 0;
         return currentScore; 
     }
     
-    if (currentScore < 0.40f) {
-        consecutiveLowCount++;
-        if (consecutiveLowCount >= 3) {
-            scoreHistory.clear();
+    if (currentScore < p.smoothLowScore) {
+        state.consecutiveLowCount++;
+        if (state.consecutiveLowCount >= p.smoothLowFrames) {
+            state.history.clear();
         }
     } else {
-        consecutiveLowCount = 0;
+        state.consecutiveLowCount = 0;
     }
     
-    scoreHistory.push_back(currentScore);
-    if (scoreHistory.size() > maxHistorySize) scoreHistory.pop_front();
-    
-    float sum = 0, weightSum = 0;
-    for (size_t i = 0; i < scoreHistory.size(); ++i) {
-        float w = std::pow(1.8f, (float)i / scoreHistory.size()); 
-        sum += scoreHistory[i] * w;
-        weightSum += w;
+    state.history.push(currentScore);
+    float smoothed = smoother.smooth(state.history);
+    if (currentScore < smoothed - p.smoothLagMargin) {
+        smoothed = currentScore * p.smoothLagBlend + smoothed * (1.0f - p.smoothLagBlend);
     }
     
-    float smoothed = sum / weightSum;
-    if (currentScore < smoothed - 0.20f) {
-        smoothed = currentScore * 0.7f + smoothed * 0.3f;
-    }
-    
-    previousScore = currentScore;
+    state.previousScore = currentScore;
     return smoothed;
 }
 
-bool Layer3Liveness::checkLiveness(const cv::Mat& frame, const cv::Rect& faceBox, LivenessResult& output) {
-    if (!isInitialized || frame.empty()) return false;
+bool Layer3Liveness::prepareInput(const VideoFrame& frame, const cv::Rect& faceBox, float cropScale, cv::Mat& dst) {
     int cx = faceBox.x + faceBox.width / 2;
     int cy = faceBox.y + faceBox.height / 2;
     int maxSide = std::max(faceBox.width, faceBox.height);
-    int side = (int)(maxSide * 1.8f);
+    int side = (int)(maxSide * cropScale);
     int desiredX = cx - side / 2;
     int desiredY = cy - side / 2;
 
     cv::Rect desiredRect(desiredX, desiredY, side, side);
-    cv::Rect frameRect(0, 0, frame.cols, frame.rows);
+    cv::Rect frameRect(0, 0, frame.size().width, frame.size().height);
     cv::Rect validRect = desiredRect & frameRect;
     if (validRect.area() == 0) return false;
 
-    validCrop = frame(validRect); 
+    frame.bgrRegion(validRect, validCrop); 
 
     int top = validRect.y - desiredRect.y;
     int bottom = desiredRect.br().y - validRect.br().y;
@@ -102,37 +130,200 @@ bool Layer3Liveness::checkLiveness(const cv::Mat& frame, const cv::Rect& faceBox
     left = std::max(0, left); right = std::max(0, right);
 
     cv::copyMakeBorder(validCrop, borderBuffer, top, bottom, left, right, cv::BORDER_REPLICATE);
-    cv::resize(borderBuffer, finalInput, inputSize);
-    cv::dnn::blobFromImage(finalInput, blob, 1.0, inputSize, cv::Scalar(0, 0, 0), true, false);
-    net.setInput(blob);
-    
-    if (!outputName.empty()) {
-        net.forward(prob, outputName);
-    } else {
-        prob = net.forward();
+    cv::resize(borderBuffer, dst, inputSize);
+    return true;
+}
+
+void Layer3Liveness::warmUp(int maxBatch) {
+    if (!isInitialized) return;
+    auto t0 = std::chrono::steady_clock::now();
+    MetricsPause notAFrame;
+    cv::Mat blank(inputSize, CV_8UC3, cv::Scalar::all(0));
+    auto run = [&](int batch) {
+        batchInputs.assign(batch, blank);
+        modelScores.resize(batch);
+        for (LivenessModel& model : models) {
+            try {
+                runModel(model, modelScores.data());
+            } catch (const cv::Exception&) {
+                std::cerr << "[Layer3] WARN: Warm-up of " << model.name << " failed" << std::endl;
+            }
+        }
+    };
+    run(1);
+    if (maxBatch > 1) run(maxBatch);
+    batchInputs.clear();
+    std::cout << "[Layer3] INFO: Warm-up done in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count()
+              << " ms" << std::endl;
+}
+
+bool Layer3Liveness::forwardBatch(LivenessModel& model, const std::vector<cv::Mat>& inputs) {
+    const int count = (int)inputs.size();
+    cv::dnn::blobFromImages(inputs, blob, 1.0, inputSize, cv::Scalar(0, 0, 0), true, false);
+    {
+        FACE_SCOPED_TIMER(MetricStage::LIVENESS_FORWARD);
+        if (!model.backend->forward(blob, prob)) return false;
     }
-    
+    prob = prob.reshape(1, count);
+
     cv::exp(prob, softmax); 
-    float sumProb = (float)cv::sum(softmax)[0];
-    float realScore = softmax.at<float>(0, 1) / sumProb;
-    lastRawScore = realScore;
-    output.score = getSmoothedScore(realScore);
+    return softmax.rows == count;
+}
+
+// Real-class probability for every image in batchInputs, one forward pass
+// when the model accepts a batch, one pass per face otherwise
+void Layer3Liveness::runModel(LivenessModel& model, float* realScores) {
+    const int count = (int)batchInputs.size();
+
+    if (model.batchSupported || count == 1) {
+        bool ok = false;
+        try {
+            ok = forwardBatch(model, batchInputs);
+        } catch (const cv::Exception&) {
+            if (count == 1) throw;
+        }
+        if (ok) {
+            for (int k = 0; k < count; ++k) {
+                float sumProb = (float)cv::sum(softmax.row(k))[0];
+                realScores[k] = softmax.at<float>(k, 1) / sumProb;
+            }
+            return;
+        }
+        if (count == 1) {
+            realScores[0] = -1.0f;
+            return;
+        }
+        model.batchSupported = false;
+        std::cerr << "[Layer3] WARN: " << model.name
+                  << " does not accept batch > 1, running faces one by one" << std::endl;
+    }
+
+    for (int k = 0; k < count; ++k) {
+        singleInput.assign(1, batchInputs[k]);
+        realScores[k] = -1.0f;
+        if (!forwardBatch(model, singleInput)) continue;
+        float sumProb = (float)cv::sum(softmax)[0];
+        realScores[k] = softmax.at<float>(0, 1) / sumProb;
+    }
+}
+
+void Layer3Liveness::finishResult(LivenessTrackState& state, float realScore, LivenessResult& output,
+                                  const DecisionParams& p) {
+    state.lastRawScore = realScore;
+    output.rawScore = realScore;
+    output.score = getSmoothedScore(state, realScore, p);
     
-    if (output.score > 0.85f) {
+    if (output.score > p.livenessRealStrong) {
         output.status = LivenessStatus::REAL;
-    } else if (output.score < 0.30f) {
+    } else if (output.score < p.livenessSpoofStrong) {
         output.status = LivenessStatus::SPOOF;
-    } else if (output.score > 0.72f) {
+    } else if (output.score > p.livenessReal) {
         output.status = LivenessStatus::REAL;
-    } else if (output.score < 0.45f) {
+    } else if (output.score < p.livenessSpoof) {
         output.status = LivenessStatus::SPOOF;
     } else {
         output.status = LivenessStatus::UNCERTAIN;
     }
+}
 
+bool Layer3Liveness::checkLiveness(const cv::Mat& frame, const cv::Rect& faceBox, LivenessResult& output) {
+    singleBox.assign(1, faceBox);
+    singleState.assign(1, &defaultState);
+    if (!checkLivenessBatch(frame, singleBox, singleState, singleOutput)) return false;
+    if (singleOutput[0].score < 0.0f) return false;
+    output = singleOutput[0];
     return true;
 }
 
+bool Layer3Liveness::checkLivenessBatch(const cv::Mat& frame, const std::vector<cv::Rect>& faceBoxes,
+                                        const std::vector<LivenessTrackState*>& states,
+                                        std::vector<LivenessResult>& outputs, const DecisionParams& params) {
+    matFrame.setBGR(frame);
+    bool ok = checkLivenessBatch(matFrame, faceBoxes, states, outputs, params);
+    matFrame.release();   // do not pin the caller's (pooled) frame
+    return ok;
+}
+
+bool Layer3Liveness::checkLivenessBatch(const VideoFrame& frame, const std::vector<cv::Rect>& faceBoxes,
+                                        const std::vector<LivenessTrackState*>& states,
+                                        std::vector<LivenessResult>& outputs, const DecisionParams& params) {
+    singleFrame.assign(1, &frame);
+    singleFrameOf.assign(faceBoxes.size(), 0);
+    return checkLivenessBatch(singleFrame, singleFrameOf, faceBoxes, states, outputs, params);
+}
+
+bool Layer3Liveness::checkLivenessBatch(const std::vector<const VideoFrame*>& frames, const std::vector<int>& frameOf,
+                                        const std::vector<cv::Rect>& faceBoxes,
+                                        const std::vector<LivenessTrackState*>& states,
+                                        std::vector<LivenessResult>& outputs, const DecisionParams& params) {
+    outputs.resize(faceBoxes.size());
+    for (LivenessResult& out : outputs) {
+        out.score = -1.0f;
+        out.rawScore = -1.0f;
+        out.status = LivenessStatus::UNCERTAIN;
+    }
+    if (!isInitialized || frames.empty() || faceBoxes.empty()) return false;
+    if (cropPool.size() < faceBoxes.size()) cropPool.resize(faceBoxes.size());
+
+    // Faces whose crop falls outside the frame are skipped (score -1)
+    batchIndex.clear();
+    fusedScores.assign(faceBoxes.size(), 0.0f);
+    fusedWeights.assign(faceBoxes.size(), 0.0f);
+    float lastScale = -1.0f;
+
+    const size_t modelCount = modelLimit > 0 ? std::min(models.size(), (size_t)modelLimit) : models.size();
+    for (size_t m = 0; m < modelCount; ++m) {
+        LivenessModel& model = models[m];
+        if (model.weight <= 0.0f) continue;
+
+        // Models sharing a crop scale share the crops
+        if (model.cropScale != lastScale) {
+            batchInputs.clear();
+            cropMissing.assign(batchIndex.size(), 0);
+            if (lastScale < 0.0f) {
+                for (size_t i = 0; i < faceBoxes.size(); ++i) {
+                    const VideoFrame& frame = *frames[frameOf[i]];
+                    if (frame.empty() || !prepareInput(frame, faceBoxes[i], model.cropScale, cropPool[i])) continue;
+                    batchIndex.push_back((int)i);
+                    batchInputs.push_back(cropPool[i]);
+                }
+                if (batchInputs.empty()) return false;
+                cropMissing.assign(batchIndex.size(), 0);
+            } else {
+                // Keep batch rows aligned with batchIndex (blank row, not scored)
+                for (size_t k = 0; k < batchIndex.size(); ++k) {
+                    const int i = batchIndex[k];
+                    if (!prepareInput(*frames[frameOf[i]], faceBoxes[i], model.cropScale, cropPool[i])) {
+                        cropPool[i].setTo(cv::Scalar::all(0));
+                        cropMissing[k] = 1;
+                    }
+                    batchInputs.push_back(cropPool[i]);
+                }
+            }
+            lastScale = model.cropScale;
+        }
+
+        modelScores.resize(batchInputs.size());
+        runModel(model, modelScores.data());
+        // A failed forward (score -1) leaves the face's weight sum alone,
+        // the other models decide instead of dragging it towards spoof
+        for (size_t k = 0; k < batchIndex.size(); ++k) {
+            if (modelScores[k] < 0.0f || cropMissing[k]) continue;
+            fusedScores[batchIndex[k]] += model.weight * modelScores[k];
+            fusedWeights[batchIndex[k]] += model.weight;
+        }
+    }
+
+    bool scored = false;
+    for (int i : batchIndex) {
+        if (fusedWeights[i] <= 0.0f) continue;   // every model failed on this face: score stays -1
+        finishResult(*states[i], fusedScores[i] / fusedWeights[i], outputs[i], params);
+        scored = true;
+    }
+    return scored;
+}
+
 float Layer3Liveness::getLastRawScore() const {
-    return lastRawScore;
-}
\ No newline at end of file
+    return defaultState.lastRawScore;
+}
@@ -6,40 +6,60 @@
 #include "layer4_hybrid.h"
 #include <numeric>
 #include <cmath>
+#include "frame_arena.h"
 
-Layer4Hybrid::Layer4Hybrid() {}
+Layer4Hybrid::Layer4Hybrid() : params(&DecisionParams::current()), cueMask(~0u), cueLayout(PixelLayout::BGR) {}
 Layer4Hybrid::~Layer4Hybrid() {}
 
+void Layer4Hybrid::bindScratch(FrameArena& arena) {
+    // Input headers point into roiCache, released with it
+    for (cv::Mat* mat : { &colorInput, &grayInput, &edgeInput, &moireInput,
+                          &grayBuffer, &gradX, &gradY, &magnitude,
+                          &moireResized, &moireGray, &moireLaplacian, &colorRowScratch,
+                          &edgeBuffer, &edgeGray, &edgeMap }) {
+        arena.bind(*mat);
+    }
+    spectral.bindScratch(arena);
+    roiCache.bindScratch(arena);
+}
+
 float Layer4Hybrid::analyzeTextureGradient(const cv::Mat& src) {
     if (src.empty()) return 0.0f;
-    if (src.channels() == 3) cv::cvtColor(src, grayBuffer, cv::COLOR_BGR2GRAY);
-    else src.copyTo(grayBuffer);
+    cv::Mat gray = src;
+    if (src.channels() == 3) {
+        cv::cvtColor(src, grayBuffer, cv::COLOR_BGR2GRAY);
+        gray = grayBuffer;
+    }
     
-    cv::Sobel(grayBuffer, gradX, CV_32F, 1, 0, 3);
-    cv::Sobel(grayBuffer, gradY, CV_32F, 0, 1, 3);
+    {
+        AllocationCounter::Exclude opencvScratch;
+        cv::Sobel(gray, gradX, CV_32F, 1, 0, 3);
+        cv::Sobel(gray, gradY, CV_32F, 0, 1, 3);
+    }
     cv::magnitude(gradX, gradY, magnitude);
     cv::Scalar meanGrad = cv::mean(magnitude);
     cv::Scalar stdGrad;
     cv::meanStdDev(magnitude, cv::Scalar(), stdGrad); 
     
+    const DecisionParams& p = *params;
     float ratio = stdGrad.val[0] / (meanGrad.val[0] + 1e-6);
     float gradientScore = 0.0f;
 
-    if (ratio > 0.7f && ratio < 1.8f) {
+    if (ratio > p.textureRatioGoodLo && ratio < p.textureRatioGoodHi) {
         gradientScore += 0.20f; 
-    } else if (ratio < 0.4f) { 
+    } else if (ratio < p.textureRatioFlat) { 
         gradientScore -= 0.35f;
-    } else if (ratio > 2.2f) {
+    } else if (ratio > p.textureRatioNoisy) {
         gradientScore -= 0.25f; 
     } else {
         gradientScore -= 0.10f;
     }
     
-    if (meanGrad.val[0] < 3.5f) {
+    if (meanGrad.val[0] < p.textureGradLow) {
         gradientScore -= 0.25f;
-    } else if (meanGrad.val[0] > 25.0f) {
+    } else if (meanGrad.val[0] > p.textureGradHigh) {
         gradientScore += 0.15f;
-    } else if (meanGrad.val[0] > 8.0f) {
+    } else if (meanGrad.val[0] > p.textureGradMid) {
         gradientScore += 0.05f;
     }
     
@@ -48,119 +68,50 @@ float Layer4Hybrid::analyzeTextureGradient(const cv::Mat& src) {
 
 float Layer4Hybrid::detectMoirePattern(const cv::Mat& src) {
     if (src.empty()) return 0.0f;
-    cv::resize(src, moireResized, cv::Size(128, 128));
-    if (moireResized.channels() == 3) cv::cvtColor(moireResized, moireGray, cv::COLOR_BGR2GRAY);
-    else moireGray = moireResized;
+    // FaceRoiCache already hands in grey 128x128, only local headers point at it
+    cv::Mat sized = src;
+    if (sized.size() != cv::Size(128, 128)) {
+        AllocationCounter::Exclude opencvScratch;
+        cv::resize(src, moireResized, cv::Size(128, 128));
+        sized = moireResized;
+    }
+    cv::Mat gray = sized;
+    if (sized.channels() == 3) {
+        cv::cvtColor(sized, moireGray, cv::COLOR_BGR2GRAY);
+        gray = moireGray;
+    }
     
-    cv::Laplacian(moireGray, moireLaplacian, CV_32F, 3);
+    {
+        AllocationCounter::Exclude opencvScratch;
+        cv::Laplacian(gray, moireLaplacian, CV_32F, 3);
+    }
     cv::convertScaleAbs(moireLaplacian, moireLaplacian);
     cv::Scalar mean, stddev;
     cv::meanStdDev(moireLaplacian, mean, stddev);
     float variance = stddev.val[0] * stddev.val[0];
     
-    if (variance > 1200) return -0.45f;
-    if (variance > 850) return -0.30f; 
-    if (variance < 100) return -0.15f; 
-    if (variance >= 150 && variance <= 500) return 0.15f; 
+    const DecisionParams& p = *params;
+    if (variance > p.moireVarianceHigh) return -0.45f;
+    if (variance > p.moireVarianceMid) return -0.30f; 
+    if (variance < p.moireVarianceLow) return -0.15f; 
+    if (variance >= p.moireVarianceGoodLo && variance <= p.moireVarianceGoodHi) return 0.15f; 
     return 0.0f;
 }
 
 double Layer4Hybrid::calculateHighFrequency(const cv::Mat& src) {
-    if (src.empty()) return 0.0;
-
-    cv::resize(src, resizedBuffer, cv::Size(128, 128));
-
-    if (resizedBuffer.channels() == 3)
-        cv::cvtColor(resizedBuffer, grayBuffer, cv::COLOR_BGR2GRAY);
-    else
-        resizedBuffer.copyTo(grayBuffer);
-
-    int m = cv::getOptimalDFTSize(grayBuffer.rows);
-    int n = cv::getOptimalDFTSize(grayBuffer.cols);
-    
-    cv::copyMakeBorder(grayBuffer, padded, 0, m - grayBuffer.rows, 0, n - grayBuffer.cols, 
-                       cv::BORDER_CONSTANT, cv::Scalar::all(0));
-
-    if (plane0.size() != padded.size()) {
-        plane0 = cv::Mat::zeros(padded.size(), CV_32F);
-        plane1 = cv::Mat::zeros(padded.size(), CV_32F);
-    }
-    
-    padded.convertTo(plane0, CV_32F);
-    plane1.setTo(0);
-
-    std::vector<cv::Mat> planes = {plane0, plane1};
-    cv::merge(planes, complexI);
-    
-    cv::dft(complexI, complexI);
-    
-    cv::split(complexI, planes);
-    cv::magnitude(planes[0], planes[1], planes[0]);
-    magI = planes[0];
-
-    magI += cv::Scalar::all(1);
-    cv::log(magI, magI);
-
-    magI = magI(cv::Rect(0, 0, magI.cols & -2, magI.rows & -2));
-    int cx = magI.cols / 2;
-    int cy = magI.rows / 2;
-    
-    cv::Mat q0(magI, cv::Rect(0, 0, cx, cy));
-    cv::Mat q1(magI, cv::Rect(cx, 0, cx, cy));
-    cv::Mat q2(magI, cv::Rect(0, cy, cx, cy));
-    cv::Mat q3(magI, cv::Rect(cx, cy, cx, cy));
-    cv::Mat tmp;
-    q0.copyTo(tmp); q3.copyTo(q0); tmp.copyTo(q3);
-    q1.copyTo(tmp); q2.copyTo(q1); tmp.copyTo(q2);
-
-    int maskSize = std::min(magI.cols, magI.rows) / 6; 
-    cv::Rect centerRect(cx - maskSize, cy - maskSize, maskSize * 2, maskSize * 2);
-    
-    if (mask.size() != magI.size()) {
-        mask = cv::Mat::ones(magI.size(), CV_8U);
-        cv::rectangle(mask, centerRect, cv::Scalar(0), -1);
-    } 
-    
-    cv::Scalar highFreqMean = cv::mean(magI, mask);
-    return highFreqMean.val[0];
+    if (!spectral.compute(src, spectralFeatures)) return 0.0;
+    return spectralFeatures.highFreqMean;
 }
 
-bool Layer4Hybrid::checkSkinConsistency(const cv::Mat& src, float& outScore) {
-    if (src.empty()) return false;
-    cv::resize(src, skinSmall, cv::Size(64, 64));
-    cv::cvtColor(skinSmall, skinYCrCb, cv::COLOR_BGR2YCrCb);
-    
-    double sumY = 0, sumCr = 0, sumCb = 0;
-    double minY = 255, maxY = 0;
-    int totalPixels = skinSmall.rows * skinSmall.cols;
-
-    if (skinYCrCb.isContinuous()) {
-        const uchar* ptr = skinYCrCb.ptr<uchar>(0);
-        for (int i = 0; i < totalPixels; ++i) {
-            uchar y = ptr[3*i];
-            uchar cr = ptr[3*i + 1];
-            uchar cb = ptr[3*i + 2];
-            sumY += y;
-            sumCr += cr;
-            sumCb += cb;
-            if (y < minY) minY = y;
-            if (y > maxY) maxY = y;
-        }
-    } else {
-        cv::Scalar m = cv::mean(skinYCrCb);
-        sumY = m[0] * totalPixels;
-        sumCr = m[1] * totalPixels;
-        sumCb = m[2] * totalPixels;
-        double min, max;
-        cv::minMaxLoc(skinSmall, &min, &max);
-        minY = min; maxY = max;
-    }
+bool Layer4Hybrid::checkSkinConsistency(const ColorStats& stats, float& outScore) {
+    if (stats.samples <= 0) return false;
 
-    float meanCrVal = (float)(sumCr / totalPixels);
-    float meanCbVal = (float)(sumCb / totalPixels);
+    float meanCrVal = stats.meanCr;
+    float meanCbVal = stats.meanCb;
     float score = 0.0f;
-    bool validCr = (meanCrVal >= 125 && meanCrVal <= 180);
-    bool validCb = (meanCbVal >= 70 && meanCbVal <= 135);  
+    const DecisionParams& p = *params;
+    bool validCr = (meanCrVal >= p.skinCrMin && meanCrVal <= p.skinCrMax);
+    bool validCb = (meanCbVal >= p.skinCbMin && meanCbVal <= p.skinCbMax);  
     
     if (validCr && validCb) {
         score += 0.25f;
@@ -170,24 +121,19 @@ bool Layer4Hybrid::checkSkinConsistency(const cv::Mat& src, float& outScore) {
         score -= 0.15f; 
     }
 
-    double contrast = maxY - minY;
-    if (contrast < 25) {
+    double contrast = stats.maxY - stats.minY;
+    if (contrast < p.skinContrastLow) {
         score -= 0.30f; 
-    } else if (contrast > 140) {
+    } else if (contrast > p.skinContrastHigh) {
         score -= 0.15f;
-    } else if (contrast >= 40 && contrast <= 120) {
+    } else if (contrast >= p.skinContrastGoodLo && contrast <= p.skinContrastGoodHi) {
         score += 0.15f; 
     }
     
-    cv::cvtColor(skinSmall, skinHSV, cv::COLOR_BGR2HSV);
-    int from_to[] = {1, 0};
-    if (plane0.size() != skinHSV.size()) plane0 = cv::Mat(skinHSV.size(), CV_8U);
-    cv::mixChannels(&skinHSV, 1, &plane0, 1, from_to, 1);
-    cv::Scalar satMean = cv::mean(plane0);
-    
-    if (satMean.val[0] >= 15 && satMean.val[0] <= 90) {
+    float satMean = stats.meanSat;
+    if (satMean >= p.skinSatGoodLo && satMean <= p.skinSatGoodHi) {
         score += 0.15f; 
-    } else if (satMean.val[0] < 8 || satMean.val[0] > 110) {
+    } else if (satMean < p.skinSatLow || satMean > p.skinSatHigh) {
         score -= 0.25f; 
     } else {
         score -= 0.08f; 
@@ -197,25 +143,24 @@ bool Layer4Hybrid::checkSkinConsistency(const cv::Mat& src, float& outScore) {
     return true;
 }
 
-float Layer4Hybrid::analyzeColorTemperature(const cv::Mat& src) {
-    if (src.empty()) return 0.0f;
-    cv::resize(src, tempSmall, cv::Size(32, 32));
-    cv::Scalar meanColor = cv::mean(tempSmall);
-    float b = meanColor.val[0];
-    float g = meanColor.val[1];
-    float r = meanColor.val[2];
+float Layer4Hybrid::analyzeColorTemperature(const ColorStats& stats) {
+    if (stats.samples <= 0) return 0.0f;
+    float b = stats.meanB;
+    float g = stats.meanG;
+    float r = stats.meanR;
     float tempScore = 0.0f;
+    const DecisionParams& p = *params;
     
     if (r > g && g > b) {
         float rg_ratio = r / (g + 1e-6);
         float gb_ratio = g / (b + 1e-6);
         
-        if (rg_ratio >= 1.05 && rg_ratio <= 1.45 && 
-            gb_ratio >= 1.10 && gb_ratio <= 1.65) {
+        if (rg_ratio >= p.tempRgGoodLo && rg_ratio <= p.tempRgGoodHi && 
+            gb_ratio >= p.tempGbGoodLo && gb_ratio <= p.tempGbGoodHi) {
             tempScore += 0.15f;
         } 
-        else if (rg_ratio >= 0.98 && rg_ratio <= 1.55 && 
-                 gb_ratio >= 1.00 && gb_ratio <= 1.80) {
+        else if (rg_ratio >= p.tempRgLo && rg_ratio <= p.tempRgHi && 
+                 gb_ratio >= p.tempGbLo && gb_ratio <= p.tempGbHi) {
             tempScore += 0.05f;
         }
         else {
@@ -230,9 +175,9 @@ float Layer4Hybrid::analyzeColorTemperature(const cv::Mat& src) {
     }
     
     float avgBrightness = (r + g + b) / 3.0f;
-    if (avgBrightness < 20 || avgBrightness > 235) {
+    if (avgBrightness < p.tempBrightLow || avgBrightness > p.tempBrightHigh) {
         tempScore -= 0.15f;
-    } else if (avgBrightness >= 40 && avgBrightness <= 200) {
+    } else if (avgBrightness >= p.tempBrightGoodLo && avgBrightness <= p.tempBrightGoodHi) {
         tempScore += 0.05f; 
     }
     
@@ -241,12 +186,22 @@ float Layer4Hybrid::analyzeColorTemperature(const cv::Mat& src) {
 
 float Layer4Hybrid::detectScreenEdges(const cv::Mat& src) {
     if (src.empty() || src.cols < 60 || src.rows < 60) return 0.0f;
-    cv::resize(src, edgeBuffer, cv::Size(120, 120)); 
-    if (edgeBuffer.channels() == 3) 
-        cv::cvtColor(edgeBuffer, grayBuffer, cv::COLOR_BGR2GRAY);
-    else 
-        edgeBuffer.copyTo(grayBuffer);
-    cv::Canny(grayBuffer, edgeMap, 50, 150);
+    cv::Mat sized = src;
+    if (sized.size() != cv::Size(120, 120)) {
+        AllocationCounter::Exclude opencvScratch;
+        cv::resize(src, edgeBuffer, cv::Size(120, 120)); 
+        sized = edgeBuffer;
+    }
+    cv::Mat gray = sized;
+    if (sized.channels() == 3) {
+        cv::cvtColor(sized, edgeGray, cv::COLOR_BGR2GRAY);
+        gray = edgeGray;
+    }
+    const DecisionParams& p = *params;
+    {
+        AllocationCounter::Exclude opencvScratch;
+        cv::Canny(gray, edgeMap, p.edgeCannyLow, p.edgeCannyHigh);
+    }
     
     int borderSize = 5;
     cv::Rect topBorder(0, 0, edgeMap.cols, borderSize);
@@ -262,58 +217,178 @@ float Layer4Hybrid::detectScreenEdges(const cv::Mat& src) {
     int maxExpected = borderSize * edgeMap.cols * 2 + borderSize * edgeMap.rows * 2;
     float edgeRatio = (float)totalBorderEdges / maxExpected;
     
-    if (edgeRatio > 0.20f) {
+    if (edgeRatio > p.edgeRatioHigh) {
         return -0.25f;
-    } else if (edgeRatio > 0.15f) {
+    } else if (edgeRatio > p.edgeRatioMid) {
         return -0.12f; 
     }
     
     return 0.0f;
 }
 
-float Layer4Hybrid::analyzeQuality(const cv::Mat& frame, const cv::Rect& faceBox) {
+float Layer4Hybrid::analyzeQuality(const cv::Mat& frame, const cv::Rect& faceBox, const DecisionParams& p) {
     cv::Rect safeBox = faceBox & cv::Rect(0, 0, frame.cols, frame.rows);
     if (safeBox.area() <= 100) return -0.5f;  
-    cv::Mat faceRoi = frame(safeBox);
-    
-    // 1. Skin consistency
-    float skinScore = 0.0f;
-    checkSkinConsistency(faceRoi, skinScore);   
-    // 2. Texture gradient
-    float textureScore = analyzeTextureGradient(faceRoi);
-    // 3. Color temperature
-    float tempScore = analyzeColorTemperature(faceRoi);
-    // 4. Screen edge detection
-    float edgeScore = detectScreenEdges(faceRoi);
-    // 5. Moire + High frequency
+    roiCache.reset(frame, safeBox);
+    return analyzeQuality(roiCache, p);
+}
+
+float Layer4Hybrid::analyzeQuality(const VideoFrame& frame, const cv::Rect& faceBox, const DecisionParams& p) {
+    if (!prepareCues(frame, faceBox, p)) return -0.5f;
+    for (int cue = 0; cue < CUE_COUNT; ++cue) runCue(cue);
+    return fuseCues();
+}
+
+float Layer4Hybrid::analyzeQuality(FaceRoiCache& roi, const DecisionParams& p) {
+    if (!prepareCues(roi, p)) return -0.5f;
+    for (int cue = 0; cue < CUE_COUNT; ++cue) runCue(cue);
+    return fuseCues();
+}
+
+bool Layer4Hybrid::prepareCues(const VideoFrame& frame, const cv::Rect& faceBox, const DecisionParams& p) {
+    cv::Rect safeBox = faceBox & cv::Rect(0, 0, frame.size().width, frame.size().height);
+    cues = QualityCues();
+    params = &p;
+    if (safeBox.area() <= 100) return false;
+    roiCache.reset(frame, safeBox);
+    return prepareCues(roiCache, p);
+}
+
+bool Layer4Hybrid::prepareCues(FaceRoiCache& roi, const DecisionParams& p) {
+    cues = QualityCues();
+    params = &p;
+    const cv::Rect& safeBox = roi.box();
+    if (safeBox.area() <= 100) return false;
+
+    cueLayout = roi.getLayout();
+    colorInput = cueLayout == PixelLayout::YUYV ? roi.native() : roi.bgr();
+    // Texture gradient: full-resolution grey, converted once
+    grayInput = roi.gray();
+    edgeInput = cv::Mat();
+    if (safeBox.width >= 60 && safeBox.height >= 60) edgeInput = roi.gray(cv::Size(120, 120));
+
+    // Moire + High frequency: one grey 128x128 centre patch for both
     int centerSize = std::min(safeBox.width, safeBox.height) / 2;
-    int cx = safeBox.x + safeBox.width / 2;
-    int cy = safeBox.y + safeBox.height / 2;
-    cv::Rect moireRect(cx - centerSize/2, cy - centerSize/2, centerSize, centerSize);
-    moireRect = moireRect & cv::Rect(0, 0, frame.cols, frame.rows);
-    
-    float moireScore = 0.0f;
-    if (moireRect.width >= 32 && moireRect.height >= 32) {
-        cv::Mat moireRoi = frame(moireRect);
-        double freqHigh = calculateHighFrequency(moireRoi);
-        moireScore = detectMoirePattern(moireRoi);
-        
-        if (freqHigh > 17.0) {
-            moireScore -= 0.40f; 
-        } else if (freqHigh > 14.5) {
-            moireScore -= 0.20f;
-        } else if (freqHigh < 5.0) {
-            moireScore -= 0.20f;
-        } else if (freqHigh >= 7.0 && freqHigh <= 13.0) {
-            moireScore += 0.20f; 
+    cv::Rect moireRect(safeBox.width / 2 - centerSize/2, safeBox.height / 2 - centerSize/2, centerSize, centerSize);
+    moireRect = moireRect & cv::Rect(0, 0, safeBox.width, safeBox.height);
+    moireInput = cv::Mat();
+    const unsigned spectral = cueBit(CUE_MOIRE) | cueBit(CUE_HIGH_FREQ);
+    if (moireRect.width >= 32 && moireRect.height >= 32 && (cueMask & spectral) == spectral) {
+        moireInput = roi.gray(moireRect, cv::Size(128, 128));
+        cues.hasMoire = true;
+    }
+    cues.valid = true;
+    return true;
+}
+
+void Layer4Hybrid::runCue(int cue) {
+    if (!cues.valid || cue < 0 || cue >= CUE_COUNT || !(cueMask & cueBit(cue))) return;
+#ifdef FACE_WITH_METRICS
+    static const MetricStage cueStages[CUE_COUNT] = {
+        MetricStage::CUE_COLOR, MetricStage::CUE_TEXTURE, MetricStage::CUE_EDGES,
+        MetricStage::CUE_MOIRE, MetricStage::CUE_HIGH_FREQ
+    };
+    FACE_SCOPED_TIMER(cueStages[cue]);
+#endif
+    switch (cue) {
+        case CUE_COLOR: {
+            // Skin + color temperature share one pass over the ROI
+            bool statsOk = cueLayout == PixelLayout::YUYV
+                         ? computeColorStatsYUYV(colorInput, colorStats, colorRowScratch)
+                         : computeColorStats(colorInput, colorStats);
+            if (!statsOk) colorStats = ColorStats();
+            float skinScore = 0.0f;
+            checkSkinConsistency(colorStats, skinScore);
+            cues.skin = skinScore;
+            cues.temperature = analyzeColorTemperature(colorStats);
+            break;
         }
+        case CUE_TEXTURE:
+            cues.texture = analyzeTextureGradient(grayInput);
+            break;
+        case CUE_EDGES:
+            if (!edgeInput.empty()) cues.edges = detectScreenEdges(edgeInput);
+            break;
+        case CUE_MOIRE:
+            if (cues.hasMoire) cues.moire = detectMoirePattern(moireInput);
+            break;
+        case CUE_HIGH_FREQ:
+            if (cues.hasMoire) cues.highFrequency = calculateHighFrequency(moireInput);
+            break;
+        default:
+            break;
     }
+}
+
+namespace {
+// Range of every cue's raw score (from the rules above)
+const float skinRange[2] = {-0.95f, 0.55f};
+const float temperatureRange[2] = {-0.35f, 0.20f};
+const float textureRange[2] = {-0.60f, 0.35f};
+const float edgeRange[2] = {-0.25f, 0.0f};
+const float moireRange[2] = {-0.45f, 0.15f};
+const float frequencyRange[2] = {-0.40f, 0.20f};
+
+float frequencyAdjustment(double freqHigh, const DecisionParams& p) {
+    if (freqHigh > p.freqHigh) return -0.40f;
+    if (freqHigh > p.freqMid) return -0.20f;
+    if (freqHigh < p.freqLow) return -0.20f;
+    if (freqHigh >= p.freqGoodLo && freqHigh <= p.freqGoodHi) return 0.20f;
+    return 0.0f;
+}
+
+float clampAdjustment(float total, const DecisionParams& p) {
+    return std::max(p.adjustmentMin, std::min(p.adjustmentMax, total));
+}
+}
+
+float Layer4Hybrid::fuseCues(const QualityCues& cues, const DecisionParams& p) {
+    if (!cues.valid) return -0.5f;
+
+    float moireScore = 0.0f;
+    if (cues.hasMoire) moireScore = cues.moire + frequencyAdjustment(cues.highFrequency, p);
     
-    float totalAdjustment = skinScore * 1.0f +      
-                           textureScore * 0.8f +   
-                           tempScore * 0.6f +      
-                           edgeScore * 0.7f +      
-                           moireScore * 0.9f;   
+    float totalAdjustment = cues.skin * p.weightSkin +      
+                           cues.texture * p.weightTexture +   
+                           cues.temperature * p.weightTemperature +      
+                           cues.edges * p.weightEdges +      
+                           moireScore * p.weightMoire;   
     
-    return std::max(-0.60f, std::min(0.50f, totalAdjustment)); 
-}
\ No newline at end of file
+    return clampAdjustment(totalAdjustment, p); 
+}
+
+void Layer4Hybrid::cueAdjustments(const QualityCues& cues, float out[CUE_COUNT], const DecisionParams& p) {
+    for (int cue = 0; cue < CUE_COUNT; ++cue) out[cue] = 0.0f;
+    if (!cues.valid) return;
+    out[CUE_COLOR] = cues.skin * p.weightSkin + cues.temperature * p.weightTemperature;
+    out[CUE_TEXTURE] = cues.texture * p.weightTexture;
+    out[CUE_EDGES] = cues.edges * p.weightEdges;
+    if (cues.hasMoire) {
+        out[CUE_MOIRE] = cues.moire * p.weightMoire;
+        out[CUE_HIGH_FREQ] = frequencyAdjustment(cues.highFrequency, p) * p.weightMoire;
+    }
+}
+
+void Layer4Hybrid::adjustmentBounds(const QualityCues& cues, unsigned knownMask, float& lo, float& hi,
+                                    const DecisionParams& p) {
+    if (!cues.valid) {
+        lo = hi = -0.5f;
+        return;
+    }
+    float sum[2] = {0.0f, 0.0f};
+    for (int b = 0; b < 2; ++b) {
+        bool color = knownMask & cueBit(CUE_COLOR);
+        sum[b] += (color ? cues.skin : skinRange[b]) * p.weightSkin;
+        sum[b] += (color ? cues.temperature : temperatureRange[b]) * p.weightTemperature;
+        sum[b] += ((knownMask & cueBit(CUE_TEXTURE)) ? cues.texture : textureRange[b]) * p.weightTexture;
+        sum[b] += ((knownMask & cueBit(CUE_EDGES)) ? cues.edges : edgeRange[b]) * p.weightEdges;
+        if (cues.hasMoire) {
+            float moire = (knownMask & cueBit(CUE_MOIRE)) ? cues.moire : moireRange[b];
+            moire += (knownMask & cueBit(CUE_HIGH_FREQ)) ? frequencyAdjustment(cues.highFrequency, p)
+                                                         : frequencyRange[b];
+            sum[b] += moire * p.weightMoire;
+        }
+    }
+    lo = clampAdjustment(sum[0], p);
+    hi = clampAdjustment(sum[1], p);
+}
@@ -4,63 +4,259 @@
 // Email: trannguyenhien29085@gmail.com
 // =================================================================
 #include "layer5_visualization.h"
+#include "anti_spoof_decision.h"
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
 
-Layer5Visualization::Layer5Visualization() 
-    : fontScale(1.0f), thickness(2), frameCount(0), startTime(std::chrono::steady_clock::now())
+namespace {
+const int fontFace = cv::FONT_HERSHEY_SIMPLEX;
+const int glyphPad = 2;    // ink may overhang the advance by a pixel or two
+
+const char* statusText(DisplayStatus status) {
+    switch (status) {
+        case DisplayStatus::TOO_FAR:        return "TOO FAR";
+        case DisplayStatus::VERIFYING:      return "VERIFYING";
+        case DisplayStatus::REAL_PERSON:    return "REAL";
+        case DisplayStatus::SPOOF_DETECTED: return "FAKE";
+        default:                            return "NO FACE";
+    }
+}
+}
+
+// ===== Glyph atlas =====
+void Layer5Visualization::GlyphAtlas::build(double scale, int thick) {
+    cv::Size sizes[95];
+    int baseline = 0;
+    int ascent = 0;
+    int total = 0;
+    for (int i = 0; i < 95; ++i) {
+        const char s[2] = {(char)(32 + i), 0};
+        int base = 0;
+        sizes[i] = cv::getTextSize(s, fontFace, scale, thick, &base);
+        sizes[i].width = std::max(1, sizes[i].width);
+        ascent = std::max(ascent, sizes[i].height);
+        baseline = std::max(baseline, base);
+    }
+    // The space glyph has no ink, its advance comes from a letter
+    sizes[0].width = sizes['n' - 32].width;
+    for (int i = 0; i < 95; ++i) total += sizes[i].width + 2 * glyphPad;
+
+    height = ascent + baseline + thick;
+    mask = cv::Mat::zeros(height, total, CV_8U);
+    int px = 0;
+    for (int i = 0; i < 95; ++i) {
+        const char s[2] = {(char)(32 + i), 0};
+        x[i] = px + glyphPad;
+        width[i] = sizes[i].width;
+        cv::putText(mask, s, cv::Point(x[i], ascent), fontFace, scale, cv::Scalar(255), thick, cv::LINE_8);
+        px += sizes[i].width + 2 * glyphPad;
+    }
+}
+
+// ===== Setup =====
+Layer5Visualization::Layer5Visualization()
+    : scaleX(1.0f), scaleY(1.0f), fontScale(1.0f), thickness(2),
+      frameCount(0), lastFPS(0.0f), startTime(std::chrono::steady_clock::now())
 {
+    // BGR, same meaning as the boxes of the pipeline
     colors.idle       = cv::Scalar(200, 200, 200);
-    colors.verifying  = cv::Scalar(255, 255, 0);
-    colors.real       = cv::Scalar(0, 255, 0);
-    colors.spoof      = cv::Scalar(255, 0, 0);
-    colors.warning    = cv::Scalar(255, 165, 0);
-    colors.info       = cv::Scalar(200, 200, 200);
+    colors.verifying  = cv::Scalar(0, 255, 255);   // VANG
+    colors.real       = cv::Scalar(0, 255, 0);     // XANH
+    colors.spoof      = cv::Scalar(0, 0, 255);     // DO
+    colors.warning    = cv::Scalar(0, 165, 255);
+    colors.info       = cv::Scalar(230, 230, 230);
+    textBuffer[0] = 0;
 }
 
 Layer5Visualization::~Layer5Visualization() {}
 
-void Layer5Visualization::init(const cv::Size& dispSize) {
+void Layer5Visualization::init(const cv::Size& capSize, const cv::Size& dispSize) {
+    captureSize = capSize;
+    scaleX = capSize.width > 0 ? (float)dispSize.width / capSize.width : 1.0f;
+    scaleY = capSize.height > 0 ? (float)dispSize.height / capSize.height : 1.0f;
+    if (dispSize == displaySize && !smallFont.mask.empty()) return;
+
     displaySize = dispSize;
-    fontScale = displaySize.width / 600.0f; 
+    fontScale = displaySize.width / 600.0f;
     thickness = std::max(1, (int)(fontScale * 2));
-    
-    std::cout << "[Layer5] INFO: Visualizer ready. Target Display: " 
+
+    smallFont.build(0.45 * fontScale, std::max(1, thickness / 2));
+    for (int s = 0; s < (int)DisplayStatus::COUNT; ++s) {
+        const DisplayStatus status = (DisplayStatus)s;
+        const cv::Scalar text = status == DisplayStatus::SPOOF_DETECTED ? cv::Scalar(255, 255, 255)
+                                                                        : cv::Scalar(0, 0, 0);
+        statusLabels[s] = buildLabel(statusText(status), statusColor(status), text);
+    }
+    warningLabel = buildLabel("Please show your face", colors.warning, cv::Scalar(0, 0, 0));
+
+    std::cout << "[Layer5] INFO: Visualizer ready. Target Display: "
               << displaySize.width << "x" << displaySize.height << std::endl;
 }
 
-void Layer5Visualization::render(cv::Mat& displayFrame, const VisualizationData& data, float scaleX, float scaleY) {
-    if (displayFrame.empty()) return;
-
-    if (data.faceDetected) {
-        cv::Rect scaledBox;
-        scaledBox.x = (int)(data.faceBox.x * scaleX);
-        scaledBox.y = (int)(data.faceBox.y * scaleY);
-        scaledBox.width = (int)(data.faceBox.width * scaleX);
-        scaledBox.height = (int)(data.faceBox.height * scaleY);
-
-        drawFaceBox(displayFrame, scaledBox, data.status);
-        drawStatusText(displayFrame, scaledBox, data.status);
-        
-        if (data.status != DisplayStatus::TOO_FAR) {
-            drawScoreInfo(displayFrame, scaledBox, data.aiScore, data.physicalScore, data.finalScore);
-            
-            if (data.status == DisplayStatus::VERIFYING || data.status == DisplayStatus::REAL_PERSON) {
-                drawProgressBar(displayFrame, scaledBox, data.consecutiveRealFrames, 10, data.status);
+cv::Mat Layer5Visualization::buildLabel(const char* text, const cv::Scalar& background,
+                                        const cv::Scalar& foreground) const {
+    const double scale = 0.6 * fontScale;
+    const int thick = std::max(1, thickness / 2);
+    const int margin = std::max(2, thickness * 2);
+    int baseline = 0;
+    cv::Size size = cv::getTextSize(text, fontFace, scale, thick, &baseline);
+
+    cv::Mat label(size.height + baseline + 2 * margin, size.width + 2 * margin, CV_8UC3, background);
+    cv::putText(label, text, cv::Point(margin, margin + size.height), fontFace, scale,
+                foreground, thick, cv::LINE_AA);
+    return label;
+}
+
+const cv::Scalar& Layer5Visualization::statusColor(DisplayStatus status) const {
+    switch (status) {
+        case DisplayStatus::REAL_PERSON:    return colors.real;
+        case DisplayStatus::SPOOF_DETECTED: return colors.spoof;
+        case DisplayStatus::VERIFYING:      return colors.verifying;
+        case DisplayStatus::TOO_FAR:        return colors.warning;
+        default:                            return colors.idle;
+    }
+}
+
+void Layer5Visualization::updateFPS(float& outFPS) {
+    frameCount++;
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - startTime).count();
+    if (elapsed >= 1.0) {
+        lastFPS = (float)(frameCount / elapsed);
+        frameCount = 0;
+        startTime = now;
+    }
+    outFPS = lastFPS;
+}
+
+// ===== Per frame: cached pixels only =====
+void Layer5Visualization::drawLabel(cv::Mat& frame, const cv::Mat& label, cv::Point topLeft) {
+    cv::Rect dst(topLeft, label.size());
+    cv::Rect clipped = dst & cv::Rect(0, 0, frame.cols, frame.rows);
+    if (clipped.empty()) return;
+    cv::Mat view = frame(clipped);
+    label(cv::Rect(clipped.tl() - dst.tl(), clipped.size())).copyTo(view);
+}
+
+void Layer5Visualization::drawText(cv::Mat& frame, const char* text, cv::Point topLeft, const cv::Scalar& color) {
+    const cv::Rect bounds(0, 0, frame.cols, frame.rows);
+    int px = topLeft.x;
+    for (const char* c = text; *c; ++c) {
+        int i = (unsigned char)*c - 32;
+        if (i < 0 || i >= 95) i = '?' - 32;
+        if (i > 0) {
+            cv::Rect dst(px - glyphPad, topLeft.y, smallFont.width[i] + 2 * glyphPad, smallFont.height);
+            cv::Rect clipped = dst & bounds;
+            if (!clipped.empty()) {
+                cv::Rect src(smallFont.x[i] - glyphPad + (clipped.x - dst.x), clipped.y - dst.y,
+                             clipped.width, clipped.height);
+                cv::Mat view = frame(clipped);
+                view.setTo(color, smallFont.mask(src));
             }
         }
+        px += smallFont.width[i];
+    }
+}
+
+void Layer5Visualization::drawFaceBox(cv::Mat& frame, const cv::Rect& box, DisplayStatus status) {
+    cv::rectangle(frame, box, statusColor(status), thickness, cv::LINE_8);
+}
+
+void Layer5Visualization::drawStatusText(cv::Mat& frame, const cv::Rect& box, DisplayStatus status, int trackId) {
+    const cv::Mat& label = statusLabels[(int)status];
+    cv::Point tl(box.x, box.y - label.rows);
+    if (tl.y < 0) tl.y = box.y;   // no room above, badge inside the box
+    drawLabel(frame, label, tl);
+
+    if (trackId >= 0) {
+        std::snprintf(textBuffer, sizeof(textBuffer), "#%d", trackId);
+        drawText(frame, textBuffer, cv::Point(tl.x + label.cols + 4, tl.y + (label.rows - smallFont.height) / 2),
+                 statusColor(status));
+    }
+}
+
+void Layer5Visualization::drawScoreInfo(cv::Mat& frame, const cv::Rect& box,
+                                        float aiScore, float physicalScore, float finalScore) {
+    if (aiScore < 0.0f) {
+        std::snprintf(textBuffer, sizeof(textBuffer), "AI --");
     } else {
-        drawWarningMessage(displayFrame, "Please show your face");
+        std::snprintf(textBuffer, sizeof(textBuffer), "AI %.2f  L4 %+.2f  F %.2f",
+                      aiScore, physicalScore, finalScore);
+    }
+    drawText(frame, textBuffer, cv::Point(box.x, box.y + box.height + 4), colors.info);
+}
+
+void Layer5Visualization::drawProgressBar(cv::Mat& frame, const cv::Rect& box,
+                                          int consecutive, int threshold, DisplayStatus status) {
+    const int barHeight = std::max(4, thickness * 2);
+    cv::Rect bar(box.x, box.y + box.height + 6 + smallFont.height, box.width, barHeight);
+    float progress = threshold > 0 ? std::min(1.0f, (float)consecutive / threshold) : 1.0f;
+    if (status == DisplayStatus::REAL_PERSON) progress = 1.0f;
+
+    cv::Rect fill(bar.x, bar.y, (int)(bar.width * progress), bar.height);
+    if (fill.width > 0) cv::rectangle(frame, fill, statusColor(status), cv::FILLED, cv::LINE_8);
+    cv::rectangle(frame, bar, colors.info, 1, cv::LINE_8);
+}
+
+void Layer5Visualization::drawFPSCounter(cv::Mat& frame, float fps) {
+    std::snprintf(textBuffer, sizeof(textBuffer), "FPS %.1f", fps);
+    drawText(frame, textBuffer, cv::Point(8, 8), colors.info);
+}
+
+void Layer5Visualization::drawWarningMessage(cv::Mat& frame) {
+    drawLabel(frame, warningLabel, cv::Point((frame.cols - warningLabel.cols) / 2,
+                                             frame.rows - warningLabel.rows - 10));
+}
+
+void Layer5Visualization::drawLandmarks(cv::Mat& frame, const std::vector<cv::Point2f>& landmarks) {
+    // Filled LINE_8 circles take OpenCV's fast path (no polygon buffers)
+    const int radius = std::max(1, thickness);
+    for (const cv::Point2f& p : landmarks) {
+        cv::circle(frame, cv::Point((int)(p.x * scaleX), (int)(p.y * scaleY)), radius,
+                   colors.warning, cv::FILLED, cv::LINE_8);
     }
-    
-    updateFPS(const_cast<float&>(data.fps)); 
-    drawFPSCounter(displayFrame, const_cast<float&>(data.fps));
 }
 
+void Layer5Visualization::drawDebugGrid(cv::Mat& frame) {
+    for (int i = 1; i < 3; ++i) {
+        int x = frame.cols * i / 3;
+        int y = frame.rows * i / 3;
+        cv::line(frame, cv::Point(x, 0), cv::Point(x, frame.rows - 1), colors.idle, 1, cv::LINE_8);
+        cv::line(frame, cv::Point(0, y), cv::Point(frame.cols - 1, y), colors.idle, 1, cv::LINE_8);
+    }
+}
+
+void Layer5Visualization::render(cv::Mat& displayFrame, const VisualizationData& data) {
+    if (displayFrame.empty() || smallFont.mask.empty()) return;
+    if (!data.faceDetected) {
+        drawWarningMessage(displayFrame);
+        return;
+    }
+
+    cv::Rect scaledBox;
+    scaledBox.x = (int)(data.faceBox.x * scaleX);
+    scaledBox.y = (int)(data.faceBox.y * scaleY);
+    scaledBox.width = (int)(data.faceBox.width * scaleX);
+    scaledBox.height = (int)(data.faceBox.height * scaleY);
 
-void Layer5Visualization::show(const std::string& windowName, const cv::Mat& frame) {
-    if (frame.empty()) return;
-    
-    cv::Mat bgrFrame;
-    cv::cvtColor(frame, bgrFrame, cv::COLOR_RGB2BGR);
-    cv::imshow(windowName, bgrFrame);
-}
\ No newline at end of file
+    drawFaceBox(displayFrame, scaledBox, data.status);
+    drawStatusText(displayFrame, scaledBox, data.status, data.trackId);
+    if (data.landmarks && !data.landmarks->empty()) drawLandmarks(displayFrame, *data.landmarks);
+
+    if (data.status != DisplayStatus::TOO_FAR) {
+        drawScoreInfo(displayFrame, scaledBox, data.aiScore, data.physicalScore, data.finalScore);
+
+        if (data.status == DisplayStatus::VERIFYING || data.status == DisplayStatus::REAL_PERSON) {
+            drawProgressBar(displayFrame, scaledBox, data.consecutiveRealFrames,
+                            DecisionParams::current().confirmFrames, data.status);
+        }
+    }
+}
+
+void Layer5Visualization::renderFrame(cv::Mat& displayFrame, const std::vector<VisualizationData>& faces, float fps) {
+    if (displayFrame.empty() || smallFont.mask.empty()) return;
+    if (faces.empty()) drawWarningMessage(displayFrame);
+    for (const VisualizationData& data : faces) render(displayFrame, data);
+    drawFPSCounter(displayFrame, fps);
+}
@@ -5,163 +5,364 @@
 // =================================================================
 #include <iostream>
 #include <string>
+#include <memory>
 #include <chrono>
 #include <iomanip>
+#include <cstdio>
+#include <filesystem>
+#include <future>
 #include "layer1_capture.h"
 #include "layer2_detection.h"
 #include "layer3_liveness.h"
 #include "layer4_hybrid.h"
+#include "pipeline.h"
+#include "offline_runner.h"
+#include "backend_parity.h"
+#include "stream_server.h"
+#include "task_pool.h"
+#include "metrics.h"
+#include "decision_events.h"
+#include "frame_arena.h"
+#include "model_bundle.h"
+#include "decision_params.h"
 
 int main(int argc, char** argv) {
-    std::cout << "=== ANTI-SPOOFING SYSTEM ===" << std::endl;
+    const auto startTime = std::chrono::steady_clock::now();
     
     Layer1Capture camera;
     Layer2Detection detector;
     Layer3Liveness livenessLayer3;
     Layer4Hybrid   hybridLayer4;   
+
+    PipelineConfig pipelineConfig;
+    bool useEnsemble = true;
+    int keyframeInterval = 1;
+    DetectionScaleConfig detectionScale;
+    OfflineConfig offlineConfig;
+    V4L2Config v4l2Config;
+    bool useV4L2 = false;
+    std::string fakeDevicePath;
+    BackendOptions backendOptions;
+    bool parityMode = false;
+    float parityTolerance = 0.05f;
+    StreamServerConfig serverConfig;
+    SmoothingConfig smoothing;
+    int parallelThreads = -1;   // -1 = sequential Layer3 / Layer4
+    MetricsExportConfig metricsConfig;
+    std::string tracePath;
+    DecisionSinkConfig eventsConfig;
+    std::string bundlePath = "models/models.fmb";   // used when present
+    std::string packPath;
+    std::string decisionConfigPath;   // thresholds / weights, reloaded on change
+    std::string dumpConfigPath;
+    int configPollMs = 1000;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--drop-policy=block") {
+            pipelineConfig.dropPolicy = DropPolicy::BLOCK;
+        } else if (arg == "--drop-policy=drop" || arg == "--drop-policy=newest") {
+            pipelineConfig.dropPolicy = DropPolicy::DROP_WHEN_FULL;
+        } else if (arg.rfind("--queue-depth=", 0) == 0) {
+            pipelineConfig.queueCapacity = (size_t)std::max(2, std::atoi(arg.c_str() + 14));
+        } else if (arg.rfind("--keyframe-interval=", 0) == 0) {
+            keyframeInterval = std::atoi(arg.c_str() + 20);
+        } else if (arg == "--detect-downscale") {
+            detectionScale.downscale = true;
+        } else if (arg == "--detect-roi") {
+            detectionScale.roiMode = true;
+        } else if (arg.rfind("--offline=", 0) == 0) {
+            offlineConfig.inputPath = arg.substr(10);
+        } else if (arg.rfind("--output=", 0) == 0) {
+            offlineConfig.outputPath = arg.substr(9);
+        } else if (arg.rfind("--max-frames=", 0) == 0) {
+            offlineConfig.maxFrames = std::atol(arg.c_str() + 13);
+        } else if (arg == "--v4l2") {
+            useV4L2 = true;
+        } else if (arg.rfind("--v4l2=", 0) == 0) {
+            useV4L2 = true;
+            v4l2Config.device = arg.substr(7);
+        } else if (arg == "--v4l2-yuyv") {
+            v4l2Config.preferMjpeg = false;
+        } else if (arg.rfind("--fake-device=", 0) == 0) {
+            fakeDevicePath = arg.substr(14);
+        } else if (arg.rfind("--capture-size=", 0) == 0) {
+            int w = 0, h = 0;
+            if (std::sscanf(arg.c_str() + 15, "%dx%d", &w, &h) == 2 && w > 0 && h > 0) {
+                v4l2Config.width = w;
+                v4l2Config.height = h;
+            }
+        } else if (arg.rfind("--backend=", 0) == 0) {
+            if (!parseBackendKind(arg.substr(10), backendOptions.kind))
+                std::cerr << "[main] WARN: Unknown backend " << arg.substr(10) << ", using opencv" << std::endl;
+        } else if (arg == "--int8") {
+            backendOptions.preferInt8 = true;
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            backendOptions.threads = std::max(0, std::atoi(arg.c_str() + 10));
+        } else if (arg == "--parity") {
+            parityMode = true;
+        } else if (arg.rfind("--parity-tolerance=", 0) == 0) {
+            parityTolerance = (float)std::atof(arg.c_str() + 19);
+        } else if (arg.rfind("--stream=", 0) == 0) {
+            serverConfig.sources.push_back(arg.substr(9));
+        } else if (arg.rfind("--workers=", 0) == 0) {
+            serverConfig.workers = std::max(1, std::atoi(arg.c_str() + 10));
+        } else if (arg.rfind("--batch-streams=", 0) == 0) {
+            serverConfig.maxBatchStreams = std::max(1, std::atoi(arg.c_str() + 16));
+        } else if (arg == "--headless") {
+            pipelineConfig.headless = true;
+        } else if (arg == "--parallel") {
+            parallelThreads = 0;
+        } else if (arg.rfind("--parallel=", 0) == 0) {
+            parallelThreads = std::max(1, std::atoi(arg.c_str() + 11));
+        } else if (arg == "--cascade") {
+            pipelineConfig.cascade.enabled = true;
+        } else if (arg.rfind("--reverify-interval=", 0) == 0) {
+            pipelineConfig.cascade.reverifyInterval = std::max(1, std::atoi(arg.c_str() + 20));
+        } else if (arg.rfind("--cascade-order=", 0) == 0) {
+            if (!parseCascadeOrder(arg.substr(16), pipelineConfig.cascade.order))
+                std::cerr << "[main] WARN: Bad cascade order " << arg.substr(16) << ", keeping cheap,liveness,deep" << std::endl;
+        } else if (arg.rfind("--smoothing=", 0) == 0) {
+            if (!parseSmoothingPolicy(arg.substr(12), smoothing.policy))
+                std::cerr << "[main] WARN: Unknown smoothing " << arg.substr(12) << ", using weighted" << std::endl;
+        } else if (arg.rfind("--median-window=", 0) == 0) {
+            smoothing.medianWindow = std::atoi(arg.c_str() + 16);
+        } else if (arg.rfind("--ema-alpha=", 0) == 0) {
+            smoothing.emaAlpha = (float)std::atof(arg.c_str() + 12);
+        } else if (arg.rfind("--metrics-file=", 0) == 0) {
+            metricsConfig.filePath = arg.substr(15);
+        } else if (arg.rfind("--metrics-port=", 0) == 0) {
+            metricsConfig.httpPort = std::atoi(arg.c_str() + 15);
+        } else if (arg.rfind("--events-jsonl=", 0) == 0) {
+            eventsConfig.jsonlPath = arg.substr(15);
+        } else if (arg.rfind("--events-socket=", 0) == 0) {
+            eventsConfig.socketPath = arg.substr(16);
+        } else if (arg.rfind("--events-shm=", 0) == 0) {
+            eventsConfig.shmName = arg.substr(13);
+        } else if (arg.rfind("--trace=", 0) == 0) {
+            tracePath = arg.substr(8);
+        } else if (arg == "--qos") {
+            pipelineConfig.qos.enabled = true;
+        } else if (arg.rfind("--qos-target-ms=", 0) == 0) {
+            pipelineConfig.qos.enabled = true;
+            pipelineConfig.qos.targetP95Ms = std::max(1.0, std::atof(arg.c_str() + 16));
+        } else if (arg.rfind("--qos-window=", 0) == 0) {
+            pipelineConfig.qos.windowFrames = std::atoi(arg.c_str() + 13);
+        } else if (arg.rfind("--arena-mb=", 0) == 0) {
+            pipelineConfig.arenaBytes = (size_t)std::max(0, std::atoi(arg.c_str() + 11)) << 20;
+        } else if (arg.rfind("--model-bundle=", 0) == 0) {
+            bundlePath = arg.substr(15);
+        } else if (arg.rfind("--pack-models=", 0) == 0) {
+            packPath = arg.substr(14);
+        } else if (arg.rfind("--decision-config=", 0) == 0) {
+            decisionConfigPath = arg.substr(18);
+        } else if (arg.rfind("--dump-decision-config=", 0) == 0) {
+            dumpConfigPath = arg.substr(23);
+        } else if (arg.rfind("--config-poll-ms=", 0) == 0) {
+            configPollMs = std::atoi(arg.c_str() + 17);
+        } else if (arg == "--single-model") {
+            useEnsemble = false;
+        } else {
+            std::cerr << "[main] WARN: Unknown argument " << arg << std::endl;
+        }
+    }
     
+    // stdout carries nothing but events: every log line goes to stderr
+    if (eventsConfig.jsonlPath == "-") {
+        eventsConfig.stdoutFd = DecisionEventSink::detachStdout();
+        if (eventsConfig.stdoutFd < 0) {
+            std::cerr << "[main] ERROR: Cannot keep stdout for --events-jsonl=-" << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "=== ANTI-SPOOFING SYSTEM ===" << std::endl;
+
+#ifndef FACE_WITH_METRICS
+    if (!metricsConfig.filePath.empty() || metricsConfig.httpPort > 0 || !tracePath.empty()) {
+        std::cerr << "[main] WARN: Built with ENABLE_METRICS=OFF, metrics / trace flags ignored" << std::endl;
+    }
+#endif
+#ifdef FACE_HEADLESS
+    pipelineConfig.headless = true;   // highgui not linked
+#endif
+    if (AllocationCounter::enabled()) AllocationCounter::install();   // ALLOC_DEBUG build
+    if (!tracePath.empty()) Metrics::enableTrace();
+    MetricsExporterScope metricsExporter;
+    if (!metricsConfig.filePath.empty() || metricsConfig.httpPort > 0) metricsExporter.start(metricsConfig);
+
+    std::vector<LivenessModelSpec> livenessModels = {
+        {"models/MiniFASNetV1SE.onnx", 1.8f, 1.0f},
+        {"models/MiniFASNetV2.onnx",   2.7f, 1.0f}
+    };
+    if (!useEnsemble) livenessModels.resize(1);
+    const std::string detectorPath = "models/face_detection_yunet_2023mar.onnx";
+
+    // ===== Decision thresholds: file overrides the defaults, edits apply while running =====
+    DecisionConfigWatcher configWatcher;
+    if (!decisionConfigPath.empty()) {
+        DecisionParams params;
+        if (!DecisionParams::load(decisionConfigPath, params)) return 1;
+        DecisionParams::publish(params);
+        std::cout << "[main] INFO: Decision config " << decisionConfigPath << std::endl;
+        if (dumpConfigPath.empty()) configWatcher.start(decisionConfigPath, configPollMs);
+    }
+    if (!dumpConfigPath.empty()) {
+        return DecisionParams::save(dumpConfigPath, DecisionParams::current()) ? 0 : 1;
+    }
+
+    if (!packPath.empty()) {
+        // ===== Model bundle: YuNet + full ensemble, with any _int8 / .ort variants =====
+        std::vector<std::string> files = ModelBundle::variants(detectorPath);
+        for (const LivenessModelSpec& spec : {LivenessModelSpec{"models/MiniFASNetV1SE.onnx", 1.8f, 1.0f},
+                                              LivenessModelSpec{"models/MiniFASNetV2.onnx", 2.7f, 1.0f}}) {
+            std::vector<std::string> more = ModelBundle::variants(spec.path);
+            files.insert(files.end(), more.begin(), more.end());
+        }
+        return ModelBundle::pack(files, packPath) ? 0 : 1;
+    }
+    ModelBundle bundle;
+    std::error_code bundleError;
+    if (!bundlePath.empty() && std::filesystem::exists(bundlePath, bundleError) && !bundle.open(bundlePath)) {
+        std::cerr << "[main] WARN: Ignoring model bundle " << bundlePath << ", loading models/ files" << std::endl;
+    }
+    const ModelBundle* modelBundle = bundle.isOpen() ? &bundle : nullptr;
+
+    if (parityMode) {
+        // ===== Backend / INT8 accuracy gate on an offline source =====
+        if (offlineConfig.inputPath.empty()) {
+            std::cerr << "[main] ERROR: --parity needs --offline=<video|dir|manifest>" << std::endl;
+            return 1;
+        }
+        ParityConfig parity;
+        parity.inputPath = offlineConfig.inputPath;
+        parity.detectorPath = detectorPath;
+        parity.models = livenessModels;
+        parity.candidate = backendOptions;
+        parity.tolerance = parityTolerance;
+        if (offlineConfig.maxFrames > 0) parity.maxFrames = offlineConfig.maxFrames;
+        int rc = runBackendParity(parity);
+        Metrics::stopExporter();
+        return rc;
+    }
+
+    // ===== Structured decision output (JSONL / Unix socket / shared memory) =====
+    DecisionEventSink events;
+    if (eventsConfig.enabled() && !events.init(eventsConfig)) {
+        std::cerr << "[main] ERROR: Decision event sink init failed" << std::endl;
+        Metrics::stopExporter();
+        return 1;
+    }
+    DecisionEventSink* eventSink = events.isOpen() ? &events : nullptr;
+    pipelineConfig.events = eventSink;
+
+    if (!serverConfig.sources.empty()) {
+        // ===== Multi-camera server: N sources, shared inference workers, no window =====
+        serverConfig.models = livenessModels;
+        serverConfig.backend = backendOptions;
+        serverConfig.smoothing = smoothing;
+        serverConfig.dropPolicy = pipelineConfig.dropPolicy;
+        serverConfig.maxFrames = offlineConfig.maxFrames;
+        serverConfig.events = eventSink;
+        serverConfig.arenaBytes = pipelineConfig.arenaBytes;
+        serverConfig.bundle = modelBundle;
+        StreamServer server;
+        if (!server.init(serverConfig)) return 1;
+        server.run();
+        events.close();
+        if (eventSink) events.printStats("[main]");
+        Metrics::stopExporter();
+        if (!tracePath.empty()) Metrics::writeChromeTrace(tracePath);
+        std::cout << "======= SYSTEM STOPPED =======" << std::endl;
+        return 0;
+    }
+
+    const bool offlineMode = !offlineConfig.inputPath.empty();
+    detector.setBackend(backendOptions);
+    livenessLayer3.setBackend(backendOptions);
+    livenessLayer3.setSmoothing(smoothing);
+    detector.setModelBundle(modelBundle);
+    livenessLayer3.setModelBundle(modelBundle);
+    pipelineConfig.startTime = startTime;
+
     try {
-        // ===== 1. Init Camera =====
-        if (!camera.init()) {
+        // ===== 1. Models: load + warm up on a second thread while the camera opens =====
+        // (Camera and models do not share state; the future is joined before anything uses them)
+        const cv::Size expectedSize(v4l2Config.width, v4l2Config.height);
+        std::future<void> models = std::async(std::launch::async, [&] {
+            if (!detector.init(detectorPath))
+                throw std::runtime_error("[main] Detector Init Failed");
+            if (!livenessLayer3.init(livenessModels)) {
+                std::cerr << "[main] WARN: Ensemble init failed, using MiniFASNetV1SE only" << std::endl;
+                if (!livenessLayer3.init("models/MiniFASNetV1SE.onnx"))
+                    throw std::runtime_error("[main] Liveness Init Failed");
+            }
+            livenessLayer3.warmUp(2);
+            detector.warmUp(expectedSize);
+        });
+
+        // ===== 2. Init Camera (or offline source) =====
+        if (offlineMode) {
+            if (!camera.openSource(offlineConfig.inputPath))
+                throw std::runtime_error("[main] Failed to open offline source " + offlineConfig.inputPath);
+        } else if (!fakeDevicePath.empty()) {
+            if (!camera.initFakeDevice(fakeDevicePath, v4l2Config.width, v4l2Config.height, v4l2Config.fps))
+                throw std::runtime_error("[main] Failed to open fake device " + fakeDevicePath);
+        } else if (useV4L2) {
+            if (!camera.initV4L2(v4l2Config))
+                throw std::runtime_error("[main] Failed to init V4L2 camera " + v4l2Config.device);
+        } else if (!camera.init()) {
             throw std::runtime_error("[main] Failed to init camera! Check connection.");
         }
 
-        // ===== 2. Init Face Detector =====
-        if (!detector.init("models/face_detection_yunet_2023mar.onnx")) 
-            throw std::runtime_error("[main] Detector Init Failed");
-
-        // ===== 3. Init Liveness Layer 3 =====
-        if (!livenessLayer3.init("models/MiniFASNetV1SE.onnx")) 
-            throw std::runtime_error("[main] Liveness Init Failed");
-
-        cv::Mat frameBgr; 
-        FaceResult faceResult;
-        LivenessResult liveResult;
-        
-        int realConsecutive = 0;
-        int spoofConsecutive = 0;
-        int missingFaceCounter = 0;
-        float lastRealScore = -1.0f;
-        int suddenDropCount = 0;
-        float confidenceAccumulator = 0.0f;
-        
-        int minFaceWidth = camera.getMinFaceWidth(); 
-        cv::Size captureSize = camera.getCaptureSize();
-        float fontScale = std::max(0.5f, captureSize.width / 1200.0f);
-        int thickness = std::max(1, (int)(fontScale * 2));
+        models.get();   // rethrows a model init failure
+        std::cout << "[main] INFO: Camera + models ready in "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count()
+                  << " ms" << std::endl;
 
-        std::cout << "[main] System Running. Resolution: " << captureSize << std::endl;
+        // ===== 3. Detection scale / tracking (need the real capture size) =====
+        detectionScale.minFaceWidth = camera.getMinFaceWidth();
+        if (detectionScale.downscale || detectionScale.roiMode) {
+            detector.setScaleConfig(detectionScale);
+        }
+        if (keyframeInterval > 1) {
+            TrackingConfig tracking;
+            tracking.maxInterval = keyframeInterval;
+            tracking.minInterval = std::min(tracking.minInterval, keyframeInterval);
+            detector.enableTracking(tracking);
+        }
+        // Warm-up guessed the size; redo it only when the detector input will differ
+        if (camera.getCaptureSize() != expectedSize || detectionScale.downscale) {
+            detector.warmUp(camera.getCaptureSize());
+        }
 
-        // ===== Main Loop =====
-        while (true) {
-            if (!camera.grabFrame(frameBgr)) break;
-            bool found = detector.detect(frameBgr, faceResult);
-
-            if (found) {
-                missingFaceCounter = 0;
-
-                if (faceResult.bbox.width < minFaceWidth) {
-                     cv::rectangle(frameBgr, faceResult.bbox, cv::Scalar(0, 255, 255), 2);
-                     livenessLayer3.resetHistory();
-                     realConsecutive = 0; 
-                     spoofConsecutive = 0;
-                     lastRealScore = -1.0f;
-                     confidenceAccumulator = 0.0f;
-                } else {
-                    // Liveness check
-                    livenessLayer3.checkLiveness(frameBgr, faceResult.bbox, liveResult);
-                    float rawScore = livenessLayer3.getLastRawScore();
-                    
-                    // Quality analysis
-                    float adjustment = hybridLayer4.analyzeQuality(frameBgr, faceResult.bbox);
-                    float finalScore = liveResult.score * 0.75f + adjustment * 0.25f;
-                    
-                    if (adjustment < -0.45f) {
-                        finalScore *= 0.80f;
-                    } else if (adjustment < -0.35f) {
-                        finalScore *= 0.90f;
-                    }
-                    
-                    finalScore = std::max(0.0f, std::min(1.0f, finalScore));
-
-                    if (lastRealScore > 0.70f && rawScore < 0.35f) {
-                        suddenDropCount++;
-                        if (suddenDropCount >= 3) { 
-                            finalScore = std::min(finalScore, 0.35f);
-                            spoofConsecutive = std::max(spoofConsecutive, 2);
-                        }
-                    } else if (rawScore > 0.60f) {
-                        suddenDropCount = 0;
-                    }
-
-                    bool passLayer3Basic = (liveResult.score > 0.60f);  
-                    bool passLayer3Strong = (liveResult.score > 0.70f); 
-                    bool passLayer4 = (adjustment > -0.40f);            
-                    bool passLayer4Strong = (adjustment > -0.20f);      
-                    bool isStrongReal = (finalScore > 0.75f && passLayer3Strong && passLayer4Strong);
-                    bool isWeakReal = (finalScore > 0.65f && passLayer3Basic && passLayer4);     
-                    bool isStrongFake = (finalScore < 0.30f || adjustment < -0.50f || liveResult.score < 0.25f);
-                    bool isWeakFake = (finalScore < 0.45f && liveResult.score < 0.55f && adjustment < -0.35f);
-
-                    if (isStrongReal || isWeakReal) {
-                        realConsecutive++;
-                        spoofConsecutive = 0;
-                        lastRealScore = finalScore;
-                        
-                        if (isStrongReal) {
-                            confidenceAccumulator += 2.0f;
-                        } else {
-                            confidenceAccumulator += 1.5f; 
-                        }
-                    } else {
-                        realConsecutive = 0;
-                        confidenceAccumulator = 0.0f;
-                        
-                        if (isStrongFake || isWeakFake) {
-                            spoofConsecutive++;
-                            lastRealScore = -1.0f;
-                        }
-                    }
-                    cv::Scalar color;
-                    
-                    // REAL: 
-                    if (realConsecutive >= 4 && confidenceAccumulator >= 6.0f) {
-                        color = cv::Scalar(0, 255, 0); // XANH
-                    } 
-                    // FAKE: 
-                    else if (spoofConsecutive >= 4 || isStrongFake) {
-                        color = cv::Scalar(0, 0, 255); // DO
-                    }
-                    // Analyzing
-                    else {
-                        color = cv::Scalar(0, 255, 255); // VANG
-                    }
-
-                    cv::rectangle(frameBgr, faceResult.bbox, color, 2);
-                }
-            } else {
-                missingFaceCounter++;
-                if (missingFaceCounter > 10) {
-                    realConsecutive = 0;
-                    spoofConsecutive = 0;
-                    lastRealScore = -1.0f;
-                    suddenDropCount = 0;
-                    confidenceAccumulator = 0.0f;
-                    livenessLayer3.resetHistory();
-                }
-            }
+        std::unique_ptr<WorkStealingPool> executor;
+        if (parallelThreads >= 0) {
+            executor.reset(new WorkStealingPool(parallelThreads));
+            pipelineConfig.executor = executor.get();
+            // OpenCV's pool shares the cores with ours (+ the calling thread), no oversubscription
+            const int cvThreads = std::max(1, (int)std::thread::hardware_concurrency() - executor->size() - 1);
+            cv::setNumThreads(cvThreads);
+            std::cout << "[main] Parallel Layer3/Layer4 on " << executor->size() << " threads, OpenCV on "
+                      << cvThreads << std::endl;
+        }
 
-            camera.show("Anti-Spoofing Pro v2.2", frameBgr);
-            
-            char key = cv::waitKey(1);
-            if (key == 27) break; // ESC
-            if (key == 'r' || key == 'R') {
-                realConsecutive = 0;
-                spoofConsecutive = 0;
-                confidenceAccumulator = 0.0f;
-                livenessLayer3.resetHistory();
-                std::cout << "[main] Manual reset triggered" << std::endl;
-            }
+        cv::Size captureSize = camera.getCaptureSize();
+        std::cout << "[main] System Running. Resolution: " << captureSize << std::endl;
+
+        if (offlineMode) {
+            // ===== Headless batch scoring =====
+            FrameAnalyzer analyzer(livenessLayer3, hybridLayer4);
+            analyzer.setExecutor(executor.get());
+            analyzer.setCascade(pipelineConfig.cascade);
+            if (pipelineConfig.arenaBytes > 0) analyzer.enableArena(pipelineConfig.arenaBytes);
+            OfflineRunner runner(camera, detector, analyzer);
+            runner.setEventSink(eventSink);
+            if (!runner.run(offlineConfig))
+                throw std::runtime_error("[main] Offline run produced no frames");
+        } else {
+            // ===== Main Loop (capture -> detect -> liveness -> display thread / headless) =====
+            Pipeline pipeline(camera, detector, livenessLayer3, hybridLayer4);
+            pipeline.run(pipelineConfig);
+            pipeline.printStats();
         }
     }
     catch (const std::exception& e) {
@@ -172,8 +373,11 @@ int main(int argc, char** argv) {
     }
 
     camera.release();
-    cv::destroyAllWindows();
+    events.close();
+    if (eventSink) events.printStats("[main]");
+    Metrics::stopExporter();
+    if (!tracePath.empty()) Metrics::writeChromeTrace(tracePath);
     std::cout << "======= SYSTEM STOPPED =======" << std::endl;
 
     return 0;
-}
\ No newline at end of file
+}
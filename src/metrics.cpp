@@ -0,0 +1,302 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/metrics.cpp (Per-stage latency metrics + tracing)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "metrics.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+constexpr int stageCount = (int)MetricStage::COUNT;
+constexpr int subBucketBits = 5;                       // 32 sub-buckets per power of two
+constexpr int subBuckets = 1 << subBucketBits;
+constexpr int bucketCount = (32 - subBucketBits) * subBuckets;   // up to 2^32 us
+
+// Microseconds -> bucket: linear below 64 us, then 32 steps per octave
+int bucketIndex(uint64_t us) {
+    if (us < (uint64_t)(2 * subBuckets)) return (int)us;
+    int exponent = 63 - __builtin_clzll(us);
+    int shift = exponent - subBucketBits;
+    int index = (shift + 1) * subBuckets + (int)((us >> shift) - subBuckets);
+    return index < bucketCount ? index : bucketCount - 1;
+}
+
+// Middle of a bucket in microseconds
+double bucketValue(int index) {
+    if (index < 2 * subBuckets) return index;
+    int shift = index / subBuckets - 1;
+    uint64_t low = (uint64_t)(index % subBuckets + subBuckets) << shift;
+    return low + ((1ull << shift) - 1) / 2.0;
+}
+
+struct TraceEvent {
+    uint64_t startNs;
+    uint64_t durationNs;
+    MetricStage stage;
+};
+
+struct ThreadMetrics {
+    int threadId = 0;
+    std::atomic<uint64_t> buckets[stageCount][bucketCount];
+    std::atomic<uint64_t> count[stageCount];
+    std::atomic<uint64_t> sumNs[stageCount];
+    std::vector<TraceEvent> trace;
+    std::atomic<size_t> traceUsed{0};
+
+    ThreadMetrics() {
+        for (int s = 0; s < stageCount; ++s) {
+            for (int b = 0; b < bucketCount; ++b) buckets[s][b].store(0, std::memory_order_relaxed);
+            count[s].store(0, std::memory_order_relaxed);
+            sumNs[s].store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+// Threads register once; the registry owns the histograms so they outlive their thread
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadMetrics>> registry;
+std::atomic<size_t> traceCapacity(0);
+thread_local ThreadMetrics* localMetrics = nullptr;
+thread_local int pausedDepth = 0;   // MetricsPause on this thread
+const uint64_t processStartNs = Metrics::nowNs();
+
+ThreadMetrics& threadMetrics() {
+    if (!localMetrics) {
+        std::unique_ptr<ThreadMetrics> metrics(new ThreadMetrics());
+        size_t capacity = traceCapacity.load(std::memory_order_acquire);
+        if (capacity > 0) metrics->trace.resize(capacity);
+        std::lock_guard<std::mutex> lock(registryMutex);
+        metrics->threadId = (int)registry.size() + 1;
+        localMetrics = metrics.get();
+        registry.push_back(std::move(metrics));
+    }
+    return *localMetrics;
+}
+
+void bump(std::atomic<uint64_t>& counter, uint64_t value) {
+    // Single writer: load + store, no locked read-modify-write
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+// ===== Exporter (file and / or HTTP) =====
+std::atomic<bool> exporterRunning(false);
+std::thread fileThread;
+std::thread httpThread;
+
+void fileLoop(MetricsExportConfig config) {
+    auto next = std::chrono::steady_clock::now();
+    while (exporterRunning) {
+        if (std::chrono::steady_clock::now() >= next) {
+            std::string tmp = config.filePath + ".tmp";
+            {
+                std::ofstream out(tmp);
+                Metrics::writePrometheus(out);
+            }
+            std::rename(tmp.c_str(), config.filePath.c_str());
+            next += std::chrono::seconds(std::max(1, config.intervalSec));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
+
+void serveClient(int client) {
+    char request[1024];
+    ssize_t n = recv(client, request, sizeof(request) - 1, 0);
+    if (n <= 0) return;
+    request[n] = '\0';
+
+    std::string body;
+    std::string status = "200 OK";
+    if (std::string(request).rfind("GET /metrics", 0) == 0) {
+        std::ostringstream out;
+        Metrics::writePrometheus(out);
+        body = out.str();
+    } else {
+        status = "404 Not Found";
+        body = "not found\n";
+    }
+    std::ostringstream response;
+    response << "HTTP/1.1 " << status << "\r\n"
+             << "Content-Type: text/plain; version=0.0.4\r\n"
+             << "Content-Length: " << body.size() << "\r\n"
+             << "Connection: close\r\n\r\n" << body;
+    std::string data = response.str();
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t w = send(client, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (w <= 0) break;
+        sent += (size_t)w;
+    }
+}
+
+void httpLoop(int server) {
+    while (exporterRunning) {
+        pollfd pfd = {server, POLLIN, 0};
+        if (poll(&pfd, 1, 200) <= 0) continue;
+        int client = accept(server, nullptr, nullptr);
+        if (client < 0) continue;
+        serveClient(client);
+        close(client);
+    }
+    close(server);
+}
+
+int openHttpSocket(int port) {
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    if (server < 0) return -1;
+    int yes = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(server, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(server, 4) != 0) {
+        close(server);
+        return -1;
+    }
+    return server;
+}
+}
+
+const char* metricStageName(MetricStage stage) {
+    switch (stage) {
+        case MetricStage::CAPTURE:          return "capture";
+        case MetricStage::DETECT:           return "detect";
+        case MetricStage::LIVENESS_FORWARD: return "liveness_forward";
+        case MetricStage::CUE_COLOR:        return "cue_color";
+        case MetricStage::CUE_TEXTURE:      return "cue_texture";
+        case MetricStage::CUE_EDGES:        return "cue_edges";
+        case MetricStage::CUE_MOIRE:        return "cue_moire";
+        case MetricStage::CUE_HIGH_FREQ:    return "cue_high_freq";
+        case MetricStage::DISPLAY:          return "display";
+        default:                            return "unknown";
+    }
+}
+
+void Metrics::record(MetricStage stage, uint64_t startNs, uint64_t durationNs) {
+    if (pausedDepth > 0) return;
+    ThreadMetrics& m = threadMetrics();
+    const int s = (int)stage;
+    bump(m.buckets[s][bucketIndex(durationNs / 1000)], 1);
+    bump(m.count[s], 1);
+    bump(m.sumNs[s], durationNs);
+
+    size_t used = m.traceUsed.load(std::memory_order_relaxed);
+    if (used < m.trace.size()) {
+        m.trace[used] = TraceEvent{startNs, durationNs, stage};
+        m.traceUsed.store(used + 1, std::memory_order_release);
+    }
+}
+
+MetricsPause::MetricsPause() {
+    ++pausedDepth;
+}
+
+MetricsPause::~MetricsPause() {
+    --pausedDepth;
+}
+
+void Metrics::writePrometheus(std::ostream& out) {
+    static const double quantiles[] = {0.5, 0.9, 0.99};
+    std::vector<uint64_t> merged(bucketCount);
+
+    out << "# HELP face_stage_latency_us Per-stage latency in microseconds\n"
+        << "# TYPE face_stage_latency_us summary\n";
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (int s = 0; s < stageCount; ++s) {
+        std::fill(merged.begin(), merged.end(), 0);
+        uint64_t count = 0;
+        uint64_t sumNs = 0;
+        for (const auto& m : registry) {
+            for (int b = 0; b < bucketCount; ++b) merged[b] += m->buckets[s][b].load(std::memory_order_relaxed);
+            count += m->count[s].load(std::memory_order_relaxed);
+            sumNs += m->sumNs[s].load(std::memory_order_relaxed);
+        }
+        if (count == 0) continue;
+
+        const char* name = metricStageName((MetricStage)s);
+        uint64_t total = 0;
+        for (uint64_t c : merged) total += c;
+        for (double q : quantiles) {
+            uint64_t rank = (uint64_t)(q * total);
+            uint64_t seen = 0;
+            int b = 0;
+            for (; b < bucketCount; ++b) {
+                seen += merged[b];
+                if (seen > rank) break;
+            }
+            out << "face_stage_latency_us{stage=\"" << name << "\",quantile=\"" << q << "\"} "
+                << bucketValue(std::min(b, bucketCount - 1)) << "\n";
+        }
+        out << "face_stage_latency_us_sum{stage=\"" << name << "\"} " << sumNs / 1000.0 << "\n"
+            << "face_stage_latency_us_count{stage=\"" << name << "\"} " << count << "\n";
+    }
+}
+
+bool Metrics::startExporter(const MetricsExportConfig& config) {
+    if (exporterRunning) return true;
+    int server = -1;
+    if (config.httpPort > 0) {
+        server = openHttpSocket(config.httpPort);
+        if (server < 0) {
+            std::cerr << "[Metrics] ERROR: Cannot listen on 127.0.0.1:" << config.httpPort << std::endl;
+            return false;
+        }
+    }
+    exporterRunning = true;
+    if (!config.filePath.empty()) fileThread = std::thread(fileLoop, config);
+    if (server >= 0) {
+        httpThread = std::thread(httpLoop, server);
+        std::cout << "[Metrics] INFO: Serving http://127.0.0.1:" << config.httpPort << "/metrics" << std::endl;
+    }
+    return true;
+}
+
+void Metrics::stopExporter() {
+    exporterRunning = false;
+    if (fileThread.joinable()) fileThread.join();
+    if (httpThread.joinable()) httpThread.join();
+}
+
+void Metrics::enableTrace(size_t eventsPerThread) {
+    traceCapacity.store(eventsPerThread, std::memory_order_release);
+}
+
+bool Metrics::writeChromeTrace(const std::string& path) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "[Metrics] ERROR: Cannot write " << path << std::endl;
+        return false;
+    }
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (const auto& m : registry) {
+        size_t used = m->traceUsed.load(std::memory_order_acquire);
+        for (size_t i = 0; i < used; ++i) {
+            const TraceEvent& e = m->trace[i];
+            out << (first ? "" : ",") << "\n{\"name\":\"" << metricStageName(e.stage)
+                << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << m->threadId
+                << ",\"ts\":" << (e.startNs - processStartNs) / 1000.0
+                << ",\"dur\":" << e.durationNs / 1000.0 << "}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+    std::cout << "[Metrics] INFO: Trace written to " << path << std::endl;
+    return true;
+}
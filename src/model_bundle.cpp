@@ -0,0 +1,205 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/model_bundle.cpp (mmap'ed model bundle, fast cold start)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "model_bundle.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr char bundleMagic[4] = {'F', 'M', 'B', '1'};
+constexpr uint32_t bundleVersion = 1;
+constexpr uint64_t payloadAlign = 4096;
+
+struct BundleHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+struct BundleEntry {
+    char name[112];
+    uint64_t offset;
+    uint64_t size;
+};
+
+static_assert(sizeof(BundleHeader) == 16, "bundle header layout");
+static_assert(sizeof(BundleEntry) == 128, "bundle entry layout");
+
+uint64_t alignUp(uint64_t n) {
+    return (n + payloadAlign - 1) & ~(payloadAlign - 1);
+}
+}
+
+struct ModelBundle::Mapping {
+    void* addr = MAP_FAILED;
+    size_t length = 0;
+    ~Mapping() {
+        if (addr != MAP_FAILED) munmap(addr, length);
+    }
+};
+
+ModelBundle::ModelBundle() {}
+ModelBundle::~ModelBundle() {}
+
+bool ModelBundle::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(BundleHeader)) {
+        ::close(fd);
+        std::cerr << "[Bundle] ERROR: " << path << " is not a model bundle" << std::endl;
+        return false;
+    }
+
+    std::shared_ptr<Mapping> map(new Mapping());
+    map->length = (size_t)st.st_size;
+    map->addr = mmap(nullptr, map->length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);   // the mapping keeps the file
+    if (map->addr == MAP_FAILED) {
+        std::cerr << "[Bundle] ERROR: mmap " << path << " failed" << std::endl;
+        return false;
+    }
+    // Start paging the weights in now, the parse below touches them right away
+    madvise(map->addr, map->length, MADV_WILLNEED);
+
+    const uchar* base = static_cast<const uchar*>(map->addr);
+    BundleHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, bundleMagic, 4) != 0 || header.version != bundleVersion ||
+        sizeof(BundleHeader) + (uint64_t)header.count * sizeof(BundleEntry) > map->length) {
+        std::cerr << "[Bundle] ERROR: " << path << " has a bad header (expected FMB1 v" << bundleVersion << ")" << std::endl;
+        return false;
+    }
+
+    std::vector<Entry> parsed;
+    for (uint32_t i = 0; i < header.count; ++i) {
+        BundleEntry raw;
+        std::memcpy(&raw, base + sizeof(BundleHeader) + i * sizeof(BundleEntry), sizeof(raw));
+        raw.name[sizeof(raw.name) - 1] = '\0';
+        if (raw.offset > map->length || raw.size > map->length - raw.offset) {
+            std::cerr << "[Bundle] ERROR: " << path << " entry " << raw.name << " out of range" << std::endl;
+            return false;
+        }
+        parsed.push_back(Entry{raw.name, raw.offset, raw.size});
+    }
+
+    mapping = map;
+    entries.swap(parsed);
+    std::cout << "[Bundle] INFO: Mapped " << path << " (" << entries.size() << " models, "
+              << map->length / 1024 << " KiB)" << std::endl;
+    return true;
+}
+
+void ModelBundle::close() {
+    mapping.reset();   // blobs handed out keep their own reference
+    entries.clear();
+}
+
+bool ModelBundle::lookup(const std::string& name, ModelBlob& out) const {
+    for (const Entry& entry : entries) {
+        if (entry.name != name) continue;
+        out.name = entry.name;
+        out.data = static_cast<const uchar*>(mapping->addr) + entry.offset;
+        out.size = (size_t)entry.size;
+        out.keepAlive = mapping;
+        return true;
+    }
+    return false;
+}
+
+bool ModelBundle::find(const std::string& modelPath, const BackendOptions& options, ModelBlob& out) const {
+    if (!mapping) return false;
+    std::filesystem::path p(modelPath);
+    const std::string stem = p.stem().string();
+
+    std::vector<std::string> stems;
+    if (options.preferInt8) stems.push_back(stem + "_int8");
+    stems.push_back(stem);
+    for (const std::string& s : stems) {
+        if (options.kind == BackendKind::ONNXRUNTIME && lookup(s + ".ort", out)) return true;
+        if (lookup(s + p.extension().string(), out)) return true;
+    }
+    return false;
+}
+
+std::vector<std::string> ModelBundle::variants(const std::string& modelPath) {
+    namespace fs = std::filesystem;
+    fs::path p(modelPath);
+    const std::string stem = (p.parent_path() / p.stem()).string();
+    std::vector<std::string> files = {modelPath};
+    for (const std::string& extra : {stem + "_int8" + p.extension().string(), stem + ".ort", stem + "_int8.ort"}) {
+        std::error_code ec;
+        if (fs::exists(extra, ec)) files.push_back(extra);
+    }
+    return files;
+}
+
+bool ModelBundle::pack(const std::vector<std::string>& files, const std::string& outPath) {
+    std::vector<std::string> names;
+    std::vector<std::vector<char>> payloads;
+    for (const std::string& file : files) {
+        std::ifstream in(file, std::ios::binary);
+        if (!in) {
+            std::cerr << "[Bundle] WARN: Skipping missing " << file << std::endl;
+            continue;
+        }
+        std::string name = std::filesystem::path(file).filename().string();
+        if (name.size() >= sizeof(BundleEntry::name)) {
+            std::cerr << "[Bundle] WARN: Skipping " << file << " (name too long)" << std::endl;
+            continue;
+        }
+        names.push_back(name);
+        payloads.emplace_back(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    if (names.empty()) {
+        std::cerr << "[Bundle] ERROR: Nothing to pack" << std::endl;
+        return false;
+    }
+
+    BundleHeader header = {};
+    std::memcpy(header.magic, bundleMagic, 4);
+    header.version = bundleVersion;
+    header.count = (uint32_t)names.size();
+
+    std::vector<BundleEntry> table(names.size());
+    uint64_t offset = alignUp(sizeof(BundleHeader) + names.size() * sizeof(BundleEntry));
+    for (size_t i = 0; i < names.size(); ++i) {
+        std::memset(&table[i], 0, sizeof(BundleEntry));
+        std::memcpy(table[i].name, names[i].c_str(), names[i].size());
+        table[i].offset = offset;
+        table[i].size = payloads[i].size();
+        offset = alignUp(offset + payloads[i].size());
+    }
+
+    std::ofstream out(outPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "[Bundle] ERROR: Cannot write " << outPath << std::endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(BundleEntry));
+    for (size_t i = 0; i < names.size(); ++i) {
+        std::vector<char> pad(table[i].offset - (uint64_t)out.tellp(), 0);
+        out.write(pad.data(), pad.size());
+        out.write(payloads[i].data(), payloads[i].size());
+        std::cout << "[Bundle] INFO: + " << names[i] << " (" << payloads[i].size() / 1024 << " KiB)" << std::endl;
+    }
+    out.close();
+    if (!out) {
+        std::cerr << "[Bundle] ERROR: Write to " << outPath << " failed" << std::endl;
+        return false;
+    }
+    std::cout << "[Bundle] INFO: Packed " << names.size() << " models into " << outPath << std::endl;
+    return true;
+}
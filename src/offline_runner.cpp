@@ -0,0 +1,185 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/offline_runner.cpp (Headless batch scoring + benchmark)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "offline_runner.h"
+#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+double elapsedMs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+std::string jsonEscape(const std::string& s) {
+    std::string r;
+    r.reserve(s.size());
+    for (char c : s) {
+        if (c == '"' || c == '\\') r += '\\';
+        if ((unsigned char)c < 0x20) continue;
+        r += c;
+    }
+    return r;
+}
+
+std::string csvEscape(const std::string& s) {
+    std::string r = "\"";
+    for (char c : s) {
+        if (c == '"') r += '"';
+        r += c;
+    }
+    return r + "\"";
+}
+
+double peakRssMb() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+    return usage.ru_maxrss / 1024.0;   // Linux reports KB
+}
+}
+
+double LatencyStats::percentile(double p) {
+    if (samples.empty()) return 0.0;
+    if (!sorted) {
+        std::sort(samples.begin(), samples.end());
+        sorted = true;
+    }
+    // Nearest-rank percentile
+    double rank = std::ceil(p / 100.0 * samples.size());
+    size_t idx = (size_t)std::max(1.0, std::min(rank, (double)samples.size())) - 1;
+    return samples[idx];
+}
+
+double LatencyStats::mean() const {
+    if (samples.empty()) return 0.0;
+    double sum = 0.0;
+    for (double v : samples) sum += v;
+    return sum / samples.size();
+}
+
+OfflineRunner::OfflineRunner(Layer1Capture& source, Layer2Detection& detector, FrameAnalyzer& analyzer)
+    : source(source), detector(detector), analyzer(analyzer), events(nullptr), jsonl(false),
+      steadyAllocations(0), steadyFrames(0) {}
+
+bool OfflineRunner::run(const OfflineConfig& config) {
+    if (!config.outputPath.empty()) {
+        out.open(config.outputPath);
+        if (!out.is_open()) {
+            std::cerr << "[Offline] ERROR: Cannot write " << config.outputPath << std::endl;
+            return false;
+        }
+        std::string ext = std::filesystem::path(config.outputPath).extension().string();
+        jsonl = (ext == ".jsonl" || ext == ".json");
+        if (!jsonl) {
+            out << "frame,name,track_id,x,y,w,h,raw_score,liveness_score,adjustment,final_score,state\n";
+        }
+    }
+
+    analyzer.setMinFaceWidth(source.getMinFaceWidth());
+    analyzer.reset();
+
+    cv::Mat frame;
+    std::vector<FaceResult> faces;
+    std::vector<FaceAnalysis> analyses;
+    long frames = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    while (config.maxFrames < 0 || frames < config.maxFrames) {
+        auto t0 = std::chrono::steady_clock::now();
+        if (!source.grabFrame(frame)) break;
+        decodeStats.add(elapsedMs(t0));
+
+        auto t1 = std::chrono::steady_clock::now();
+        {
+            FACE_SCOPED_TIMER(MetricStage::DETECT);
+            detector.detectTracked(frame, faces);
+        }
+        detectStats.add(elapsedMs(t1));
+
+        const uint64_t allocsBefore = AllocationCounter::count();
+        analyzer.analyze(frame, faces, analyses);
+        if (frames >= allocWarmupFrames) {
+            steadyAllocations += AllocationCounter::count() - allocsBefore;
+            steadyFrames++;
+        }
+        livenessStats.add(analyzer.getLastLivenessMs());
+        qualityStats.add(analyzer.getLastQualityMs());
+        totalStats.add(elapsedMs(t0));
+
+        if (out.is_open()) writeFrame(frames, faces, analyses);
+        if (events) events->publishFrame(-1, (uint64_t)frames, std::chrono::steady_clock::time_point(), faces, analyses);
+        frames++;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    out.close();
+    printReport(frames, seconds);
+    return frames > 0;
+}
+
+void OfflineRunner::writeFrame(long index, const std::vector<FaceResult>& faces,
+                               const std::vector<FaceAnalysis>& analyses) {
+    const std::string& name = source.getFrameName();
+
+    if (jsonl) {
+        out << "{\"frame\":" << index << ",\"name\":\"" << jsonEscape(name) << "\",\"faces\":[";
+        for (size_t i = 0; i < faces.size() && i < analyses.size(); ++i) {
+            const FaceAnalysis& a = analyses[i];
+            const cv::Rect& b = faces[i].bbox;
+            out << (i ? "," : "") << "{\"track_id\":" << a.trackId
+                << ",\"bbox\":[" << b.x << "," << b.y << "," << b.width << "," << b.height << "]"
+                << ",\"raw_score\":" << a.rawScore << ",\"liveness_score\":" << a.livenessScore
+                << ",\"adjustment\":" << a.adjustment << ",\"final_score\":" << a.finalScore
+                << ",\"state\":\"" << decisionStateName(a.state) << "\"}";
+        }
+        out << "]}\n";
+        return;
+    }
+
+    if (faces.empty()) {
+        out << index << "," << csvEscape(name) << ",-1,0,0,0,0,,,,,NO_FACE\n";
+        return;
+    }
+    for (size_t i = 0; i < faces.size() && i < analyses.size(); ++i) {
+        const FaceAnalysis& a = analyses[i];
+        const cv::Rect& b = faces[i].bbox;
+        out << index << "," << csvEscape(name) << "," << a.trackId << ","
+            << b.x << "," << b.y << "," << b.width << "," << b.height << ","
+            << a.rawScore << "," << a.livenessScore << "," << a.adjustment << ","
+            << a.finalScore << "," << decisionStateName(a.state) << "\n";
+    }
+}
+
+void OfflineRunner::printReport(long frames, double seconds) {
+    std::cout << "[Offline] Frames: " << frames << " in " << std::fixed << std::setprecision(2)
+              << seconds << " s -> " << (seconds > 0 ? frames / seconds : 0.0) << " FPS" << std::endl;
+    std::cout << "[Offline] Stage        mean      p50      p95      p99   (ms)" << std::endl;
+
+    struct Row { const char* name; LatencyStats* stats; };
+    Row rows[] = {
+        {"decode  ", &decodeStats}, {"detect  ", &detectStats}, {"liveness", &livenessStats},
+        {"quality ", &qualityStats}, {"total   ", &totalStats}
+    };
+    for (const Row& r : rows) {
+        std::cout << "[Offline]   " << r.name << std::setw(9) << r.stats->mean()
+                  << std::setw(9) << r.stats->percentile(50) << std::setw(9) << r.stats->percentile(95)
+                  << std::setw(9) << r.stats->percentile(99) << std::endl;
+    }
+    if (detector.isTrackingEnabled()) {
+        std::cout << "[Offline] YuNet runs: " << detector.getDetectorRuns() << "/" << detector.getFrameCount() << std::endl;
+    }
+    analyzer.getCascade().printStats("[Offline]");
+    if (analyzer.getArena()) analyzer.getArena()->printStats("[Offline]");
+    if (AllocationCounter::enabled() && steadyFrames > 0) {
+        std::ostream& os = steadyAllocations > 0 ? std::cerr : std::cout;
+        os << "[Offline] " << (steadyAllocations > 0 ? "WARN" : "INFO") << ": " << steadyAllocations
+           << " heap allocations in analyze() over " << steadyFrames << " steady-state frames" << std::endl;
+    }
+    std::cout << "[Offline] Peak RSS: " << peakRssMb() << " MB" << std::endl;
+}
@@ -0,0 +1,194 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/pipeline.cpp (Multi-threaded staged pipeline)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "pipeline.h"
+#include "display_renderer.h"
+#include <algorithm>
+#include <csignal>
+#include <iostream>
+
+namespace {
+std::atomic<bool> interruptRequested(false);
+
+void onInterrupt(int) {
+    interruptRequested = true;
+}
+
+void printQueue(const char* name, const QueueCounters& c) {
+    std::cout << "  " << name << ": depth=" << c.depth << " max=" << c.maxDepth
+              << " pushed=" << c.pushed << " popped=" << c.popped
+              << " dropped=" << c.dropped << std::endl;
+}
+}
+
+Pipeline::Pipeline(Layer1Capture& camera, Layer2Detection& detector,
+                   Layer3Liveness& liveness, Layer4Hybrid& hybrid)
+    : camera(camera), detector(detector), analyzer(liveness, hybrid), baseKeyframeInterval(1),
+      running(false), resetRequested(false), livenessDone(false), processed(0) {}
+
+Pipeline::~Pipeline() {
+    stop();
+    join();
+}
+
+void Pipeline::run(const PipelineConfig& cfg) {
+    config = cfg;
+    analyzer.setMinFaceWidth(camera.getMinFaceWidth());
+    analyzer.setExecutor(config.executor);
+    analyzer.setCascade(config.cascade);
+    if (config.arenaBytes > 0) analyzer.enableArena(config.arenaBytes);
+    analyzer.reset();
+    governor.setConfig(config.qos);
+    baseKeyframeInterval = detector.isTrackingEnabled() ? detector.getTrackingConfig().maxInterval : 1;
+    if (governor.isEnabled()) {
+        applyDetectLevel(0);   // stage threads not running yet
+        applyLivenessLevel(0);
+        std::cout << "[Pipeline] INFO: QoS target p95 " << config.qos.targetP95Ms << " ms, "
+                  << governor.getLevelCount() << " levels" << std::endl;
+    }
+
+    captureToDetect.reset(new SpscRing<FrameSlot>(config.queueCapacity, config.dropPolicy));
+    detectToLiveness.reset(new SpscRing<FrameSlot>(config.queueCapacity, config.dropPolicy));
+
+    display.reset();
+    if (!config.headless) {
+        display.reset(new DisplayRenderer());
+        if (!display->start(config.windowName, camera.getDisplaySize())) {
+            std::cerr << "[Pipeline] WARN: Display unavailable, running headless" << std::endl;
+            display.reset();
+        }
+    }
+    if (!display) std::cout << "[Pipeline] INFO: Headless, Ctrl+C to stop" << std::endl;
+
+    interruptRequested = false;
+    std::signal(SIGINT, onInterrupt);
+
+    running = true;
+    livenessDone = false;
+    processed = 0;
+    captureThread = std::thread(&Pipeline::captureLoop, this);
+    detectThread = std::thread(&Pipeline::detectLoop, this);
+    livenessThread = std::thread(&Pipeline::livenessLoop, this);
+
+    // Supervisor only: keys come from the render thread, stats from the counters
+    uint64_t nextStats = config.statsIntervalFrames > 0 ? (uint64_t)config.statsIntervalFrames : 0;
+    while (running && !livenessDone && !interruptRequested) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (display) {
+            if (display->isQuitRequested()) break;
+            if (display->takeResetRequest()) resetRequested = true;
+        }
+        if (nextStats > 0 && processed.load(std::memory_order_relaxed) >= nextStats) {
+            printStats();
+            nextStats += (uint64_t)config.statsIntervalFrames;
+        }
+    }
+
+    stop();
+    join();
+    std::signal(SIGINT, SIG_DFL);
+}
+
+void Pipeline::stop() {
+    running = false;
+    if (captureToDetect) captureToDetect->close();
+    if (detectToLiveness) detectToLiveness->close();
+}
+
+void Pipeline::join() {
+    if (captureThread.joinable()) captureThread.join();
+    if (detectThread.joinable()) detectThread.join();
+    if (livenessThread.joinable()) livenessThread.join();
+    if (display) display->stop();
+}
+
+void Pipeline::printStats() const {
+    if (!captureToDetect) return;
+    std::cout << "[Pipeline] Queue stats:" << std::endl;
+    printQueue("capture->detect ", captureToDetect->counters());
+    printQueue("detect->liveness", detectToLiveness->counters());
+    if (display) {
+        printQueue("liveness->display", display->counters());
+        std::cout << "  Frames shown: " << display->getShown() << std::endl;
+    }
+    if (detector.isTrackingEnabled()) {
+        std::cout << "  YuNet runs: " << detector.getDetectorRuns() << "/" << detector.getFrameCount()
+                  << " frames" << std::endl;
+    }
+    analyzer.getCascade().printStats("[Pipeline]");
+    governor.printStats("[Pipeline]");
+    if (analyzer.getArena()) analyzer.getArena()->printStats("[Pipeline]");
+}
+
+void Pipeline::captureLoop() {
+    FrameSlot slot;
+    uint64_t seq = 0;
+    while (running) {
+        if (!camera.grabFrame(slot.frame)) break;
+        slot.seq = seq++;
+        slot.captureTime = std::chrono::steady_clock::now();
+        if (!captureToDetect->push(slot) && captureToDetect->isClosed()) break;
+    }
+    captureToDetect->close();
+}
+
+void Pipeline::applyDetectLevel(int level) {
+    const QosLevel& qos = governor.getLevelConfig(level);
+    detector.setMaxInputWidth(qos.detectInputWidth);
+    detector.setKeyframeInterval(std::max(baseKeyframeInterval, qos.keyframeInterval));
+}
+
+void Pipeline::applyLivenessLevel(int level) {
+    const QosLevel& qos = governor.getLevelConfig(level);
+    analyzer.setCueMask(qos.cueMask);
+    analyzer.setModelLimit(qos.livenessModels);
+}
+
+void Pipeline::detectLoop() {
+    FrameSlot slot;
+    int qosLevel = 0;
+    while (captureToDetect->pop(slot)) {
+        if (governor.isEnabled() && governor.getLevel() != qosLevel) {
+            qosLevel = governor.getLevel();
+            applyDetectLevel(qosLevel);
+        }
+        {
+            FACE_SCOPED_TIMER(MetricStage::DETECT);
+            detector.detectTracked(slot.frame, slot.faces);
+        }
+        if (!detectToLiveness->push(slot) && detectToLiveness->isClosed()) break;
+    }
+    detectToLiveness->close();
+}
+
+void Pipeline::livenessLoop() {
+    FrameSlot slot;
+    bool firstDecision = config.startTime != std::chrono::steady_clock::time_point();
+
+    while (detectToLiveness->pop(slot)) {
+        if (resetRequested.exchange(false)) {
+            analyzer.manualReset();
+            std::cout << "[main] Manual reset triggered" << std::endl;
+        }
+
+        analyzer.analyze(slot.frame, slot.faces, slot.analyses);
+        if (governor.isEnabled()) {
+            std::chrono::duration<double, std::milli> latency = std::chrono::steady_clock::now() - slot.captureTime;
+            if (governor.observe(latency.count())) applyLivenessLevel(governor.getLevel());
+        }
+        if (firstDecision) {
+            firstDecision = false;
+            std::cout << "[Pipeline] INFO: First decision "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - config.startTime).count()
+                      << " ms after start" << std::endl;
+        }
+        processed.fetch_add(1, std::memory_order_relaxed);
+        if (config.events) config.events->publishFrame(-1, slot.seq, slot.captureTime, slot.faces, slot.analyses);
+
+        // Newest wins: an unshown frame is overwritten, detection never waits on the window
+        if (display) display->publish(slot);
+    }
+    livenessDone = true;
+}
@@ -0,0 +1,117 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/qos_governor.cpp (Latency SLO governor, graceful degradation)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "qos_governor.h"
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include "layer4_hybrid.h"
+
+QosGovernor::QosGovernor()
+    : level(0), filled(0), calmWindows(0), lastP95(0.0), transitions(0), degrades(0) {
+    setConfig(QosConfig());
+}
+
+void QosGovernor::setConfig(const QosConfig& cfg) {
+    config = cfg;
+    if (config.levels.empty()) config.levels = defaultLevels();
+    config.windowFrames = std::max(5, config.windowFrames);
+    config.recoverWindows = std::max(1, config.recoverWindows);
+    config.recoverRatio = std::min(1.0, std::max(0.1, config.recoverRatio));
+
+    window.assign(config.windowFrames, 0.0);
+    sorted.assign(config.windowFrames, 0.0);
+    framesAtLevel = std::vector<std::atomic<uint64_t>>(config.levels.size());
+    for (std::atomic<uint64_t>& frames : framesAtLevel) frames.store(0, std::memory_order_relaxed);
+    filled = 0;
+    calmWindows = 0;
+    lastP95.store(0.0, std::memory_order_relaxed);
+    transitions.store(0, std::memory_order_relaxed);
+    degrades.store(0, std::memory_order_relaxed);
+    level.store(0, std::memory_order_release);
+}
+
+std::vector<QosLevel> QosGovernor::defaultLevels() {
+    const unsigned cheap = Layer4Hybrid::cueBit(Layer4Hybrid::CUE_COLOR) |
+                           Layer4Hybrid::cueBit(Layer4Hybrid::CUE_EDGES);
+    std::vector<QosLevel> levels(4);
+    // 0: as configured
+    levels[1].detectInputWidth = 640;
+    levels[1].keyframeInterval = 2;
+    levels[2].detectInputWidth = 480;
+    levels[2].cueMask = cheap;
+    levels[2].keyframeInterval = 4;
+    levels[3].detectInputWidth = 320;
+    levels[3].cueMask = cheap;
+    levels[3].livenessModels = 1;
+    levels[3].keyframeInterval = 8;
+    return levels;
+}
+
+std::string QosGovernor::describe(const QosLevel& lvl) {
+    char cues[8];
+    std::snprintf(cues, sizeof(cues), "0x%02x", lvl.cueMask & ((1u << Layer4Hybrid::CUE_COUNT) - 1));
+    return "detect " + (lvl.detectInputWidth > 0 ? std::to_string(lvl.detectInputWidth) + " px" : std::string("full")) +
+           ", cues " + cues +
+           ", models " + (lvl.livenessModels > 0 ? std::to_string(lvl.livenessModels) : std::string("all")) +
+           ", keyframe " + (lvl.keyframeInterval > 0 ? std::to_string(lvl.keyframeInterval) : std::string("default"));
+}
+
+bool QosGovernor::observe(double latencyMs) {
+    if (!config.enabled) return false;
+    framesAtLevel[getLevel()].fetch_add(1, std::memory_order_relaxed);
+    window[filled++] = latencyMs;
+    if (filled < config.windowFrames) return false;
+    filled = 0;
+
+    // p95 of the window (nth_element on a copy, no allocation)
+    std::copy(window.begin(), window.end(), sorted.begin());
+    const size_t idx = std::min(sorted.size() - 1, (size_t)(0.95 * sorted.size()));
+    std::nth_element(sorted.begin(), sorted.begin() + idx, sorted.end());
+    const double p95 = sorted[idx];
+    lastP95.store(p95, std::memory_order_relaxed);
+
+    const int current = getLevel();
+    if (p95 > config.targetP95Ms) {
+        calmWindows = 0;
+        if (current + 1 < getLevelCount()) {
+            moveTo(current + 1, p95);
+            return true;
+        }
+        return false;
+    }
+    if (p95 < config.targetP95Ms * config.recoverRatio && current > 0) {
+        if (++calmWindows >= config.recoverWindows) {
+            calmWindows = 0;
+            moveTo(current - 1, p95);
+            return true;
+        }
+    } else {
+        calmWindows = 0;
+    }
+    return false;
+}
+
+void QosGovernor::moveTo(int next, double p95) {
+    const int previous = getLevel();
+    level.store(next, std::memory_order_release);
+    transitions.fetch_add(1, std::memory_order_relaxed);
+    if (next > previous) degrades.fetch_add(1, std::memory_order_relaxed);
+    std::cout << "[QoS] INFO: p95 " << std::fixed << std::setprecision(1) << p95 << " ms "
+              << (next > previous ? ">" : "<") << " " << (next > previous ? config.targetP95Ms : config.targetP95Ms * config.recoverRatio)
+              << " ms, level " << previous << " -> " << next << " ("
+              << describe(config.levels[next]) << ")" << std::endl;
+}
+
+void QosGovernor::printStats(const char* tag) const {
+    if (!config.enabled) return;
+    std::cout << tag << " QoS: level " << getLevel() << "/" << getLevelCount() - 1 << std::fixed << std::setprecision(1)
+              << ", last p95 " << lastP95.load(std::memory_order_relaxed) << " ms (target " << config.targetP95Ms << " ms)"
+              << ", transitions " << getTransitions() << " (" << degrades.load(std::memory_order_relaxed) << " down)"
+              << ", frames per level";
+    for (const std::atomic<uint64_t>& frames : framesAtLevel) std::cout << " " << frames.load(std::memory_order_relaxed);
+    std::cout << std::endl;
+}
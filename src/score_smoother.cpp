@@ -0,0 +1,73 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/score_smoother.cpp (Per-track liveness score smoothing)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "score_smoother.h"
+#include <algorithm>
+#include <cmath>
+
+bool parseSmoothingPolicy(const std::string& text, SmoothingPolicy& policy) {
+    if (text == "weighted") { policy = SmoothingPolicy::WEIGHTED_WINDOW; return true; }
+    if (text == "ema")      { policy = SmoothingPolicy::EMA; return true; }
+    if (text == "median")   { policy = SmoothingPolicy::MEDIAN; return true; }
+    return false;
+}
+
+void ScoreHistory::push(float value) {
+    if (count == 0) ema = value;   // a fresh history restarts the EMA
+    if (count < capacity) {
+        values[(start + count) & (capacity - 1)] = value;
+        count++;
+    } else {
+        values[start] = value;
+        start = (start + 1) & (capacity - 1);
+    }
+}
+
+ScoreSmoother::ScoreSmoother(const SmoothingConfig& cfg) {
+    // w_i = 1.8^(i / n), normalised per fill level n
+    for (int n = 1; n <= ScoreHistory::capacity; ++n) {
+        float sum = 0.0f;
+        for (int i = 0; i < n; ++i) {
+            weights[n - 1][i] = std::pow(1.8f, (float)i / n);
+            sum += weights[n - 1][i];
+        }
+        for (int i = 0; i < n; ++i) weights[n - 1][i] /= sum;
+        for (int i = n; i < ScoreHistory::capacity; ++i) weights[n - 1][i] = 0.0f;
+    }
+    setConfig(cfg);
+}
+
+void ScoreSmoother::setConfig(const SmoothingConfig& cfg) {
+    config = cfg;
+    config.emaAlpha = std::max(0.01f, std::min(1.0f, config.emaAlpha));
+    config.medianWindow = std::max(1, std::min(ScoreHistory::capacity, config.medianWindow));
+}
+
+float ScoreSmoother::smooth(ScoreHistory& history) const {
+    const int n = history.count;
+    if (n <= 0) return 0.0f;
+    const float newest = history.at(n - 1);
+
+    switch (config.policy) {
+        case SmoothingPolicy::EMA:
+            if (n > 1) history.ema += config.emaAlpha * (newest - history.ema);
+            return history.ema;
+
+        case SmoothingPolicy::MEDIAN: {
+            const int k = std::min(n, config.medianWindow);
+            float window[ScoreHistory::capacity];
+            for (int i = 0; i < k; ++i) window[i] = history.at(n - k + i);
+            std::sort(window, window + k);
+            return (k & 1) ? window[k / 2] : 0.5f * (window[k / 2 - 1] + window[k / 2]);
+        }
+
+        default: {
+            const float* w = weights[n - 1];
+            float sum = 0.0f;
+            for (int i = 0; i < n; ++i) sum += history.at(i) * w[i];
+            return sum;
+        }
+    }
+}
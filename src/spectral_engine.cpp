@@ -0,0 +1,141 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/spectral_engine.cpp (Real-input DFT spectral features)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "spectral_engine.h"
+#include <cmath>
+#include "frame_arena.h"
+
+namespace {
+// Signed frequency of DFT index k, same convention as the old quadrant swap
+inline int signedFreq(int k, int n) {
+    return k < n / 2 ? k : k - n;
+}
+}
+
+SpectralEngine::SpectralEngine(int side) : side(std::max(8, side & ~1)) {
+    halfCols = this->side / 2 + 1;
+    buildTables();
+}
+
+void SpectralEngine::bindScratch(FrameArena& arena) {
+    arena.bind(resized);
+    arena.bind(gray);
+    arena.bind(input);
+    arena.bind(spectrum);
+    arena.bind(halfLogMag);
+}
+
+void SpectralEngine::buildTables() {
+    const int n = side;
+    // Old mask: centre rectangle [c - m, c + m) on the shifted spectrum
+    const int m = n / 6;
+    auto inHigh = [&](int u, int v) {
+        int fy = signedFreq(u, n), fx = signedFreq(v, n);
+        return !(fy >= -m && fy < m && fx >= -m && fx < m);
+    };
+    const float bandEdges[SpectralFeatures::numBands - 1] = {0.125f, 0.25f, 0.5f};
+
+    highWeights.create(n, halfCols, CV_32F);
+    multiplicity.create(n, halfCols, CV_32F);
+    bandIndex.create(n, halfCols, CV_8U);
+    highCount = 0.0;
+    for (int b = 0; b < SpectralFeatures::numBands; ++b) bandCount[b] = 0.0;
+
+    for (int u = 0; u < n; ++u) {
+        float* w = highWeights.ptr<float>(u);
+        float* mult = multiplicity.ptr<float>(u);
+        uchar* band = bandIndex.ptr<uchar>(u);
+        for (int v = 0; v < halfCols; ++v) {
+            // Columns 0 and n/2 are stored for every row, the rest also stand for
+            // their conjugate mirror (n - u, n - v) on the other half
+            bool selfMirrored = (v == 0 || v == n / 2);
+            float count = inHigh(u, v) ? 1.0f : 0.0f;
+            if (!selfMirrored && inHigh((n - u) % n, n - v)) count += 1.0f;
+            w[v] = count;
+            mult[v] = selfMirrored ? 1.0f : 2.0f;
+
+            float fy = (float)signedFreq(u, n), fx = (float)signedFreq(v, n);
+            float radius = std::sqrt(fx * fx + fy * fy) / (n / 2);
+            int b = 0;
+            while (b < SpectralFeatures::numBands - 1 && radius >= bandEdges[b]) b++;
+            band[v] = (uchar)b;
+
+            highCount += count;
+            bandCount[b] += mult[v];
+        }
+    }
+}
+
+void SpectralEngine::unpackMagnitude() {
+    // CCS layout (n even): columns 0 and n-1 hold the real 1D spectra of
+    // frequency columns 0 and n/2 down the rows, columns 1..n-2 hold Re/Im pairs
+    const int n = side;
+    const int h = n / 2;
+    for (int u = 0; u < n; ++u) {
+        const float* row = spectrum.ptr<float>(u);
+        float* out = halfLogMag.ptr<float>(u);
+        for (int v = 1; v < h; ++v) {
+            float re = row[2 * v - 1], im = row[2 * v];
+            out[v] = std::sqrt(re * re + im * im);
+        }
+    }
+    const int edgeCols[2] = {0, n - 1};
+    for (int e = 0; e < 2; ++e) {
+        int c = edgeCols[e];
+        int v = e == 0 ? 0 : h;
+        halfLogMag.at<float>(0, v) = std::abs(spectrum.at<float>(0, c));
+        halfLogMag.at<float>(h, v) = std::abs(spectrum.at<float>(n - 1, c));
+        for (int u = 1; u < h; ++u) {
+            float re = spectrum.at<float>(2 * u - 1, c);
+            float im = spectrum.at<float>(2 * u, c);
+            float mag = std::sqrt(re * re + im * im);
+            halfLogMag.at<float>(u, v) = mag;
+            halfLogMag.at<float>(n - u, v) = mag;
+        }
+    }
+}
+
+bool SpectralEngine::compute(const cv::Mat& src, SpectralFeatures& out) {
+    if (src.empty()) return false;
+
+    // src may be a cache-owned grey patch: never resize/convert into it
+    cv::Mat sized = src;
+    if (sized.size() != cv::Size(side, side)) {
+        AllocationCounter::Exclude opencvScratch;
+        cv::resize(src, resized, cv::Size(side, side));
+        sized = resized;
+    }
+    if (sized.channels() == 3) {
+        cv::cvtColor(sized, gray, cv::COLOR_BGR2GRAY);
+        sized = gray;
+    }
+    sized.convertTo(input, CV_32F);
+
+    // Real input without DFT_COMPLEX_OUTPUT -> CCS packed, same size as input
+    {
+        AllocationCounter::Exclude opencvScratch;
+        cv::dft(input, spectrum);
+    }
+    // Filled by hand, not by an OpenCV call: a bound arena header is empty after every reset()
+    halfLogMag.create(side, halfCols, CV_32F);
+    unpackMagnitude();
+
+    halfLogMag += cv::Scalar::all(1);
+    cv::log(halfLogMag, halfLogMag);
+
+    out.highFreqMean = highCount > 0 ? highWeights.dot(halfLogMag) / highCount : 0.0;
+
+    double sums[SpectralFeatures::numBands] = {0, 0, 0, 0};
+    for (int u = 0; u < side; ++u) {
+        const float* lm = halfLogMag.ptr<float>(u);
+        const float* mult = multiplicity.ptr<float>(u);
+        const uchar* band = bandIndex.ptr<uchar>(u);
+        for (int v = 0; v < halfCols; ++v) sums[band[v]] += lm[v] * mult[v];
+    }
+    for (int b = 0; b < SpectralFeatures::numBands; ++b) {
+        out.bands[b] = bandCount[b] > 0 ? (float)(sums[b] / bandCount[b]) : 0.0f;
+    }
+    return true;
+}
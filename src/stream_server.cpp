@@ -0,0 +1,275 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/stream_server.cpp (Multi-camera server, shared workers)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "stream_server.h"
+#include <algorithm>
+#include <cctype>
+#include <csignal>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+std::atomic<bool> interruptRequested(false);
+
+void onInterrupt(int) {
+    interruptRequested = true;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+bool isCameraIndex(const std::string& source) {
+    return !source.empty() && std::all_of(source.begin(), source.end(),
+                                          [](char c) { return std::isdigit((unsigned char)c); });
+}
+}
+
+StreamServer::StreamServer() : running(false), cursor(0) {}
+
+StreamServer::~StreamServer() {
+    stop();
+    for (auto& stream : streams) {
+        if (stream->captureThread.joinable()) stream->captureThread.join();
+    }
+    for (auto& worker : workers) {
+        if (worker->thread.joinable()) worker->thread.join();
+    }
+}
+
+bool StreamServer::openStream(Stream& stream) {
+    const std::string& source = stream.source;
+    if (source.rfind("/dev/video", 0) == 0) {
+        V4L2Config v4l2;
+        v4l2.device = source;
+        return stream.camera.initV4L2(v4l2);
+    }
+    if (isCameraIndex(source)) return stream.camera.init(std::atoi(source.c_str()));
+    return stream.camera.openSource(source);
+}
+
+bool StreamServer::init(const StreamServerConfig& cfg) {
+    config = cfg;
+    if (config.sources.empty()) {
+        std::cerr << "[Server] ERROR: No stream sources" << std::endl;
+        return false;
+    }
+    config.workers = std::max(1, config.workers);
+    config.maxBatchStreams = std::max(1, config.maxBatchStreams);
+
+    for (size_t i = 0; i < config.sources.size(); ++i) {
+        std::unique_ptr<Stream> stream(new Stream());
+        stream->index = (int)i;
+        stream->source = config.sources[i];
+        if (!openStream(*stream)) {
+            std::cerr << "[Server] ERROR: Cannot open stream " << i << " (" << stream->source << ")" << std::endl;
+            return false;
+        }
+        stream->analyzer.setMinFaceWidth(stream->camera.getMinFaceWidth());
+        stream->queue.reset(new SpscRing<FrameSlot>(config.queueCapacity, config.dropPolicy));
+        streams.push_back(std::move(stream));
+    }
+
+    for (int w = 0; w < config.workers; ++w) {
+        std::unique_ptr<Worker> worker(new Worker());
+        worker->detector.setBackend(config.backend);
+        worker->liveness.setBackend(config.backend);
+        worker->liveness.setSmoothing(config.smoothing);
+        worker->detector.setModelBundle(config.bundle);
+        worker->liveness.setModelBundle(config.bundle);
+        if (!worker->detector.init(config.detectorPath) || !worker->liveness.init(config.models)) {
+            std::cerr << "[Server] ERROR: Worker " << w << " model init failed" << std::endl;
+            return false;
+        }
+        worker->liveness.warmUp(config.maxBatchStreams);
+        if (config.arenaBytes > 0) {
+            worker->arena.reset(new FrameArena(config.arenaBytes));
+            worker->liveness.bindScratch(*worker->arena);
+            worker->hybrid.bindScratch(*worker->arena);
+        }
+        workers.push_back(std::move(worker));
+    }
+
+    // Parallelism comes from the workers; OpenCV's own pool on top of them oversubscribes
+    if (config.workers > 1) cv::setNumThreads(1);
+
+    std::cout << "[Server] INFO: " << streams.size() << " streams, " << workers.size()
+              << " workers, batch up to " << config.maxBatchStreams << " streams" << std::endl;
+    return true;
+}
+
+void StreamServer::run() {
+    interruptRequested = false;
+    std::signal(SIGINT, onInterrupt);
+
+    running = true;
+    startTime = std::chrono::steady_clock::now();
+    windowStart = startTime;
+    for (auto& stream : streams) {
+        stream->captureThread = std::thread(&StreamServer::captureLoop, this, std::ref(*stream));
+    }
+    for (auto& worker : workers) {
+        worker->thread = std::thread(&StreamServer::workerLoop, this, std::ref(*worker));
+    }
+
+    while (running && !interruptRequested) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        bool allDone = true;
+        for (auto& stream : streams) {
+            if (!stream->ended || stream->queue->depth() > 0 || stream->claimed) allDone = false;
+        }
+        if (allDone) break;
+        if (config.statsIntervalSec > 0 &&
+            elapsedMs(windowStart) >= config.statsIntervalSec * 1000.0) {
+            printStats(false);
+        }
+    }
+
+    stop();
+    for (auto& stream : streams) {
+        if (stream->captureThread.joinable()) stream->captureThread.join();
+    }
+    for (auto& worker : workers) {
+        if (worker->thread.joinable()) worker->thread.join();
+    }
+    std::signal(SIGINT, SIG_DFL);
+    printStats(true);
+}
+
+void StreamServer::stop() {
+    running = false;
+    for (auto& stream : streams) {
+        if (stream->queue) stream->queue->close();
+    }
+}
+
+void StreamServer::captureLoop(Stream& stream) {
+    FrameSlot slot;
+    uint64_t seq = 0;
+    while (running) {
+        if (config.maxFrames >= 0 && (long)seq >= config.maxFrames) break;
+        if (!stream.camera.grabFrame(slot.frame)) break;
+        slot.seq = seq++;
+        slot.captureTime = std::chrono::steady_clock::now();
+        if (!stream.queue->push(slot) && stream.queue->isClosed()) break;
+    }
+    stream.ended = true;
+}
+
+// Claims up to maxBatchStreams streams that have a frame waiting, starting at a
+// rotating index so every stream gets its turn
+bool StreamServer::claimBatch(Worker& worker) {
+    worker.batch.clear();
+    const size_t count = streams.size();
+    const size_t start = cursor.fetch_add(1, std::memory_order_relaxed) % count;
+    for (size_t n = 0; n < count && (int)worker.batch.size() < config.maxBatchStreams; ++n) {
+        Stream& stream = *streams[(start + n) % count];
+        if (stream.queue->depth() == 0) continue;
+        bool expected = false;
+        if (!stream.claimed.compare_exchange_strong(expected, true, std::memory_order_acquire)) continue;
+        if (stream.queue->tryPop(stream.work)) {
+            worker.batch.push_back(&stream);
+        } else {
+            stream.claimed.store(false, std::memory_order_release);
+        }
+    }
+    return !worker.batch.empty();
+}
+
+void StreamServer::workerLoop(Worker& worker) {
+    while (running) {
+        if (!claimBatch(worker)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+            continue;
+        }
+        scoreBatch(worker);
+    }
+}
+
+void StreamServer::scoreBatch(Worker& worker) {
+    worker.frames.clear();
+    worker.frameOf.clear();
+    worker.boxes.clear();
+    worker.states.clear();
+
+    // Detection per frame, then every face of every claimed stream in one Layer3 batch,
+    // all of it under one DecisionParams snapshot
+    const DecisionParams& params = DecisionParams::current();
+    for (size_t k = 0; k < worker.batch.size(); ++k) {
+        Stream& stream = *worker.batch[k];
+        FrameSlot& slot = stream.work;
+        {
+            FACE_SCOPED_TIMER(MetricStage::DETECT);
+            worker.detector.detectAll(slot.frame.bgr(), slot.faces);
+        }
+        stream.analyzer.prepare(slot.faces, slot.analyses, params);
+
+        worker.frames.push_back(&slot.frame);
+        const std::vector<cv::Rect>& boxes = stream.analyzer.getPendingBoxes();
+        const std::vector<LivenessTrackState*>& states = stream.analyzer.getPendingStates();
+        worker.boxes.insert(worker.boxes.end(), boxes.begin(), boxes.end());
+        worker.states.insert(worker.states.end(), states.begin(), states.end());
+        worker.frameOf.insert(worker.frameOf.end(), boxes.size(), (int)k);
+    }
+
+    if (!worker.boxes.empty()) {
+        worker.liveness.checkLivenessBatch(worker.frames, worker.frameOf, worker.boxes,
+                                           worker.states, worker.results, params);
+    }
+
+    size_t offset = 0;
+    for (Stream* stream : worker.batch) {
+        FrameSlot& slot = stream->work;
+        stream->analyzer.finish(slot.frame, slot.faces, worker.results.data() + offset,
+                                worker.hybrid, slot.analyses);
+        offset += stream->analyzer.getPendingBoxes().size();
+        if (config.events) {
+            config.events->publishFrame(stream->index, slot.seq, slot.captureTime, slot.faces, slot.analyses);
+        }
+
+        double latency = elapsedMs(slot.captureTime);
+        {
+            std::lock_guard<std::mutex> lock(stream->statsMutex);
+            stream->windowLatency.add(latency);
+            stream->totalLatency.add(latency);
+            stream->windowFrames++;
+            stream->totalFrames++;
+            stream->totalFaces += slot.faces.size();
+        }
+        slot.frame.release();   // hand pooled / mmap buffers back to the capture side
+        stream->claimed.store(false, std::memory_order_release);
+    }
+    if (worker.arena) worker.arena->reset();
+}
+
+void StreamServer::printStats(bool final) {
+    double seconds = (final ? elapsedMs(startTime) : elapsedMs(windowStart)) / 1000.0;
+    windowStart = std::chrono::steady_clock::now();
+    if (seconds <= 0.0) return;
+
+    std::cout << "[Server] " << (final ? "Final" : "Window") << " stats (" << std::fixed
+              << std::setprecision(1) << seconds << " s):" << std::endl;
+    for (auto& stream : streams) {
+        std::lock_guard<std::mutex> lock(stream->statsMutex);
+        LatencyStats& latency = final ? stream->totalLatency : stream->windowLatency;
+        uint64_t frames = final ? stream->totalFrames : stream->windowFrames;
+        QueueCounters q = stream->queue->counters();
+        std::cout << "  #" << stream->index << " " << stream->source
+                  << ": " << std::setprecision(1) << frames / seconds << " FPS"
+                  << ", latency p50 " << latency.percentile(50)
+                  << " / p95 " << latency.percentile(95) << " ms"
+                  << ", dropped " << q.dropped;
+        if (final) std::cout << ", faces " << stream->totalFaces;
+        std::cout << std::endl;
+        stream->windowLatency = LatencyStats();
+        stream->windowFrames = 0;
+    }
+    if (!final) return;
+    for (size_t w = 0; w < workers.size(); ++w) {
+        if (!workers[w]->arena) continue;
+        std::string tag = "  worker " + std::to_string(w) + ":";
+        workers[w]->arena->printStats(tag.c_str());
+    }
+}
@@ -0,0 +1,175 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/task_pool.cpp (Work-stealing pool + task graph)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "task_pool.h"
+#include <algorithm>
+
+namespace {
+// Which pool / worker the current thread belongs to (-1 = outside thread)
+thread_local const WorkStealingPool* tlsPool = nullptr;
+thread_local int tlsWorker = -1;
+}
+
+WorkStealingPool::WorkStealingPool(int threadCount) : stopping(false), queued(0), blockedWaiters(0) {
+    if (threadCount <= 0) {
+        threadCount = defaultThreads();
+    }
+    for (int i = 0; i <= threadCount; ++i) queues.emplace_back(new Queue());
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : threads) {
+        if (t.joinable()) t.join();
+    }
+}
+
+int WorkStealingPool::defaultThreads() {
+    // Half the cores: OpenCV's own pool (resize, cvtColor, dnn) gets the other half
+    return std::max(1, (int)std::thread::hardware_concurrency() / 2);
+}
+
+int WorkStealingPool::currentWorker() const {
+    return tlsPool == this ? tlsWorker : -1;
+}
+
+void WorkStealingPool::spawn(TaskGroup& group, TaskFn fn, void* ctx, int arg) {
+    group.pending.fetch_add(1, std::memory_order_relaxed);
+    int self = currentWorker();
+    Queue& queue = *queues[self >= 0 ? self : (int)threads.size()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(Task{fn, ctx, arg, &group});
+    }
+    queued.fetch_add(1, std::memory_order_release);
+    // Under the lock: a worker / waiter between its predicate check and its
+    // wait() cannot miss this
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    wake.notify_one();
+    if (blockedWaiters > 0) idle.notify_all();
+}
+
+bool WorkStealingPool::popLocal(int self, Task& task) {
+    if (self < 0) return false;
+    Queue& queue = *queues[self];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    task = queue.tasks.back();
+    queue.tasks.pop_back();
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool WorkStealingPool::steal(int self, Task& task) {
+    const int count = (int)queues.size();
+    const int start = self >= 0 ? self + 1 : 0;
+    for (int n = 0; n < count; ++n) {
+        int victim = (start + n) % count;
+        if (victim == self) continue;
+        Queue& queue = *queues[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+        task = queue.tasks.front();
+        queue.tasks.pop_front();
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::execute(Task& task) {
+    TaskGroup* group = task.group;
+    task.fn(task.ctx, task.arg);
+    if (group->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        if (blockedWaiters > 0) idle.notify_all();
+    }
+}
+
+void WorkStealingPool::workerLoop(int index) {
+    tlsPool = this;
+    tlsWorker = index;
+    Task task;
+    while (!stopping.load(std::memory_order_acquire)) {
+        if (popLocal(index, task) || steal(index, task)) {
+            execute(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] {
+            return stopping.load(std::memory_order_acquire) || queued.load(std::memory_order_acquire) > 0;
+        });
+    }
+}
+
+void WorkStealingPool::wait(TaskGroup& group) {
+    int self = currentWorker();
+    Task task;
+    while (group.pending.load(std::memory_order_acquire) > 0) {
+        // Help while there is something to run, sleep while the rest runs elsewhere
+        if (popLocal(self, task) || steal(self, task)) {
+            execute(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        blockedWaiters++;
+        idle.wait(lock, [&] {
+            return group.pending.load(std::memory_order_acquire) == 0 ||
+                   queued.load(std::memory_order_acquire) > 0;
+        });
+        blockedWaiters--;
+    }
+}
+
+// ===== TaskGraph =====
+int TaskGraph::add(TaskFn fn, void* ctx, int arg) {
+    if ((size_t)nodeCount == nodes.size()) nodes.emplace_back();
+    Node& node = nodes[nodeCount];
+    node.fn = fn;
+    node.ctx = ctx;
+    node.arg = arg;
+    node.dependencies = 0;
+    node.successors.clear();
+    return nodeCount++;
+}
+
+void TaskGraph::precede(int before, int after) {
+    nodes[before].successors.push_back(after);
+    nodes[after].dependencies++;
+}
+
+void TaskGraph::runNode(void* ctx, int index) {
+    TaskGraph& graph = *static_cast<TaskGraph*>(ctx);
+    Node& node = graph.nodes[index];
+    node.fn(node.ctx, node.arg);
+    for (int next : node.successors) {
+        if (graph.remaining[next].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            graph.pool->spawn(graph.group, &TaskGraph::runNode, &graph, next);
+        }
+    }
+}
+
+void TaskGraph::run(WorkStealingPool& executor) {
+    if (nodeCount == 0) return;
+    if (remainingCapacity < (size_t)nodeCount) {
+        remainingCapacity = nodes.capacity();
+        remaining.reset(new std::atomic<int>[remainingCapacity]);
+    }
+    for (int i = 0; i < nodeCount; ++i) {
+        remaining[i].store(nodes[i].dependencies, std::memory_order_relaxed);
+    }
+    pool = &executor;
+    for (int i = 0; i < nodeCount; ++i) {
+        if (nodes[i].dependencies == 0) executor.spawn(group, &TaskGraph::runNode, this, i);
+    }
+    executor.wait(group);
+}
@@ -0,0 +1,365 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/v4l2_capture.cpp (Zero-copy V4L2 mmap capture)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "v4l2_capture.h"
+#include <iostream>
+#include <thread>
+#include <cstring>
+#include <cerrno>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <linux/videodev2.h>
+
+namespace {
+int xioctl(int fd, unsigned long request, void* arg) {
+    int r;
+    do {
+        r = ::ioctl(fd, request, arg);
+    } while (r == -1 && errno == EINTR);
+    return r;
+}
+}
+#endif
+
+V4L2Capture::V4L2Capture()
+    : opened(false), fileBacked(false), fd(-1), format(V4L2PixelFormat::YUYV),
+      bytesPerLine(0), bufferCount(0), fileMap(nullptr), fileSize(0), fileFrames(0),
+      fileFrameIndex(0), framePeriod(0) {}
+
+V4L2Capture::~V4L2Capture() {
+    close();
+}
+
+#ifdef __linux__
+
+bool V4L2Capture::open(const V4L2Config& config) {
+    close();
+
+    fd = ::open(config.device.c_str(), O_RDWR | O_NONBLOCK);
+    if (fd < 0) {
+        std::cerr << "[V4L2] ERROR: Cannot open " << config.device << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    v4l2_capability cap;
+    std::memset(&cap, 0, sizeof(cap));
+    if (xioctl(fd, VIDIOC_QUERYCAP, &cap) < 0) {
+        std::cerr << "[V4L2] ERROR: " << config.device << " is not a V4L2 device" << std::endl;
+        close();
+        return false;
+    }
+    uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+    if (!(caps & V4L2_CAP_VIDEO_CAPTURE) || !(caps & V4L2_CAP_STREAMING)) {
+        std::cerr << "[V4L2] ERROR: " << config.device << " has no streaming capture" << std::endl;
+        close();
+        return false;
+    }
+
+    // MJPEG first when asked (USB bandwidth), the driver answers with what it can do
+    const uint32_t order[2] = {
+        config.preferMjpeg ? (uint32_t)V4L2_PIX_FMT_MJPEG : (uint32_t)V4L2_PIX_FMT_YUYV,
+        config.preferMjpeg ? (uint32_t)V4L2_PIX_FMT_YUYV : (uint32_t)V4L2_PIX_FMT_MJPEG
+    };
+    v4l2_format fmt;
+    bool formatOk = false;
+    for (uint32_t pixfmt : order) {
+        std::memset(&fmt, 0, sizeof(fmt));
+        fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        fmt.fmt.pix.width = config.width;
+        fmt.fmt.pix.height = config.height;
+        fmt.fmt.pix.pixelformat = pixfmt;
+        fmt.fmt.pix.field = V4L2_FIELD_ANY;
+        if (xioctl(fd, VIDIOC_S_FMT, &fmt) == 0 && fmt.fmt.pix.pixelformat == pixfmt) {
+            formatOk = true;
+            break;
+        }
+    }
+    if (!formatOk) {
+        std::cerr << "[V4L2] ERROR: Neither MJPEG nor YUYV accepted by " << config.device << std::endl;
+        close();
+        return false;
+    }
+    format = fmt.fmt.pix.pixelformat == V4L2_PIX_FMT_MJPEG ? V4L2PixelFormat::MJPEG : V4L2PixelFormat::YUYV;
+    frameSize = cv::Size((int)fmt.fmt.pix.width, (int)fmt.fmt.pix.height);
+    bytesPerLine = fmt.fmt.pix.bytesperline ? fmt.fmt.pix.bytesperline : (size_t)frameSize.width * 2;
+
+    v4l2_streamparm parm;
+    std::memset(&parm, 0, sizeof(parm));
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    parm.parm.capture.timeperframe.numerator = 1;
+    parm.parm.capture.timeperframe.denominator = std::max(1, config.fps);
+    if (xioctl(fd, VIDIOC_S_PARM, &parm) < 0) {
+        std::cerr << "[V4L2] WARN: Driver ignored " << config.fps << " fps request" << std::endl;
+    }
+
+    v4l2_requestbuffers req;
+    std::memset(&req, 0, sizeof(req));
+    req.count = std::max(2, config.bufferCount);
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(fd, VIDIOC_REQBUFS, &req) < 0 || req.count < 2) {
+        std::cerr << "[V4L2] ERROR: mmap buffers not available on " << config.device << std::endl;
+        close();
+        return false;
+    }
+
+    bufferCount = (int)req.count;
+    buffers.reset(new Buffer[bufferCount]);
+    for (int i = 0; i < bufferCount; ++i) {
+        v4l2_buffer buf;
+        std::memset(&buf, 0, sizeof(buf));
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        if (xioctl(fd, VIDIOC_QUERYBUF, &buf) < 0) {
+            close();
+            return false;
+        }
+        void* start = ::mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, buf.m.offset);
+        if (start == MAP_FAILED) {
+            std::cerr << "[V4L2] ERROR: mmap failed: " << std::strerror(errno) << std::endl;
+            close();
+            return false;
+        }
+        buffers[i].start = start;
+        buffers[i].length = buf.length;
+        buffers[i].u.reset(new cv::UMatData(this));
+        if (xioctl(fd, VIDIOC_QBUF, &buf) < 0) {
+            close();
+            return false;
+        }
+    }
+
+    v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(fd, VIDIOC_STREAMON, &type) < 0) {
+        std::cerr << "[V4L2] ERROR: STREAMON failed: " << std::strerror(errno) << std::endl;
+        close();
+        return false;
+    }
+
+    opened = true;
+    fileBacked = false;
+    std::cout << "[V4L2] INFO: " << config.device << " " << frameSize.width << "x" << frameSize.height
+              << (format == V4L2PixelFormat::MJPEG ? " MJPEG" : " YUYV")
+              << ", " << bufferCount << " mmap buffers" << std::endl;
+    return true;
+}
+
+bool V4L2Capture::openFile(const std::string& path, int width, int height, int fps) {
+    close();
+
+    int fileFd = ::open(path.c_str(), O_RDONLY);
+    if (fileFd < 0) {
+        std::cerr << "[V4L2] ERROR: Cannot open fake device " << path << std::endl;
+        return false;
+    }
+    struct stat st;
+    const size_t frameBytes = (size_t)width * height * 2;
+    if (::fstat(fileFd, &st) < 0 || frameBytes == 0 || (size_t)st.st_size < frameBytes) {
+        std::cerr << "[V4L2] ERROR: " << path << " holds no " << width << "x" << height << " YUYV frame" << std::endl;
+        ::close(fileFd);
+        return false;
+    }
+    fileSize = (size_t)st.st_size;
+    fileMap = ::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fileFd, 0);
+    ::close(fileFd);
+    if (fileMap == MAP_FAILED) {
+        fileMap = nullptr;
+        std::cerr << "[V4L2] ERROR: mmap failed on " << path << std::endl;
+        return false;
+    }
+
+    format = V4L2PixelFormat::YUYV;
+    frameSize = cv::Size(width, height);
+    bytesPerLine = (size_t)width * 2;
+    fileFrames = fileSize / frameBytes;
+    fileFrameIndex = 0;
+    framePeriod = fps > 0 ? std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                std::chrono::duration<double>(1.0 / fps))
+                          : std::chrono::steady_clock::duration(0);
+    nextFrameTime = std::chrono::steady_clock::now();
+
+    // Same buffer budget as a real driver: a frame held downstream is not reused
+    bufferCount = 4;
+    buffers.reset(new Buffer[bufferCount]);
+    for (int i = 0; i < bufferCount; ++i) buffers[i].u.reset(new cv::UMatData(this));
+
+    opened = true;
+    fileBacked = true;
+    std::cout << "[V4L2] INFO: Fake device " << path << " (" << fileFrames << " YUYV frames "
+              << width << "x" << height << ")" << std::endl;
+    return true;
+}
+
+void V4L2Capture::close() {
+    if (fd >= 0) {
+        v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        if (opened) xioctl(fd, VIDIOC_STREAMOFF, &type);
+    }
+    for (int i = 0; i < bufferCount; ++i) {
+        if (buffers[i].held.load()) {
+            std::cerr << "[V4L2] WARN: Buffer " << i << " still held at close" << std::endl;
+            buffers[i].u.release();
+        }
+        if (!fileBacked && buffers[i].start) ::munmap(buffers[i].start, buffers[i].length);
+    }
+    buffers.reset();
+    bufferCount = 0;
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    if (fileMap) {
+        ::munmap(fileMap, fileSize);
+        fileMap = nullptr;
+    }
+    opened = false;
+    fileBacked = false;
+}
+
+bool V4L2Capture::grabDevice(cv::Mat& raw) {
+    for (;;) {
+        pollfd pfd = {fd, POLLIN, 0};
+        int r = ::poll(&pfd, 1, 2000);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) {
+            // All buffers held downstream also ends up here: nothing is queued to fill
+            std::cerr << "[V4L2] WARN: No frame within 2 s" << std::endl;
+            return false;
+        }
+
+        v4l2_buffer buf;
+        std::memset(&buf, 0, sizeof(buf));
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        if (xioctl(fd, VIDIOC_DQBUF, &buf) < 0) {
+            if (errno == EAGAIN) continue;
+            std::cerr << "[V4L2] ERROR: DQBUF failed: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        int index = (int)buf.index;
+        if (format == V4L2PixelFormat::MJPEG) {
+            wrap(index, raw, 1, (int)buf.bytesused, CV_8UC1, buf.bytesused, buf.bytesused);
+        } else {
+            wrap(index, raw, frameSize.height, frameSize.width, CV_8UC2, bytesPerLine,
+                 bytesPerLine * frameSize.height);
+        }
+        return true;
+    }
+}
+
+bool V4L2Capture::grabFile(cv::Mat& raw) {
+    if (framePeriod.count() > 0) {
+        std::this_thread::sleep_until(nextFrameTime);
+        nextFrameTime = std::max(nextFrameTime + framePeriod, std::chrono::steady_clock::now());
+    }
+
+    // Like DQBUF with every buffer held: wait a little, then give up
+    for (int attempt = 0; attempt < 2000; ++attempt) {
+        for (int i = 0; i < bufferCount; ++i) {
+            // Only this thread grabs, releases from other threads only clear the flag
+            if (buffers[i].held.load()) continue;
+            const size_t frameBytes = bytesPerLine * frameSize.height;
+            buffers[i].start = (uchar*)fileMap + (fileFrameIndex % fileFrames) * frameBytes;
+            buffers[i].length = frameBytes;
+            fileFrameIndex++;
+            wrap(i, raw, frameSize.height, frameSize.width, CV_8UC2, bytesPerLine, frameBytes);
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::cerr << "[V4L2] WARN: Every fake buffer is still held downstream" << std::endl;
+    return false;
+}
+
+void V4L2Capture::requeue(int index) const {
+    if (fileBacked || fd < 0) return;
+    v4l2_buffer buf;
+    std::memset(&buf, 0, sizeof(buf));
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = index;
+    if (xioctl(fd, VIDIOC_QBUF, &buf) < 0) {
+        std::cerr << "[V4L2] WARN: QBUF " << index << " failed: " << std::strerror(errno) << std::endl;
+    }
+}
+
+#else   // !__linux__
+
+bool V4L2Capture::open(const V4L2Config&) {
+    std::cerr << "[V4L2] ERROR: V4L2 capture is Linux only" << std::endl;
+    return false;
+}
+bool V4L2Capture::openFile(const std::string&, int, int, int) {
+    std::cerr << "[V4L2] ERROR: V4L2 capture is Linux only" << std::endl;
+    return false;
+}
+void V4L2Capture::close() { opened = false; }
+bool V4L2Capture::grabDevice(cv::Mat&) { return false; }
+bool V4L2Capture::grabFile(cv::Mat&) { return false; }
+void V4L2Capture::requeue(int) const {}
+
+#endif
+
+bool V4L2Capture::grab(cv::Mat& raw) {
+    raw.release();
+    if (!opened) return false;
+    return fileBacked ? grabFile(raw) : grabDevice(raw);
+}
+
+void V4L2Capture::wrap(int index, cv::Mat& raw, int rows, int cols, int type, size_t step, size_t bytes) {
+    Buffer& buffer = buffers[index];
+    buffer.held.store(true);
+
+    // Header over the mmapped memory, then attach the buffer's UMatData so
+    // cv::Mat refcounting decides when the driver gets it back
+    raw = cv::Mat(rows, cols, type, buffer.start, step);
+    cv::UMatData* u = buffer.u.get();
+    u->data = u->origdata = (uchar*)buffer.start;
+    u->size = bytes;
+    u->refcount = 1;
+    u->urefcount = 0;
+    u->currAllocator = u->prevAllocator = this;
+    raw.u = u;
+    raw.allocator = this;
+}
+
+bool V4L2Capture::toBGR(const cv::Mat& raw, cv::Mat& bgr) const {
+    if (raw.empty()) return false;
+    if (format == V4L2PixelFormat::MJPEG) {
+        cv::imdecode(raw, cv::IMREAD_COLOR, &bgr);
+    } else {
+        cv::cvtColor(raw, bgr, cv::COLOR_YUV2BGR_YUYV);
+    }
+    return !bgr.empty();
+}
+
+cv::UMatData* V4L2Capture::allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                                    cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const {
+    // Only reached if someone create()s into a raw view: hand them ordinary memory
+    return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+}
+
+bool V4L2Capture::allocate(cv::UMatData* data, cv::AccessFlag, cv::UMatUsageFlags) const {
+    return data != nullptr;
+}
+
+void V4L2Capture::deallocate(cv::UMatData* u) const {
+    for (int i = 0; i < bufferCount; ++i) {
+        if (buffers[i].u.get() == u) {
+            buffers[i].held.store(false);
+            requeue(i);
+            return;
+        }
+    }
+    cv::Mat::getStdAllocator()->deallocate(u);
+}
@@ -0,0 +1,78 @@
+// ========================== Nguyen Hien ==========================
+// FILE: src/video_frame.cpp (Native-format frame: BGR or YUYV)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+#include "video_frame.h"
+
+VideoFrame::VideoFrame() : layout(PixelLayout::BGR), bgrValid(false) {}
+
+void VideoFrame::setBGR(const cv::Mat& bgr) {
+    layout = PixelLayout::BGR;
+    native = bgr;
+    bgrValid = false;
+}
+
+void VideoFrame::setYUYV(const cv::Mat& yuyv) {
+    layout = PixelLayout::YUYV;
+    native = yuyv;
+    // bgrCache keeps its buffer for the next conversion
+    bgrValid = false;
+}
+
+void VideoFrame::release() {
+    native.release();
+    bgrValid = false;
+}
+
+const cv::Mat& VideoFrame::bgr() const {
+    if (layout == PixelLayout::BGR) return native;
+    if (!bgrValid && !native.empty()) {
+        cv::cvtColor(native, bgrCache, cv::COLOR_YUV2BGR_YUYV);
+        bgrValid = true;
+    }
+    return bgrCache;
+}
+
+cv::Mat& VideoFrame::bgrForDrawing() {
+    bgr();
+    return layout == PixelLayout::BGR ? native : bgrCache;
+}
+
+void VideoFrame::gray(cv::Mat& out) const {
+    if (native.empty()) {
+        out.release();
+        return;
+    }
+    if (layout == PixelLayout::YUYV) cv::extractChannel(native, out, 0);
+    else cv::cvtColor(native, out, cv::COLOR_BGR2GRAY);
+}
+
+cv::Mat VideoFrame::nativeRegion(cv::Rect& region) const {
+    region &= cv::Rect(0, 0, native.cols, native.rows);
+    if (layout == PixelLayout::YUYV && region.area() > 0) {
+        // A U/V pair spans two pixels
+        int x0 = region.x & ~1;
+        int x1 = std::min(native.cols & ~1, (region.x + region.width + 1) & ~1);
+        region.x = x0;
+        region.width = std::max(0, x1 - x0);
+    }
+    if (region.area() <= 0) return cv::Mat();
+    return native(region);
+}
+
+void VideoFrame::bgrRegion(const cv::Rect& region, cv::Mat& out) const {
+    if (hasBGR()) {
+        out = bgr()(region & cv::Rect(0, 0, native.cols, native.rows));
+        return;
+    }
+    cv::Rect aligned = region;
+    cv::Mat src = nativeRegion(aligned);
+    if (src.empty()) {
+        out.release();
+        return;
+    }
+    cv::cvtColor(src, regionBuffer, cv::COLOR_YUV2BGR_YUYV);
+    cv::Rect inner = (region & cv::Rect(0, 0, native.cols, native.rows)) - aligned.tl();
+    out = regionBuffer(inner);
+}
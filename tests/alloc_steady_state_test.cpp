@@ -0,0 +1,93 @@
+// ========================== Nguyen Hien ==========================
+// FILE: tests/alloc_steady_state_test.cpp (Frame arena steady-state heap check)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+// Run:  ctest -R alloc_steady_state          (exit code 1 on failure)
+// Heap: cmake -DALLOC_DEBUG=ON, otherwise only the arena checks run
+//
+// Layer4Hybrid::analyzeQuality with its scratch bound to a FrameArena must not
+// touch the heap after warm-up. Not counted (AllocationCounter::Exclude): the
+// per-call working memory of cv::Sobel, cv::Laplacian, cv::Canny, cv::dft and
+// cv::resize. OpenCV runs single threaded here, parallel_for_ jobs allocate
+// on the pool threads.
+// =================================================================
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <iostream>
+#include "frame_arena.h"
+#include "layer4_hybrid.h"
+
+namespace {
+const int warmupFrames = 3;
+const int steadyFrames = 50;
+
+// Skin-toned patch with shading, two eyes and noise, so every cue has work to do
+cv::Mat makeFrame(int side, cv::Rect& box) {
+    cv::Mat frame(720, 1280, CV_8UC3, cv::Scalar(40, 40, 40));
+    box = cv::Rect((frame.cols - side) / 2, (frame.rows - side) / 2, side, side);
+    cv::Mat face = frame(box);
+    face.setTo(cv::Scalar(120, 150, 200));
+    cv::ellipse(face, cv::Point(side * 3 / 10, side * 2 / 5), cv::Size(side / 12, side / 20), 0, 0, 360, cv::Scalar(60, 50, 50), -1);
+    cv::ellipse(face, cv::Point(side * 7 / 10, side * 2 / 5), cv::Size(side / 12, side / 20), 0, 0, 360, cv::Scalar(60, 50, 50), -1);
+    cv::Mat noise(face.size(), CV_8UC3);
+    cv::RNG rng(12345);
+    rng.fill(noise, cv::RNG::NORMAL, cv::Scalar::all(0), cv::Scalar::all(6));
+    cv::add(face, noise, face, cv::noArray(), CV_8UC3);
+    return frame;
+}
+
+bool runSide(int side) {
+    Layer4Hybrid l4;
+    FrameArena arena;
+    l4.bindScratch(arena);
+    cv::Rect box;
+    cv::Mat frame = makeFrame(side, box);
+
+    // Spectral tables and vector capacities are sized once, outside the arena
+    for (int i = 0; i < warmupFrames; ++i) {
+        l4.analyzeQuality(frame, box);
+        arena.reset();
+    }
+
+    const uint64_t before = AllocationCounter::count();
+    for (int i = 0; i < steadyFrames; ++i) {
+        l4.analyzeQuality(frame, box);
+        arena.reset();
+    }
+    const uint64_t allocs = AllocationCounter::count() - before;
+
+    bool ok = true;
+    if (allocs > 0) {
+        std::cerr << "[Test] ERROR: side " << side << ": " << allocs << " heap allocations in "
+                  << steadyFrames << " steady-state frames" << std::endl;
+        ok = false;
+    }
+    if (arena.getFallbacks() > 0) {
+        std::cerr << "[Test] ERROR: side " << side << ": " << arena.getFallbacks()
+                  << " arena overflows to the heap" << std::endl;
+        ok = false;
+    }
+    if (arena.getUsed() != 0) {
+        std::cerr << "[Test] ERROR: side " << side << ": reset() left " << arena.getUsed()
+                  << " bytes in use" << std::endl;
+        ok = false;
+    }
+    std::cout << "[Test] INFO: side " << side << ": " << allocs << " heap allocations, arena high water "
+              << arena.getHighWater() / 1024 << " KiB" << (ok ? "" : " -> FAIL") << std::endl;
+    return ok;
+}
+}
+
+int main() {
+    cv::setNumThreads(0);
+    if (AllocationCounter::enabled()) {
+        AllocationCounter::install();
+    } else {
+        std::cout << "[Test] WARN: Heap counter off (configure with -DALLOC_DEBUG=ON), arena checks only" << std::endl;
+    }
+
+    bool ok = true;
+    for (int side : {64, 128, 256, 512}) ok = runSide(side) && ok;
+    return ok ? 0 : 1;
+}
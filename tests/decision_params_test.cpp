@@ -0,0 +1,204 @@
+// ========================== Nguyen Hien ==========================
+// FILE: tests/decision_params_test.cpp (DecisionParams load / validate / publish)
+// Developer: TRAN NGUYEN HIEN
+// Email: trannguyenhien29085@gmail.com
+// =================================================================
+// Run:  ctest -R decision_params          (exit code 1 on failure)
+//
+// load() and validate() gate every threshold change that reaches a site:
+// overrides only touch the keys they name, and anything that could break the
+// cascade bounds or the state machine is rejected with the running set kept.
+// Keys with an effect outside the fused scores (missing_frames) are checked
+// where they act.
+// =================================================================
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "decision_params.h"
+#include "frame_analyzer.h"
+
+namespace {
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (ok) return;
+    failures++;
+    std::cerr << "[Test] ERROR: " << what << std::endl;
+}
+
+bool sameParams(const DecisionParams& a, const DecisionParams& b) {
+    return std::memcmp(&a, &b, sizeof(DecisionParams)) == 0;
+}
+
+std::string writeFile(const std::string& name, const std::string& text) {
+    const std::string path = (std::filesystem::temp_directory_path() / ("face_decision_params_test_" + name)).string();
+    std::ofstream(path) << text;
+    return path;
+}
+
+// Loads text (as file name) into a set seeded with a marker, so a rejected
+// file can be checked for leaving out untouched
+bool loadText(const std::string& name, const std::string& text, DecisionParams& out) {
+    out = DecisionParams();
+    out.livenessReal = 0.71f;
+    const std::string path = writeFile(name, text);
+    bool ok = DecisionParams::load(path, out);
+    std::filesystem::remove(path);
+    return ok;
+}
+
+const char* yamlHeader = "%YAML:1.0\n---\n";
+
+void testValidate() {
+    const DecisionParams defaults;
+    check(defaults.validate().empty(), "defaults fail validate(): " + defaults.validate());
+
+    DecisionParams p;
+    p.livenessReal = 0.90f;   // above real_strong
+    check(!p.validate().empty(), "layer3 bands out of order accepted");
+
+    p = DecisionParams();
+    p.smoothLagBlend = 1.5f;
+    check(!p.validate().empty(), "smoothing.lag_blend 1.5 accepted");
+
+    p = DecisionParams();
+    p.weightMoire = -0.1f;
+    check(!p.validate().empty(), "negative fusion weight accepted");
+
+    p = DecisionParams();
+    p.livenessWeight = -1.0f;
+    check(!p.validate().empty(), "negative decision weight accepted");
+
+    p = DecisionParams();
+    p.adjustmentMin = p.adjustmentMax;
+    check(!p.validate().empty(), "adjustment_min == adjustment_max accepted");
+
+    p = DecisionParams();
+    p.penaltyStrong = 0.95f;   // weaker than penalty
+    check(!p.validate().empty(), "penalty_strong > penalty accepted");
+
+    p = DecisionParams();
+    p.penalty = 1.2f;
+    check(!p.validate().empty(), "penalty > 1 accepted");
+
+    p = DecisionParams();
+    p.penaltyStrongBelow = -0.30f;   // above penalty_below
+    check(!p.validate().empty(), "penalty_strong_below > penalty_below accepted");
+
+    p = DecisionParams();
+    p.edgeCannyLow = p.edgeCannyHigh;
+    check(!p.validate().empty(), "canny_low == canny_high accepted");
+
+    p = DecisionParams();
+    p.confirmFrames = 0;
+    check(!p.validate().empty(), "confirm_frames 0 accepted");
+}
+
+void testLoad() {
+    DecisionParams out;
+
+    // Only the named keys change, int keys parse as ints
+    check(loadText("partial.yml", std::string(yamlHeader) +
+                   "layer3:\n   real: 0.74\ndecision:\n   confirm_frames: 6\n   drop_cap: 0.3\n", out),
+          "valid YAML rejected");
+    DecisionParams expected;
+    expected.livenessReal = 0.74f;
+    expected.confirmFrames = 6;
+    expected.dropCap = 0.3f;
+    check(sameParams(out, expected), "YAML override touched more than its keys");
+
+    check(loadText("partial.json", "{ \"fusion\": { \"weight_skin\": 1.25 } }\n", out), "valid JSON rejected");
+    expected = DecisionParams();
+    expected.weightSkin = 1.25f;
+    check(sameParams(out, expected), "JSON override touched more than its keys");
+
+    check(loadText("empty.yml", std::string(yamlHeader) + "{}\n", out) && sameParams(out, DecisionParams()),
+          "empty file does not give the defaults");
+
+    // Every rejection leaves out as it was (marker livenessReal = 0.71)
+    struct Bad {
+        const char* name;
+        std::string text;
+    };
+    const Bad bad[] = {
+        {"unknown_key.yml", std::string(yamlHeader) + "layer3:\n   realish: 0.7\n"},
+        {"unknown_section.yml", std::string(yamlHeader) + "layer9:\n   real: 0.7\n"},
+        {"not_a_number.yml", std::string(yamlHeader) + "layer3:\n   real: high\n"},
+        {"not_a_section.yml", std::string(yamlHeader) + "real: 0.7\n"},
+        {"broken_order.yml", std::string(yamlHeader) + "layer3:\n   real: 0.9\n"},
+        {"negative_weight.json", "{ \"decision\": { \"adjustment_weight\": -0.25 } }\n"},
+        {"zero_frames.yml", std::string(yamlHeader) + "decision:\n   confirm_frames: 0\n"},
+    };
+    for (const Bad& b : bad) {
+        check(!loadText(b.name, b.text, out), std::string(b.name) + " accepted");
+        check(out.livenessReal == 0.71f, std::string(b.name) + " modified the output set");
+    }
+
+    DecisionParams untouched;
+    untouched.livenessReal = 0.71f;
+    out = untouched;
+    check(!DecisionParams::load("/nonexistent/face_decision.yml", out) && sameParams(out, untouched),
+          "missing file accepted or output modified");
+}
+
+void testSaveRoundTrip() {
+    DecisionParams params;
+    params.textureGradMid = 9.5f;
+    params.missingFrames = 12;
+    const std::string path = writeFile("roundtrip.yml", "");
+    check(DecisionParams::save(path, params), "save() failed");
+    DecisionParams loaded;
+    check(DecisionParams::load(path, loaded) && sameParams(loaded, params), "save() -> load() round trip differs");
+    std::filesystem::remove(path);
+}
+
+// missing_frames is the track expiry of FrameAnalyzer::prepare(): a face gone
+// for up to N frames keeps its track ID (and history), one frame more and it is new
+void testMissingFrames() {
+    DecisionParams params;
+    params.missingFrames = 3;
+    FrameAnalyzer analyzer;
+    std::vector<FaceResult> face(1);
+    face[0].bbox = cv::Rect(100, 100, 120, 120);
+    face[0].confidence = 0.9f;
+    const std::vector<FaceResult> none;
+    std::vector<FaceAnalysis> results;
+
+    auto absentThenBack = [&](int absent) {
+        analyzer.prepare(face, results, params);
+        const int id = results[0].trackId;
+        for (int i = 0; i < absent; ++i) analyzer.prepare(none, results, params);
+        analyzer.prepare(face, results, params);
+        return results[0].trackId == id;
+    };
+    check(absentThenBack(3), "track expired after missing_frames absent frames");
+    check(!absentThenBack(4), "track kept after missing_frames + 1 absent frames");
+}
+
+void testPublish() {
+    const uint32_t before = DecisionParams::generation();
+    const DecisionParams& old = DecisionParams::current();
+    DecisionParams next;
+    next.confirmFrames = 5;
+    DecisionParams::publish(next);
+    check(DecisionParams::generation() == before + 1, "publish() did not bump the generation");
+    check(DecisionParams::current().confirmFrames == 5, "publish() did not make the set current");
+    check(old.confirmFrames == DecisionParams().confirmFrames, "publish() modified a set a reader still holds");
+}
+}
+
+int main() {
+    testValidate();
+    testLoad();
+    testSaveRoundTrip();
+    testMissingFrames();
+    testPublish();
+    if (failures > 0) {
+        std::cerr << "[Test] ERROR: " << failures << " decision params checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "[Test] INFO: Decision params checks passed" << std::endl;
+    return 0;
+}